@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "cache_index.hpp"
+#include <cstring>
+
+namespace reshade
+{
+	namespace
+	{
+		// The usage order is the magic number, the version and the number of keys (each 32-bit), followed by the 64-bit keys, most recently used first
+		template <typename T>
+		inline void write(std::string &stream, const T &value)
+		{
+			stream.append(reinterpret_cast<const char *>(&value), sizeof(T));
+		}
+		template <typename T>
+		inline bool read(const std::string &stream, size_t &offset, T &value)
+		{
+			if (stream.size() - offset < sizeof(T))
+			{
+				return false;
+			}
+
+			std::memcpy(&value, stream.data() + offset, sizeof(T));
+			offset += sizeof(T);
+
+			return true;
+		}
+	}
+
+	void cache_index::restore(const std::vector<std::pair<uint64_t, size_t>> &entries, const std::string &order, uint32_t magic, uint32_t version)
+	{
+		clear();
+
+		std::unordered_map<uint64_t, size_t> sizes;
+
+		for (const auto &entry : entries)
+		{
+			sizes.insert(entry);
+		}
+
+		size_t offset = 0;
+		uint32_t order_magic = 0, order_version = 0, count = 0;
+
+		if (read(order, offset, order_magic) && order_magic == magic &&
+			read(order, offset, order_version) && order_version == version &&
+			read(order, offset, count))
+		{
+			for (uint64_t key; count-- != 0 && read(order, offset, key);)
+			{
+				const auto it = sizes.find(key);
+
+				if (it != sizes.end() && _lookup.count(key) == 0)
+				{
+					_lookup.emplace(key, _entries.insert(_entries.end(), { key, it->second }));
+					_total_size += it->second;
+				}
+			}
+		}
+
+		for (const auto &size : sizes)
+		{
+			if (_lookup.count(size.first) == 0)
+			{
+				_lookup.emplace(size.first, _entries.insert(_entries.end(), { size.first, size.second }));
+				_total_size += size.second;
+			}
+		}
+	}
+	void cache_index::clear()
+	{
+		_total_size = 0;
+		_is_order_modified = false;
+		_entries.clear();
+		_lookup.clear();
+	}
+
+	void cache_index::touch(uint64_t key)
+	{
+		const auto it = _lookup.find(key);
+
+		if (it == _lookup.end() || it->second == _entries.begin())
+		{
+			return;
+		}
+
+		_entries.splice(_entries.begin(), _entries, it->second);
+		_is_order_modified = true;
+	}
+	void cache_index::insert(uint64_t key, size_t size)
+	{
+		forget(key);
+
+		_lookup.emplace(key, _entries.insert(_entries.begin(), { key, size }));
+		_total_size += size;
+		_is_order_modified = true;
+	}
+	void cache_index::forget(uint64_t key)
+	{
+		const auto it = _lookup.find(key);
+
+		if (it == _lookup.end())
+		{
+			return;
+		}
+
+		_total_size -= it->second->size;
+		_entries.erase(it->second);
+		_lookup.erase(it);
+		_is_order_modified = true;
+	}
+
+	std::string cache_index::save_order(uint32_t magic, uint32_t version)
+	{
+		std::string order;
+		order.reserve(3 * sizeof(uint32_t) + _entries.size() * sizeof(uint64_t));
+
+		write(order, magic);
+		write(order, version);
+		write(order, static_cast<uint32_t>(_entries.size()));
+
+		for (const auto &entry : _entries)
+		{
+			write(order, entry.key);
+		}
+
+		_is_order_modified = false;
+
+		return order;
+	}
+}
@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace reshade
+{
+	/// <summary>
+	/// The keys and sizes of the entries of a persistent cache in the order they were last used, which the shader and texture caches evict their entries by.
+	/// This only does the bookkeeping, the caches store the entries themselves. It is not thread-safe.
+	/// </summary>
+	class cache_index
+	{
+	public:
+		/// <summary>
+		/// Replace all entries with those found in the storage of a cache.
+		/// </summary>
+		/// <param name="entries">The keys and sizes in bytes of all stored entries.</param>
+		/// <param name="order">The usage order saved by <see cref="save_order"/> in a previous run, or an empty string. Entries it does not know about are considered the oldest.</param>
+		/// <param name="magic">The magic number the usage order was saved with.</param>
+		/// <param name="version">The version number the usage order was saved with. An order saved with a different version is ignored.</param>
+		void restore(const std::vector<std::pair<uint64_t, size_t>> &entries, const std::string &order, uint32_t magic, uint32_t version);
+		/// <summary>
+		/// Remove all entries.
+		/// </summary>
+		void clear();
+
+		/// <summary>
+		/// Returns the total size of all entries in bytes.
+		/// </summary>
+		size_t total_size() const { return _total_size; }
+		/// <summary>
+		/// Returns a boolean value indicating whether there is an entry for a key.
+		/// </summary>
+		bool contains(uint64_t key) const { return _lookup.count(key) != 0; }
+
+		/// <summary>
+		/// Mark an existing entry as the most recently used one.
+		/// </summary>
+		void touch(uint64_t key);
+		/// <summary>
+		/// Add or replace an entry and mark it as the most recently used one.
+		/// </summary>
+		/// <param name="key">The key of the entry.</param>
+		/// <param name="size">The size of the entry in bytes.</param>
+		void insert(uint64_t key, size_t size);
+		/// <summary>
+		/// Remove an entry, if there is one for a key.
+		/// </summary>
+		void forget(uint64_t key);
+		/// <summary>
+		/// Remove the least recently used entries until the total size is within a limit. The most recently used entry is always kept, even if it alone exceeds the limit.
+		/// </summary>
+		/// <param name="size_limit">The limit for the total size in bytes.</param>
+		/// <param name="remove">Called with the key of every removed entry, to delete it from the storage.</param>
+		template <typename F>
+		void evict(size_t size_limit, F remove)
+		{
+			while (_total_size > size_limit && _entries.size() > 1)
+			{
+				const entry &oldest = _entries.back();
+
+				remove(oldest.key);
+
+				_total_size -= oldest.size;
+				_lookup.erase(oldest.key);
+				_entries.pop_back();
+				_is_order_modified = true;
+			}
+		}
+
+		/// <summary>
+		/// Returns a boolean value indicating whether the usage order changed since it was last saved or restored.
+		/// </summary>
+		bool is_order_modified() const { return _is_order_modified; }
+		/// <summary>
+		/// Serialize the current usage order, so that the next run can pass it to <see cref="restore"/>.
+		/// </summary>
+		/// <param name="magic">A magic number identifying the cache.</param>
+		/// <param name="version">The version of the cache format.</param>
+		std::string save_order(uint32_t magic, uint32_t version);
+
+	private:
+		struct entry
+		{
+			uint64_t key;
+			size_t size;
+		};
+
+		size_t _total_size = 0;
+		bool _is_order_modified = false;
+		std::list<entry> _entries; // Most recently used first
+		std::unordered_map<uint64_t, std::list<entry>::iterator> _lookup;
+	};
+}
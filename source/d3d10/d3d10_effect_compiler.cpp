@@ -3,8 +3,11 @@
  * License: https://github.com/crosire/reshade#license
  */
 
+#include "log.hpp"
+#include "profiler.hpp"
 #include "d3d10_runtime.hpp"
 #include "d3d10_effect_compiler.hpp"
+#include "shader_cache_directory.hpp"
 #include <assert.h>
 #include <iomanip>
 #include <algorithm>
@@ -15,10 +18,6 @@ namespace reshade::d3d10
 	using namespace reshadefx;
 	using namespace reshadefx::nodes;
 
-	static inline size_t roundto16(size_t size)
-	{
-		return (size + 15) & ~15;
-	}
 	static D3D10_BLEND literal_to_blend_func(unsigned int value)
 	{
 		switch (value)
@@ -201,6 +200,8 @@ namespace reshade::d3d10
 
 	bool d3d10_effect_compiler::run()
 	{
+		const profiler::zone profile_zone("generate_code");
+
 		_d3dcompiler_module = LoadLibraryW(L"d3dcompiler_47.dll");
 
 		if (_d3dcompiler_module == nullptr)
@@ -213,14 +214,43 @@ namespace reshade::d3d10
 			return false;
 		}
 
+		_d3dcompiler_version = shader_cache_directory::compiler_version(_d3dcompiler_module);
+
 		_uniform_storage_offset = _runtime->get_uniform_value_storage().size();
 
+		// Lay out all uniforms up front, so that the storage is only resized once and the packer is free to reorder them
+		for (auto uniform : _ast.variables)
+		{
+			if (!uniform->type.is_texture() && !uniform->type.is_sampler() && uniform->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				_uniform_layout.add(uniform->type.rows, uniform->type.cols, std::max(0, uniform->type.array_length));
+			}
+		}
+
+		_uniform_layout.pack();
+
+		_constant_buffer_size = _uniform_layout.size();
+		_runtime->get_uniform_value_storage().resize(_uniform_storage_offset + _constant_buffer_size);
+
+		if (_constant_buffer_size != 0)
+		{
+			LOG(INFO) << "> Packed uniforms into " << _constant_buffer_size << " bytes, " << _uniform_layout.padding() << " of which are padding.";
+		}
+
+		// Remember where each global declaration starts, so that shaders can pick only those they need later on
 		for (auto node : _ast.structs)
 		{
+			_global_declarations.push_back({ node, static_cast<size_t>(_global_code.tellp()) });
+
 			visit(_global_code, node);
 		}
+
+		size_t uniform_index = 0;
+
 		for (auto uniform : _ast.variables)
 		{
+			_global_declarations.push_back({ uniform, static_cast<size_t>(_global_code.tellp()) });
+
 			if (uniform->type.is_texture())
 			{
 				visit_texture(uniform);
@@ -231,7 +261,7 @@ namespace reshade::d3d10
 			}
 			else if (uniform->type.has_qualifier(type_node::qualifier_uniform))
 			{
-				visit_uniform(uniform);
+				visit_uniform(uniform, uniform_index++);
 			}
 			else
 			{
@@ -242,6 +272,8 @@ namespace reshade::d3d10
 		}
 		for (auto function : _ast.functions)
 		{
+			_global_declarations.push_back({ function, static_cast<size_t>(_global_code.tellp()) });
+
 			visit(_global_code, function);
 		}
 		for (auto technique : _ast.techniques)
@@ -251,11 +283,8 @@ namespace reshade::d3d10
 
 		if (_constant_buffer_size != 0)
 		{
-			_constant_buffer_size = roundto16(_constant_buffer_size);
-			_runtime->get_uniform_value_storage().resize(_uniform_storage_offset + _constant_buffer_size);
-
 			const CD3D10_BUFFER_DESC globals_desc(static_cast<UINT>(_constant_buffer_size), D3D10_BIND_CONSTANT_BUFFER, D3D10_USAGE_DYNAMIC, D3D10_CPU_ACCESS_WRITE);
-			const D3D10_SUBRESOURCE_DATA globals_initial = { _runtime->get_uniform_value_storage().data(), static_cast<UINT>(_constant_buffer_size) };
+			const D3D10_SUBRESOURCE_DATA globals_initial = { _runtime->get_uniform_value_storage().data() + _uniform_storage_offset, static_cast<UINT>(_constant_buffer_size) };
 
 			com_ptr<ID3D10Buffer> constant_buffer;
 			_runtime->_device->CreateBuffer(&globals_desc, &globals_initial, &constant_buffer);
@@ -265,6 +294,11 @@ namespace reshade::d3d10
 
 		FreeLibrary(_d3dcompiler_module);
 
+		if (const size_t reused_count = _vertex_shaders.reused_count() + _pixel_shaders.reused_count())
+		{
+			LOG(INFO) << "> Reused " << reused_count << " shaders across passes instead of compiling them again.";
+		}
+
 		return _success;
 	}
 
@@ -1688,7 +1722,7 @@ namespace reshade::d3d10
 
 		_global_code << ", __SamplerState" << it->second << " };\n";
 	}
-	void d3d10_effect_compiler::visit_uniform(const variable_declaration_node *node)
+	void d3d10_effect_compiler::visit_uniform(const variable_declaration_node *node, size_t index)
 	{
 		visit(_global_uniforms, node->type);
 
@@ -1706,7 +1740,9 @@ namespace reshade::d3d10
 			_global_uniforms << ']';
 		}
 
-		_global_uniforms << ";\n";
+		const size_t offset = _uniform_layout.offset(index);
+
+		_global_uniforms << " : packoffset(c" << (offset / 16) << '.' << "xyzw"[(offset % 16) / 4] << ");\n";
 
 		uniform obj;
 		obj.name = node->name;
@@ -1718,24 +1754,12 @@ namespace reshade::d3d10
 		obj.storage_size = node->type.rows * node->type.cols * std::max(1u, obj.elements) * 4;
 		obj.annotations = node->annotation_list;
 
-		const UINT alignment = 16 - (_constant_buffer_size % 16);
-		_constant_buffer_size += static_cast<UINT>((obj.storage_size > alignment && (alignment != 16 || obj.storage_size <= 16)) ? obj.storage_size + alignment : obj.storage_size);
-		obj.storage_offset = _uniform_storage_offset + _constant_buffer_size - obj.storage_size;
-
-		auto &uniform_storage = _runtime->get_uniform_value_storage();
-
-		if (_uniform_storage_offset + _constant_buffer_size >= uniform_storage.size())
-		{
-			uniform_storage.resize(uniform_storage.size() + 128);
-		}
+		obj.storage_offset = _uniform_storage_offset + offset;
 
+		// The storage was already resized and zero-initialized in 'run', so only explicit initializers need to be copied
 		if (node->initializer_expression != nullptr && node->initializer_expression->id == nodeid::literal_expression)
 		{
-			CopyMemory(uniform_storage.data() + obj.storage_offset, &static_cast<const literal_expression_node *>(node->initializer_expression)->value_float, obj.storage_size);
-		}
-		else
-		{
-			ZeroMemory(uniform_storage.data() + obj.storage_offset, obj.storage_size);
+			CopyMemory(_runtime->get_uniform_value_storage().data() + obj.storage_offset, &static_cast<const literal_expression_node *>(node->initializer_expression)->value_float, obj.storage_size);
 		}
 
 		_runtime->add_uniform(std::move(obj));
@@ -1990,37 +2014,69 @@ namespace reshade::d3d10
 			source += "SamplerState __SamplerState" + std::to_string(samplerdesc.second) + " : register(s" + std::to_string(samplerdesc.second) + ");\n";
 		}
 
-		source += _global_code.str();
+		// Only include the global declarations this entry point actually uses, so that the compiler does not have to parse and strip all the others
+		const std::string global_code = _global_code.str();
+		const std::string used_global_code = extract_dependencies(node, global_code, _global_declarations);
+
+		LOG(INFO) << "> Shader '" << node->name << "' uses " << used_global_code.size() << " of " << global_code.size() << " bytes of global code.";
+
+		source += used_global_code;
 
 		UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
-		com_ptr<ID3DBlob> compiled, errors;
+		std::string bytecode;
 
 		if (_skip_shader_optimization)
 		{
 			flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 		}
 
-		const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
-		HRESULT hr = D3DCompile(source.c_str(), source.length(), nullptr, nullptr, nullptr, node->unique_name.c_str(), profile.c_str(), flags, 0, &compiled, &errors);
+		const uint64_t shader_key = shader_cache::key(_d3dcompiler_version, source, node->unique_name, profile, flags);
 
-		if (errors != nullptr)
+		if ((shadertype == "vs" && _vertex_shaders.find(shader_key, pass.vertex_shader)) ||
+			(shadertype == "ps" && _pixel_shaders.find(shader_key, pass.pixel_shader)))
 		{
-			_errors.append(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
+			return;
 		}
 
-		if (FAILED(hr))
+		// Only invoke the compiler if the exact same shader was not compiled in a previous run already
+		const bool success = _runtime->get_shader_cache().compile(_d3dcompiler_version, source, node->unique_name, profile, flags, bytecode, _errors, [this, &source, node, &profile, flags](std::string &result, std::string &messages) {
+			const profiler::zone profile_zone("compile_shader", node->unique_name);
+
+			com_ptr<ID3DBlob> compiled, errors;
+
+			const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
+			const HRESULT hr = D3DCompile(source.c_str(), source.length(), nullptr, nullptr, nullptr, node->unique_name.c_str(), profile.c_str(), flags, 0, &compiled, &errors);
+
+			if (errors != nullptr)
+			{
+				messages.assign(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
+			}
+
+			if (FAILED(hr))
+			{
+				return false;
+			}
+
+			result.assign(static_cast<const char *>(compiled->GetBufferPointer()), compiled->GetBufferSize());
+
+			return true;
+		});
+
+		if (!success)
 		{
 			error(node->location, "internal shader compilation failed");
 			return;
 		}
 
+		HRESULT hr = S_OK;
+
 		if (shadertype == "vs")
 		{
-			hr = _runtime->_device->CreateVertexShader(compiled->GetBufferPointer(), compiled->GetBufferSize(), &pass.vertex_shader);
+			hr = _runtime->_device->CreateVertexShader(bytecode.data(), bytecode.size(), &pass.vertex_shader);
 		}
 		else if (shadertype == "ps")
 		{
-			hr = _runtime->_device->CreatePixelShader(compiled->GetBufferPointer(), compiled->GetBufferSize(), &pass.pixel_shader);
+			hr = _runtime->_device->CreatePixelShader(bytecode.data(), bytecode.size(), &pass.pixel_shader);
 		}
 
 		if (FAILED(hr))
@@ -2028,5 +2084,14 @@ namespace reshade::d3d10
 			error(node->location, "'CreateShader' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
 			return;
 		}
+
+		if (shadertype == "vs")
+		{
+			_vertex_shaders.insert(shader_key, pass.vertex_shader);
+		}
+		else if (shadertype == "ps")
+		{
+			_pixel_shaders.insert(shader_key, pass.pixel_shader);
+		}
 	}
 }
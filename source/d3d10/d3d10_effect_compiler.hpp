@@ -6,6 +6,9 @@
 #pragma once
 
 #include "effect_syntax_tree.hpp"
+#include "effect_dependencies.hpp"
+#include "uniform_layout.hpp"
+#include "shader_reuse_table.hpp"
 #include <sstream>
 
 namespace reshade::d3d10
@@ -58,7 +61,7 @@ namespace reshade::d3d10
 
 		void visit_texture(const reshadefx::nodes::variable_declaration_node *node);
 		void visit_sampler(const reshadefx::nodes::variable_declaration_node *node);
-		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node);
+		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node, size_t index);
 		void visit_technique(const reshadefx::nodes::technique_declaration_node *node);
 		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, d3d10_pass_data &pass);
 		void visit_pass_shader(const reshadefx::nodes::function_declaration_node *node, const std::string &shadertype, d3d10_pass_data &pass);
@@ -68,8 +71,13 @@ namespace reshade::d3d10
 		const reshadefx::syntax_tree &_ast;
 		std::string &_errors;
 		std::stringstream _global_code, _global_uniforms;
+		std::vector<reshadefx::global_declaration> _global_declarations;
 		bool _skip_shader_optimization, _is_in_parameter_block = false, _is_in_function_block = false;
 		size_t _uniform_storage_offset = 0, _constant_buffer_size = 0;
+		uniform_layout _uniform_layout { uniform_layout::packing_rules::hlsl_cbuffer };
 		HMODULE _d3dcompiler_module = nullptr;
+		std::string _d3dcompiler_version;
+		shader_reuse_table<com_ptr<ID3D10VertexShader>> _vertex_shaders;
+		shader_reuse_table<com_ptr<ID3D10PixelShader>> _pixel_shaders;
 	};
 }
@@ -10,6 +10,7 @@
 #include "input.hpp"
 #include "dllmodule.hpp"
 #include "resource_loading.hpp"
+#include "texel_conversion.hpp"
 #include <imgui.h>
 #include <algorithm>
 
@@ -787,20 +788,19 @@ namespace reshade::d3d10
 		auto mapped_data = static_cast<BYTE *>(mapped.pData);
 		const UINT pitch = texture_desc.Width * 4;
 
+		const bool is_bgra = _backbuffer_format == DXGI_FORMAT_B8G8R8A8_UNORM || _backbuffer_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+
 		for (UINT y = 0; y < texture_desc.Height; y++)
 		{
-			CopyMemory(buffer, mapped_data, std::min(pitch, static_cast<UINT>(mapped.RowPitch)));
-			
-			for (UINT x = 0; x < pitch; x += 4)
+			if (is_bgra)
 			{
-				buffer[x + 3] = 0xFF;
-
-				if (_backbuffer_format == DXGI_FORMAT_B8G8R8A8_UNORM || _backbuffer_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB)
-				{
-					std::swap(buffer[x + 0], buffer[x + 2]);
-				}
+				texel_conversion::swap_red_blue(buffer, mapped_data, texture_desc.Width, 0xFFFFFFFF, 0xFF000000);
 			}
-								
+			else
+			{
+				texel_conversion::fill_alpha(buffer, mapped_data, texture_desc.Width);
+			}
+
 			buffer += pitch;
 			mapped_data += mapped.RowPitch;
 		}
@@ -827,19 +827,23 @@ namespace reshade::d3d10
 		{
 			case texture_format::r8:
 			{
-				std::vector<uint8_t> data2(texture.width * texture.height);
-				for (size_t i = 0, k = 0; i < texture.width * texture.height * 4; i += 4, k++)
-					data2[k] = data[i];
-				_device->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, data2.data(), texture.width, texture.width * texture.height);
+				_texture_upload_buffer.resize(texture.width * texture.height);
+				texel_conversion::extract_r(_texture_upload_buffer.data(), data, texture.width * texture.height);
+				_device->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, _texture_upload_buffer.data(), texture.width, texture.width * texture.height);
 				break;
 			}
 			case texture_format::rg8:
 			{
-				std::vector<uint8_t> data2(texture.width * texture.height * 2);
-				for (size_t i = 0, k = 0; i < texture.width * texture.height * 4; i += 4, k += 2)
-					data2[k] = data[i],
-					data2[k + 1] = data[i + 1];
-				_device->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, data2.data(), texture.width * 2, texture.width * texture.height * 2);
+				_texture_upload_buffer.resize(texture.width * texture.height * 2);
+				texel_conversion::extract_rg(_texture_upload_buffer.data(), data, texture.width * texture.height);
+				_device->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, _texture_upload_buffer.data(), texture.width * 2, texture.width * texture.height * 2);
+				break;
+			}
+			case texture_format::rgba16f:
+			{
+				_texture_upload_buffer.resize(texture.width * texture.height * 8);
+				texel_conversion::unorm8_to_float16(reinterpret_cast<uint16_t *>(_texture_upload_buffer.data()), data, texture.width * texture.height * 4);
+				_device->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, _texture_upload_buffer.data(), texture.width * 8, texture.width * texture.height * 8);
 				break;
 			}
 			default:
@@ -872,22 +876,32 @@ namespace reshade::d3d10
 		// Setup shader constants
 		if (technique.uniform_storage_index >= 0)
 		{
-			void *data = nullptr;
 			D3D10_BUFFER_DESC desc = { };
 			const auto constant_buffer = _constant_buffers[technique.uniform_storage_index].get();
 
 			constant_buffer->GetDesc(&desc);
-			const HRESULT hr = constant_buffer->Map(D3D10_MAP_WRITE_DISCARD, 0, &data);
 
-			if (SUCCEEDED(hr))
+			// Techniques of the same effect share a constant buffer, so only upload it if any of its values changed since the last upload
+			if (is_uniform_storage_dirty(technique.uniform_storage_offset, desc.ByteWidth))
 			{
-				CopyMemory(data, get_uniform_value_storage().data() + technique.uniform_storage_offset, desc.ByteWidth);
+				void *data = nullptr;
 
-				constant_buffer->Unmap();
-			}
-			else
-			{
-				LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
+				const HRESULT hr = constant_buffer->Map(D3D10_MAP_WRITE_DISCARD, 0, &data);
+
+				if (SUCCEEDED(hr))
+				{
+					CopyMemory(data, get_uniform_value_storage().data() + technique.uniform_storage_offset, desc.ByteWidth);
+
+					constant_buffer->Unmap();
+
+					clear_uniform_storage_dirty(technique.uniform_storage_offset, desc.ByteWidth);
+
+					_uniform_bytes_uploaded += desc.ByteWidth;
+				}
+				else
+				{
+					LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
+				}
 			}
 
 			_device->VSSetConstantBuffers(0, 1, &constant_buffer);
@@ -7,6 +7,49 @@
 #include "d3d11_device.hpp"
 #include "d3d11_device_context.hpp"
 #include "dllmodule.hpp"
+#include <algorithm>
+
+// Private data attached to command lists, holding the number of draw calls and vertices recorded into them, followed by the draw calls per depth stencil view
+static const GUID s_draw_call_count_guid = { 0xb5e1f3a2, 0x6c4d, 0x4f0e, { 0x9a, 0x21, 0x7d, 0x3e, 0x58, 0xc4, 0x12, 0x6b } };
+
+void D3D11DeviceContext::on_draw_call(UINT vertices)
+{
+	if (_is_deferred)
+	{
+		// Deferred contexts may record on any thread, so count locally and only merge the counts when the command list is executed
+		_vertices += vertices;
+		_drawcalls += 1;
+
+		add_deferred_draws(_depthstencil, _drawcalls, vertices);
+	}
+	else
+	{
+		for (auto runtime : _device->_runtimes)
+		{
+			runtime->on_draw_call(_depthstencil, vertices);
+		}
+	}
+}
+void D3D11DeviceContext::add_deferred_draws(ID3D11DepthStencilView *depthstencil, UINT last_drawcall, UINT vertices)
+{
+	if (depthstencil == nullptr)
+	{
+		return;
+	}
+
+	// Applications tend to draw to the same view many times in a row, so search from the back
+	auto it = std::find_if(_depthstencil_draws.rbegin(), _depthstencil_draws.rend(),
+		[depthstencil](const reshade::d3d11::deferred_depthstencil_draws &draws) { return draws.depthstencil == depthstencil; });
+
+	if (it == _depthstencil_draws.rend())
+	{
+		_depthstencil_draws.push_back({ depthstencil, 0, 0 });
+		it = _depthstencil_draws.rbegin();
+	}
+
+	it->last_drawcall = last_drawcall;
+	it->vertices += vertices;
+}
 
 // ID3D11DeviceContext
 HRESULT STDMETHODCALLTYPE D3D11DeviceContext::QueryInterface(REFIID riid, void **ppvObj)
@@ -163,19 +206,13 @@ void STDMETHODCALLTYPE D3D11DeviceContext::VSSetShader(ID3D11VertexShader *pVert
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation)
 {
-	for (auto runtime : _device->_runtimes)
-	{
-		runtime->on_draw_call(_orig, IndexCount);
-	}
+	on_draw_call(IndexCount);
 
 	_orig->DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::Draw(UINT VertexCount, UINT StartVertexLocation)
 {
-	for (auto runtime : _device->_runtimes)
-	{
-		runtime->on_draw_call(_orig, VertexCount);
-	}
+	on_draw_call(VertexCount);
 
 	_orig->Draw(VertexCount, StartVertexLocation);
 }
@@ -205,19 +242,13 @@ void STDMETHODCALLTYPE D3D11DeviceContext::IASetIndexBuffer(ID3D11Buffer *pIndex
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation)
 {
-	for (auto runtime : _device->_runtimes)
-	{
-		runtime->on_draw_call(_orig, IndexCountPerInstance * InstanceCount);
-	}
+	on_draw_call(IndexCountPerInstance * InstanceCount);
 
 	_orig->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation)
 {
-	for (auto runtime : _device->_runtimes)
-	{
-		runtime->on_draw_call(_orig, VertexCountPerInstance * InstanceCount);
-	}
+	on_draw_call(VertexCountPerInstance * InstanceCount);
 
 	_orig->DrawInstanced(VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
 }
@@ -267,6 +298,8 @@ void STDMETHODCALLTYPE D3D11DeviceContext::GSSetSamplers(UINT StartSlot, UINT Nu
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::OMSetRenderTargets(UINT NumViews, ID3D11RenderTargetView *const *ppRenderTargetViews, ID3D11DepthStencilView *pDepthStencilView)
 {
+	_depthstencil = pDepthStencilView;
+
 	if (pDepthStencilView != nullptr)
 	{
 		for (auto runtime : _device->_runtimes)
@@ -279,6 +312,11 @@ void STDMETHODCALLTYPE D3D11DeviceContext::OMSetRenderTargets(UINT NumViews, ID3
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::OMSetRenderTargetsAndUnorderedAccessViews(UINT NumRTVs, ID3D11RenderTargetView *const *ppRenderTargetViews, ID3D11DepthStencilView *pDepthStencilView, UINT UAVStartSlot, UINT NumUAVs, ID3D11UnorderedAccessView *const *ppUnorderedAccessViews, const UINT *pUAVInitialCounts)
 {
+	if (NumRTVs != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+	{
+		_depthstencil = pDepthStencilView;
+	}
+
 	if (pDepthStencilView != nullptr)
 	{
 		for (auto runtime : _device->_runtimes)
@@ -393,7 +431,43 @@ void STDMETHODCALLTYPE D3D11DeviceContext::ResolveSubresource(ID3D11Resource *pD
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::ExecuteCommandList(ID3D11CommandList *pCommandList, BOOL RestoreContextState)
 {
+	UINT size = 0;
+
+	if (pCommandList != nullptr && SUCCEEDED(pCommandList->GetPrivateData(s_draw_call_count_guid, &size, nullptr)) && size >= 2 * sizeof(UINT))
+	{
+		std::vector<uint8_t> data(size);
+		pCommandList->GetPrivateData(s_draw_call_count_guid, &size, data.data());
+
+		const auto counts = reinterpret_cast<const UINT *>(data.data());
+		const auto draws = reinterpret_cast<const reshade::d3d11::deferred_depthstencil_draws *>(data.data() + 2 * sizeof(UINT));
+		const size_t draw_count = (size - 2 * sizeof(UINT)) / sizeof(reshade::d3d11::deferred_depthstencil_draws);
+
+		if (_is_deferred)
+		{
+			for (size_t i = 0; i < draw_count; ++i)
+			{
+				add_deferred_draws(draws[i].depthstencil, _drawcalls + draws[i].last_drawcall, draws[i].vertices);
+			}
+
+			_drawcalls += counts[0];
+			_vertices += counts[1];
+		}
+		else
+		{
+			for (auto runtime : _device->_runtimes)
+			{
+				runtime->on_execute_command_list(counts[0], counts[1], draws, draw_count);
+			}
+		}
+	}
+
 	_orig->ExecuteCommandList(pCommandList, RestoreContextState);
+
+	// Executing a command list without restoring the state leaves the context in its default state
+	if (!RestoreContextState)
+	{
+		_depthstencil = nullptr;
+	}
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::HSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *const *ppShaderResourceViews)
 {
@@ -618,6 +692,8 @@ void STDMETHODCALLTYPE D3D11DeviceContext::CSGetConstantBuffers(UINT StartSlot,
 void STDMETHODCALLTYPE D3D11DeviceContext::ClearState()
 {
 	_orig->ClearState();
+
+	_depthstencil = nullptr;
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::Flush()
 {
@@ -629,7 +705,27 @@ UINT STDMETHODCALLTYPE D3D11DeviceContext::GetContextFlags()
 }
 HRESULT STDMETHODCALLTYPE D3D11DeviceContext::FinishCommandList(BOOL RestoreDeferredContextState, ID3D11CommandList **ppCommandList)
 {
-	return _orig->FinishCommandList(RestoreDeferredContextState, ppCommandList);
+	const HRESULT hr = _orig->FinishCommandList(RestoreDeferredContextState, ppCommandList);
+
+	if (SUCCEEDED(hr))
+	{
+		const UINT counts[2] = { _drawcalls, _vertices };
+		std::vector<uint8_t> data(sizeof(counts) + _depthstencil_draws.size() * sizeof(reshade::d3d11::deferred_depthstencil_draws));
+		std::memcpy(data.data(), counts, sizeof(counts));
+		std::memcpy(data.data() + sizeof(counts), _depthstencil_draws.data(), _depthstencil_draws.size() * sizeof(reshade::d3d11::deferred_depthstencil_draws));
+
+		(*ppCommandList)->SetPrivateData(s_draw_call_count_guid, static_cast<UINT>(data.size()), data.data());
+	}
+
+	_drawcalls = _vertices = 0;
+	_depthstencil_draws.clear();
+
+	if (!RestoreDeferredContextState)
+	{
+		_depthstencil = nullptr;
+	}
+
+	return hr;
 }
 D3D11_DEVICE_CONTEXT_TYPE STDMETHODCALLTYPE D3D11DeviceContext::GetType()
 {
@@ -738,6 +834,11 @@ void STDMETHODCALLTYPE D3D11DeviceContext::SwapDeviceContextState(ID3DDeviceCont
 	assert(_interface_version >= 1);
 
 	static_cast<ID3D11DeviceContext1 *>(_orig)->SwapDeviceContextState(pState, ppPreviousState);
+
+	// The new state may have any depth stencil view bound, so look it up once (and map a replacement back to the original, like the application would see it)
+	com_ptr<ID3D11DepthStencilView> depthstencil;
+	OMGetRenderTargets(0, nullptr, &depthstencil);
+	_depthstencil = depthstencil.get();
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::ClearView(ID3D11View *pView, const FLOAT Color[4], const D3D11_RECT *pRect, UINT NumRects)
 {
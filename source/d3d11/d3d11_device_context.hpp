@@ -12,19 +12,23 @@ struct D3D11DeviceContext : ID3D11DeviceContext3
 	D3D11DeviceContext(D3D11Device *device, ID3D11DeviceContext  *original) :
 		_orig(original),
 		_interface_version(0),
-		_device(device) { }
+		_device(device),
+		_is_deferred(original->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED) { }
 	D3D11DeviceContext(D3D11Device *device, ID3D11DeviceContext1 *original) :
 		_orig(original),
 		_interface_version(1),
-		_device(device) { }
+		_device(device),
+		_is_deferred(original->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED) { }
 	D3D11DeviceContext(D3D11Device *device, ID3D11DeviceContext2 *original) :
 		_orig(original),
 		_interface_version(2),
-		_device(device) { }
+		_device(device),
+		_is_deferred(original->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED) { }
 	D3D11DeviceContext(D3D11Device *device, ID3D11DeviceContext3 *original) :
 		_orig(original),
 		_interface_version(3),
-		_device(device) { }
+		_device(device),
+		_is_deferred(original->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED) { }
 
 	D3D11DeviceContext(const D3D11DeviceContext &) = delete;
 	D3D11DeviceContext &operator=(const D3D11DeviceContext &) = delete;
@@ -189,8 +193,15 @@ struct D3D11DeviceContext : ID3D11DeviceContext3
 	virtual void STDMETHODCALLTYPE GetHardwareProtectionState(BOOL *pHwProtectionEnable) override;
 	#pragma endregion
 
+	void on_draw_call(UINT vertices);
 	LONG _ref = 1;
 	ID3D11DeviceContext *_orig;
 	unsigned int _interface_version;
 	D3D11Device *const _device;
+	const bool _is_deferred;
+	ID3D11DepthStencilView *_depthstencil = nullptr; // The depth stencil view the application bound last (not referenced, the context keeps it alive while it is bound)
+	UINT _drawcalls = 0, _vertices = 0; // Draw calls recorded on a deferred context since its last command list was finished
+	std::vector<reshade::d3d11::deferred_depthstencil_draws> _depthstencil_draws; // The same per depth stencil view
+
+	void add_deferred_draws(ID3D11DepthStencilView *depthstencil, UINT last_drawcall, UINT vertices);
 };
@@ -9,6 +9,7 @@
 #include "effect_lexer.hpp"
 #include "input.hpp"
 #include "resource_loading.hpp"
+#include "texel_conversion.hpp"
 #include "dllmodule.hpp"
 #include <imgui.h>
 #include <algorithm>
@@ -473,6 +474,13 @@ namespace reshade::d3d11
 		_depthstencil_texture_srv.reset();
 
 		_default_depthstencil.reset();
+
+		// Which depth stencil views are rejected depends on the back buffer size, so start over
+		{ const std::lock_guard<std::mutex> lock(_mutex);
+			_depth_source_table.for_each([](ID3D11DepthStencilView *depthstencil, depth_source_info &) { depthstencil->Release(); });
+			_depth_source_table.clear();
+		}
+
 		_copy_vertex_shader.reset();
 		_copy_pixel_shader.reset();
 		_copy_sampler.reset();
@@ -655,67 +663,75 @@ namespace reshade::d3d11
 			_stateblock.apply_and_release();
 		//}
 	}
-	void d3d11_runtime::on_draw_call(ID3D11DeviceContext *context, unsigned int vertices)
+	void d3d11_runtime::on_draw_call(ID3D11DepthStencilView *depthstencil, unsigned int vertices)
 	{
-		const std::lock_guard<std::mutex> lock(_mutex);
-
+		// The immediate context is only ever used by one thread at a time, so its draw calls can be counted without synchronization
 		_vertices += vertices;
 		_drawcalls += 1;
 
-		com_ptr<ID3D11DepthStencilView> current_depthstencil;
-
-		context->OMGetRenderTargets(0, nullptr, &current_depthstencil);
-
-		if (current_depthstencil == nullptr ||
-			current_depthstencil == _default_depthstencil)
+		track_depthstencil_draw(depthstencil, vertices, _drawcalls);
+	}
+	void d3d11_runtime::on_execute_command_list(unsigned int drawcalls, unsigned int vertices, const deferred_depthstencil_draws *draws, size_t draw_count)
+	{
+		// The draw calls of the command list follow the ones of the immediate context so far, so their indices are offset to be comparable with those
+		for (size_t i = 0; i < draw_count; ++i)
 		{
-			return;
+			track_depthstencil_draw(draws[i].depthstencil, draws[i].vertices, _drawcalls + draws[i].last_drawcall);
 		}
-		if (current_depthstencil == _depthstencil_replacement)
+
+		_vertices += vertices;
+		_drawcalls += drawcalls;
+	}
+	void d3d11_runtime::track_depthstencil_draw(ID3D11DepthStencilView *depthstencil, unsigned int vertices, unsigned int drawcall_index)
+	{
+		// The depth stencil view is the one the application bound, so this never sees the replacement
+		if (depthstencil == nullptr || depthstencil == _default_depthstencil)
 		{
-			current_depthstencil = _depthstencil;
+			return;
 		}
 
-		const auto it = _depth_source_table.find(current_depthstencil.get());
+		const auto info = _depth_source_table.find(depthstencil);
 
-		if (it != _depth_source_table.end())
+		if (info != nullptr && !info->rejected)
 		{
-			it->second.drawcall_count = _drawcalls;
-			it->second.vertices_count += vertices;
+			info->drawcall_count.store(drawcall_index, std::memory_order_relaxed);
+			info->vertices_count.fetch_add(vertices, std::memory_order_relaxed);
 		}
 	}
 	void d3d11_runtime::on_set_depthstencil_view(ID3D11DepthStencilView *&depthstencil)
 	{
-		const std::lock_guard<std::mutex> lock(_mutex);
-
-		if (_depth_source_table.find(depthstencil) == _depth_source_table.end())
+		// Only depth stencil views that were not seen before have to be inspected, all others are found without locking
+		if (_depth_source_table.find(depthstencil) == nullptr)
 		{
-			D3D11_TEXTURE2D_DESC texture_desc;
-			com_ptr<ID3D11Resource> resource;
-			com_ptr<ID3D11Texture2D> texture;
+			const std::lock_guard<std::mutex> lock(_mutex);
 
-			depthstencil->GetResource(&resource);
-
-			if (FAILED(resource->QueryInterface(&texture)))
+			if (_depth_source_table.find(depthstencil) == nullptr)
 			{
-				return;
-			}
+				D3D11_TEXTURE2D_DESC texture_desc = { };
+				com_ptr<ID3D11Resource> resource;
+				com_ptr<ID3D11Texture2D> texture;
 
-			texture->GetDesc(&texture_desc);
+				depthstencil->GetResource(&resource);
 
-			// Early depth stencil rejection
-			if (texture_desc.Width != _width || texture_desc.Height != _height || texture_desc.SampleDesc.Count > 1)
-			{
-				return;
-			}
+				const bool is_texture = SUCCEEDED(resource->QueryInterface(&texture));
 
-			depthstencil->AddRef();
+				if (is_texture)
+				{
+					texture->GetDesc(&texture_desc);
+				}
 
-			// Begin tracking new depth stencil
-			const depth_source_info info = { texture_desc.Width, texture_desc.Height };
-			_depth_source_table.emplace(depthstencil, info);
+				// Early depth stencil rejection
+				const bool rejected = !is_texture || texture_desc.Width != _width || texture_desc.Height != _height || texture_desc.SampleDesc.Count > 1;
+
+				// Begin tracking new depth stencil
+				_depth_source_table.insert(depthstencil, texture_desc.Width, texture_desc.Height, rejected);
+
+				depthstencil->AddRef();
+			}
 		}
 
+		const std::lock_guard<std::mutex> lock(_mutex);
+
 		if (_depthstencil_replacement != nullptr && depthstencil == _depthstencil)
 		{
 			depthstencil = _depthstencil_replacement.get();
@@ -808,18 +824,17 @@ namespace reshade::d3d11
 		auto mapped_data = static_cast<BYTE *>(mapped.pData);
 		const UINT pitch = texture_desc.Width * 4;
 
+		const bool is_bgra = _backbuffer_format == DXGI_FORMAT_B8G8R8A8_UNORM || _backbuffer_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+
 		for (UINT y = 0; y < texture_desc.Height; y++)
 		{
-			CopyMemory(buffer, mapped_data, std::min(pitch, static_cast<UINT>(mapped.RowPitch)));
-
-			for (UINT x = 0; x < pitch; x += 4)
+			if (is_bgra)
 			{
-				buffer[x + 3] = 0xFF;
-
-				if (texture_desc.Format == DXGI_FORMAT_B8G8R8A8_UNORM || texture_desc.Format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB)
-				{
-					std::swap(buffer[x + 0], buffer[x + 2]);
-				}
+				texel_conversion::swap_red_blue(buffer, mapped_data, texture_desc.Width, 0xFFFFFFFF, 0xFF000000);
+			}
+			else
+			{
+				texel_conversion::fill_alpha(buffer, mapped_data, texture_desc.Width);
 			}
 
 			buffer += pitch;
@@ -848,19 +863,23 @@ namespace reshade::d3d11
 		{
 			case texture_format::r8:
 			{
-				std::vector<uint8_t> data2(texture.width * texture.height);
-				for (size_t i = 0, k = 0; i < texture.width * texture.height * 4; i += 4, k++)
-					data2[k] = data[i];
-				_immediate_context->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, data2.data(), texture.width, texture.width * texture.height);
+				_texture_upload_buffer.resize(texture.width * texture.height);
+				texel_conversion::extract_r(_texture_upload_buffer.data(), data, texture.width * texture.height);
+				_immediate_context->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, _texture_upload_buffer.data(), texture.width, texture.width * texture.height);
 				break;
 			}
 			case texture_format::rg8:
 			{
-				std::vector<uint8_t> data2(texture.width * texture.height * 2);
-				for (size_t i = 0, k = 0; i < texture.width * texture.height * 4; i += 4, k += 2)
-					data2[k] = data[i],
-					data2[k + 1] = data[i + 1];
-				_immediate_context->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, data2.data(), texture.width * 2, texture.width * texture.height * 2);
+				_texture_upload_buffer.resize(texture.width * texture.height * 2);
+				texel_conversion::extract_rg(_texture_upload_buffer.data(), data, texture.width * texture.height);
+				_immediate_context->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, _texture_upload_buffer.data(), texture.width * 2, texture.width * texture.height * 2);
+				break;
+			}
+			case texture_format::rgba16f:
+			{
+				_texture_upload_buffer.resize(texture.width * texture.height * 8);
+				texel_conversion::unorm8_to_float16(reinterpret_cast<uint16_t *>(_texture_upload_buffer.data()), data, texture.width * texture.height * 4);
+				_immediate_context->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, _texture_upload_buffer.data(), texture.width * 8, texture.width * texture.height * 8);
 				break;
 			}
 			default:
@@ -894,19 +913,30 @@ namespace reshade::d3d11
 		if (technique.uniform_storage_index >= 0)
 		{
 			const auto constant_buffer = _constant_buffers[technique.uniform_storage_index].get();
-			D3D11_MAPPED_SUBRESOURCE mapped;
-
-			const HRESULT hr = _immediate_context->Map(constant_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+			D3D11_BUFFER_DESC desc;
+			constant_buffer->GetDesc(&desc);
 
-			if (SUCCEEDED(hr))
+			// Techniques of the same effect share a constant buffer, so only upload it if any of its values changed since the last upload
+			if (is_uniform_storage_dirty(technique.uniform_storage_offset, desc.ByteWidth))
 			{
-				CopyMemory(mapped.pData, get_uniform_value_storage().data() + technique.uniform_storage_offset, mapped.RowPitch);
+				D3D11_MAPPED_SUBRESOURCE mapped;
 
-				_immediate_context->Unmap(constant_buffer, 0);
-			}
-			else
-			{
-				LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
+				const HRESULT hr = _immediate_context->Map(constant_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+
+				if (SUCCEEDED(hr))
+				{
+					CopyMemory(mapped.pData, get_uniform_value_storage().data() + technique.uniform_storage_offset, desc.ByteWidth);
+
+					_immediate_context->Unmap(constant_buffer, 0);
+
+					clear_uniform_storage_dirty(technique.uniform_storage_offset, desc.ByteWidth);
+
+					_uniform_bytes_uploaded += desc.ByteWidth;
+				}
+				else
+				{
+					LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
+				}
 			}
 
 			_immediate_context->VSSetConstantBuffers(0, 1, &constant_buffer);
@@ -1168,38 +1198,40 @@ namespace reshade::d3d11
 			return;
 		}
 
-		depth_source_info best_info = { 0 };
+		UINT best_drawcall_count = 0, best_vertices_count = 0;
 		ID3D11DepthStencilView *best_match = nullptr;
+		std::vector<ID3D11DepthStencilView *> released_depthstencils;
 
-		for (auto it = _depth_source_table.begin(); it != _depth_source_table.end();)
-		{
-			const auto depthstencil = it->first;
-			auto &depthstencil_info = it->second;
-
+		_depth_source_table.for_each([&](ID3D11DepthStencilView *depthstencil, depth_source_info &depthstencil_info) {
 			if ((depthstencil->AddRef(), depthstencil->Release()) == 1)
 			{
-				depthstencil->Release();
-
-				it = _depth_source_table.erase(it);
-				continue;
-			}
-			else
-			{
-				++it;
+				released_depthstencils.push_back(depthstencil);
+				return;
 			}
 
-			if (depthstencil_info.drawcall_count == 0)
+			// Draw calls on other threads may still add to these while they are reset, those few are simply counted towards the next frame
+			const UINT drawcall_count = depthstencil_info.drawcall_count.exchange(0, std::memory_order_relaxed);
+			const UINT vertices_count = depthstencil_info.vertices_count.exchange(0, std::memory_order_relaxed);
+
+			if (depthstencil_info.rejected || drawcall_count == 0)
 			{
-				continue;
+				return;
 			}
 
-			if ((depthstencil_info.vertices_count * (1.2f - float(depthstencil_info.drawcall_count) / _drawcalls)) >= (best_info.vertices_count * (1.2f - float(best_info.drawcall_count) / _drawcalls)))
+			if ((vertices_count * (1.2f - float(drawcall_count) / _drawcalls)) >= (best_vertices_count * (1.2f - float(best_drawcall_count) / _drawcalls)))
 			{
 				best_match = depthstencil;
-				best_info = depthstencil_info;
+				best_drawcall_count = drawcall_count;
+				best_vertices_count = vertices_count;
 			}
+		});
+
+		// The application released these, so nothing can draw with them anymore
+		for (const auto depthstencil : released_depthstencils)
+		{
+			_depth_source_table.erase(depthstencil);
 
-			depthstencil_info.drawcall_count = depthstencil_info.vertices_count = 0;
+			depthstencil->Release();
 		}
 
 		if (best_match != nullptr && _depthstencil != best_match)
@@ -6,8 +6,10 @@
 #pragma once
 
 #include <mutex>
+#include <atomic>
 #include <d3d11_3.h>
 #include "runtime.hpp"
+#include "depth_source_table.hpp"
 #include "d3d11_stateblock.hpp"
 
 namespace reshade::d3d11
@@ -39,6 +41,15 @@ namespace reshade::d3d11
 		com_ptr<ID3D11Query> timestamp_query_end;
 	};
 
+	/// <summary>
+	/// Draw calls a deferred context recorded to one depth stencil view. Where in the frame they happen is only known once their command list is executed.
+	/// </summary>
+	struct deferred_depthstencil_draws
+	{
+		ID3D11DepthStencilView *depthstencil;
+		UINT last_drawcall, vertices; // The index of the last draw call is relative to the start of the command list
+	};
+
 	class d3d11_runtime : public runtime
 	{
 	public:
@@ -50,7 +61,8 @@ namespace reshade::d3d11
 		static void do_draw_fx(void* runtime);
 		void draw_fx();
 		void on_present();
-		void on_draw_call(ID3D11DeviceContext *context, unsigned int vertices);
+		void on_draw_call(ID3D11DepthStencilView *depthstencil, unsigned int vertices);
+		void on_execute_command_list(unsigned int drawcalls, unsigned int vertices, const deferred_depthstencil_draws *draws, size_t draw_count);
 		void on_set_depthstencil_view(ID3D11DepthStencilView *&depthstencil);
 		void on_get_depthstencil_view(ID3D11DepthStencilView *&depthstencil);
 		void on_clear_depthstencil_view(ID3D11DepthStencilView *&depthstencil);
@@ -77,12 +89,6 @@ namespace reshade::d3d11
 		std::vector<com_ptr<ID3D11Buffer>> _constant_buffers;
 
 	private:
-		struct depth_source_info
-		{
-			UINT width, height;
-			UINT drawcall_count, vertices_count;
-		};
-
 		bool init_backbuffer_texture();
 		bool init_default_depth_stencil();
 		bool init_fx_resources();
@@ -90,6 +96,7 @@ namespace reshade::d3d11
 		bool init_imgui_font_atlas();
 
 		void detect_depth_source();
+		void track_depthstencil_draw(ID3D11DepthStencilView *depthstencil, unsigned int vertices, unsigned int drawcall_index);
 		bool create_depthstencil_replacement(ID3D11DepthStencilView *depthstencil);
 
 		bool _is_multisampling_enabled = false;
@@ -99,7 +106,7 @@ namespace reshade::d3d11
 		com_ptr<ID3D11DepthStencilView> _depthstencil, _depthstencil_replacement;
 		com_ptr<ID3D11Texture2D> _depthstencil_texture;
 		com_ptr<ID3D11DepthStencilView> _default_depthstencil;
-		std::unordered_map<ID3D11DepthStencilView *, depth_source_info> _depth_source_table;
+		depth_source_table<ID3D11DepthStencilView> _depth_source_table;
 		com_ptr<ID3D11VertexShader> _copy_vertex_shader;
 		com_ptr<ID3D11PixelShader> _copy_pixel_shader;
 		com_ptr<ID3D11SamplerState> _copy_sampler;
@@ -0,0 +1,131 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+namespace reshade::d3d9
+{
+	struct depth_source_info
+	{
+		unsigned int width, height;
+		unsigned int drawcall_count, vertices_count;
+	};
+
+	/// <summary>
+	/// Draw call statistics of the depth stencil surfaces an application sets, together with the surface it has currently set and its entry, so that draw calls neither have to ask the device for it nor look it up.
+	/// The surface type is a template parameter so that this does not depend on a device.
+	/// </summary>
+	template <typename T>
+	class depth_stencil_tracker
+	{
+	public:
+		using table = std::unordered_map<T *, depth_source_info>;
+
+		/// <summary>
+		/// Returns the statistics of all tracked surfaces.
+		/// </summary>
+		table &sources() { return _sources; }
+		const table &sources() const { return _sources; }
+
+		/// <summary>
+		/// Remember the surface the application set and look it up.
+		/// </summary>
+		/// <param name="depthstencil">The surface the application set, or <c>nullptr</c> when it unbinds the current one.</param>
+		/// <param name="track">Called for surfaces that are not tracked yet. Returns <c>false</c> to reject the surface, otherwise fills in its width and height.</param>
+		template <typename F>
+		void set_current(T *depthstencil, F track)
+		{
+			_is_current_known = true;
+			_current = depthstencil;
+			_current_info = nullptr;
+
+			if (depthstencil == nullptr)
+			{
+				return;
+			}
+
+			auto it = _sources.find(depthstencil);
+
+			if (it == _sources.end())
+			{
+				depth_source_info info = { };
+
+				if (!track(depthstencil, info))
+				{
+					return;
+				}
+
+				it = _sources.emplace(depthstencil, info).first;
+			}
+
+			_current_info = &it->second;
+		}
+		/// <summary>
+		/// Forget the current surface, so that the next draw call asks for it again. The device has to do this after it was reset, since that binds the automatic depth stencil surface.
+		/// </summary>
+		void reset_current()
+		{
+			_is_current_known = false;
+			_current = nullptr;
+			_current_info = nullptr;
+		}
+
+		/// <summary>
+		/// Add a draw call to the statistics of the current surface.
+		/// </summary>
+		/// <param name="drawcall_index">The number of draw calls in this frame so far.</param>
+		/// <param name="vertices">The number of vertices the draw call processes.</param>
+		/// <param name="query">Called only when the current surface is not known. Returns the surface the device has currently set.</param>
+		template <typename F>
+		void on_draw_call(unsigned int drawcall_index, unsigned int vertices, F query)
+		{
+			if (!_is_current_known)
+			{
+				T *const depthstencil = query();
+				const auto it = _sources.find(depthstencil);
+
+				_is_current_known = true;
+				_current = depthstencil;
+				_current_info = it != _sources.end() ? &it->second : nullptr;
+			}
+
+			if (_current_info != nullptr)
+			{
+				_current_info->drawcall_count = drawcall_index;
+				_current_info->vertices_count += vertices;
+			}
+		}
+
+		/// <summary>
+		/// Stop tracking a surface.
+		/// </summary>
+		typename table::iterator erase(typename table::iterator it)
+		{
+			if (it->first == _current)
+			{
+				_current_info = nullptr;
+			}
+
+			return _sources.erase(it);
+		}
+		/// <summary>
+		/// Stop tracking all surfaces and forget the current one.
+		/// </summary>
+		void clear()
+		{
+			_sources.clear();
+
+			reset_current();
+		}
+
+	private:
+		table _sources;
+		bool _is_current_known = false;
+		T *_current = nullptr;
+		depth_source_info *_current_info = nullptr;
+	};
+}
@@ -401,19 +401,17 @@ HRESULT STDMETHODCALLTYPE Direct3DDevice9::GetRenderTarget(DWORD RenderTargetInd
 }
 HRESULT STDMETHODCALLTYPE Direct3DDevice9::SetDepthStencilSurface(IDirect3DSurface9 *pNewZStencil)
 {
-	if (pNewZStencil != nullptr)
-	{
-		assert(_implicit_swapchain != nullptr);
-		assert(_implicit_swapchain->_runtime != nullptr);
+	// Always notify the runtimes, even when unbinding, since they keep track of the current surface
+	assert(_implicit_swapchain != nullptr);
+	assert(_implicit_swapchain->_runtime != nullptr);
 
-		_implicit_swapchain->_runtime->on_set_depthstencil_surface(pNewZStencil);
+	_implicit_swapchain->_runtime->on_set_depthstencil_surface(pNewZStencil);
 
-		for (auto swapchain : _additional_swapchains)
-		{
-			assert(swapchain->_runtime != nullptr);
+	for (auto swapchain : _additional_swapchains)
+	{
+		assert(swapchain->_runtime != nullptr);
 
-			swapchain->_runtime->on_set_depthstencil_surface(pNewZStencil);
-		}
+		swapchain->_runtime->on_set_depthstencil_surface(pNewZStencil);
 	}
 
 	return _orig->SetDepthStencilSurface(pNewZStencil);
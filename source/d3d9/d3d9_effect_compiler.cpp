@@ -3,8 +3,11 @@
  * License: https://github.com/crosire/reshade#license
  */
 
+#include "log.hpp"
+#include "profiler.hpp"
 #include "d3d9_runtime.hpp"
 #include "d3d9_effect_compiler.hpp"
+#include "shader_cache_directory.hpp"
 #include <assert.h>
 #include <iomanip>
 #include <algorithm>
@@ -154,6 +157,8 @@ namespace reshade::d3d9
 
 	bool d3d9_effect_compiler::run()
 	{
+		const profiler::zone profile_zone("generate_code");
+
 		_d3dcompiler_module = LoadLibraryW(L"d3dcompiler_47.dll");
 
 		if (_d3dcompiler_module == nullptr)
@@ -166,15 +171,43 @@ namespace reshade::d3d9
 			return false;
 		}
 
+		_d3dcompiler_version = shader_cache_directory::compiler_version(_d3dcompiler_module);
+
 		_uniform_storage_offset = _runtime->get_uniform_value_storage().size();
 
+		// Lay out all uniforms up front, so that the storage is only resized once
+		for (auto uniform : _ast.variables)
+		{
+			if (!uniform->type.is_texture() && !uniform->type.is_sampler() && uniform->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				_uniform_layout.add(uniform->type.rows, uniform->type.cols, std::max(0, uniform->type.array_length));
+			}
+		}
+
+		_uniform_layout.pack();
+
+		_constant_register_count = _uniform_layout.size() / 16;
+		_runtime->get_uniform_value_storage().resize(_uniform_storage_offset + _uniform_layout.size());
+
+		if (_constant_register_count != 0)
+		{
+			LOG(INFO) << "> Packed uniforms into " << _constant_register_count << " constant registers, " << _uniform_layout.padding() << " bytes of which are padding.";
+		}
+
+		// Remember where each global declaration starts, so that shaders can pick only those they need later on
 		for (auto node : _ast.structs)
 		{
+			_global_declarations.push_back({ node, static_cast<size_t>(_global_code.tellp()) });
+
 			visit(_global_code, node);
 		}
 
+		size_t uniform_index = 0;
+
 		for (auto uniform : _ast.variables)
 		{
+			_global_declarations.push_back({ uniform, static_cast<size_t>(_global_code.tellp()) });
+
 			if (uniform->type.is_texture())
 			{
 				visit_texture(uniform);
@@ -185,7 +218,7 @@ namespace reshade::d3d9
 			}
 			else if (uniform->type.has_qualifier(type_node::qualifier_uniform))
 			{
-				visit_uniform(uniform);
+				visit_uniform(uniform, uniform_index++);
 			}
 			else
 			{
@@ -213,6 +246,11 @@ namespace reshade::d3d9
 
 		FreeLibrary(_d3dcompiler_module);
 
+		if (const size_t reused_count = _vertex_shaders.reused_count() + _pixel_shaders.reused_count())
+		{
+			LOG(INFO) << "> Reused " << reused_count << " shaders across passes instead of compiling them again.";
+		}
+
 		return _success;
 	}
 
@@ -1564,7 +1602,7 @@ namespace reshade::d3d9
 
 		_samplers[node->name] = sampler;
 	}
-	void d3d9_effect_compiler::visit_uniform(const variable_declaration_node *node)
+	void d3d9_effect_compiler::visit_uniform(const variable_declaration_node *node, size_t index)
 	{
 		auto type = node->type;
 		type.basetype = type_node::datatype_float;
@@ -1584,7 +1622,9 @@ namespace reshade::d3d9
 			_global_code << ']';
 		}
 
-		_global_code << " : register(c" << _constant_register_count << ");\n";
+		const size_t offset = _uniform_layout.offset(index);
+
+		_global_code << " : register(c" << (offset / 16) << ");\n";
 
 		uniform obj;
 		obj.name = node->name;
@@ -1597,27 +1637,18 @@ namespace reshade::d3d9
 		obj.storage_size = obj.rows * obj.columns * std::max(1u, obj.elements) * 4;
 		obj.annotations = node->annotation_list;
 
-		obj.storage_offset = _uniform_storage_offset + _constant_register_count * 16;
-		_constant_register_count += (obj.storage_size / 4 + 4 - ((obj.storage_size / 4) % 4)) / 4;
-
-		auto &uniform_storage = _runtime->get_uniform_value_storage();
-
-		if (_uniform_storage_offset + _constant_register_count * 16 >= uniform_storage.size())
-		{
-			uniform_storage.resize(uniform_storage.size() + 4096);
-		}
+		obj.storage_offset = _uniform_storage_offset + offset;
 
+		// The storage was already resized and zero-initialized in 'run', so only explicit initializers need to be copied
 		if (node->initializer_expression != nullptr && node->initializer_expression->id == nodeid::literal_expression)
 		{
+			const auto uniform_storage_data = reinterpret_cast<float *>(_runtime->get_uniform_value_storage().data() + obj.storage_offset);
+
 			for (size_t i = 0; i < obj.storage_size / 4; i++)
 			{
-				scalar_literal_cast(static_cast<const literal_expression_node *>(node->initializer_expression), i, reinterpret_cast<float *>(uniform_storage.data() + obj.storage_offset)[i]);
+				scalar_literal_cast(static_cast<const literal_expression_node *>(node->initializer_expression), i, uniform_storage_data[i]);
 			}
 		}
-		else
-		{
-			ZeroMemory(uniform_storage.data() + obj.storage_offset, obj.storage_size);
-		}
 
 		_runtime->add_uniform(std::move(obj));
 	}
@@ -1821,7 +1852,13 @@ namespace reshade::d3d9
 		}
 
 		source << samplers;
-		source << _global_code.str();
+		// Only include the global declarations this entry point actually uses, so that the compiler does not have to parse and strip all the others
+		const std::string global_code = _global_code.str();
+		const std::string used_global_code = extract_dependencies(node, global_code, _global_declarations);
+
+		LOG(INFO) << "> Shader '" << node->name << "' uses " << used_global_code.size() << " of " << global_code.size() << " bytes of global code.";
+
+		source << used_global_code;
 
 		for (auto dependency : _functions.at(node).dependencies)
 		{
@@ -2019,35 +2056,63 @@ namespace reshade::d3d9
 		source << "}\n";
 
 		UINT flags = 0;
-		com_ptr<ID3DBlob> compiled, errors;
+		std::string bytecode;
 
 		if (_skip_shader_optimization)
 		{
 			flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 		}
 
-		const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
 		const std::string source_str = source.str();
-		HRESULT hr = D3DCompile(source_str.c_str(), source_str.size(), nullptr, nullptr, nullptr, "__main", (shadertype + "_3_0").c_str(), flags, 0, &compiled, &errors);
+		const std::string profile = shadertype + "_3_0";
 
-		if (errors != nullptr)
+		const uint64_t shader_key = shader_cache::key(_d3dcompiler_version, source_str, node->unique_name, profile, flags);
+
+		if ((shadertype == "vs" && _vertex_shaders.find(shader_key, pass.vertex_shader)) ||
+			(shadertype == "ps" && _pixel_shaders.find(shader_key, pass.pixel_shader)))
 		{
-			_errors.append(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
+			return;
 		}
 
-		if (FAILED(hr))
+		// Only invoke the compiler if the exact same shader was not compiled in a previous run already
+		const bool success = _runtime->get_shader_cache().compile(_d3dcompiler_version, source_str, "__main", profile, flags, bytecode, _errors, [this, &source_str, node, &profile, flags](std::string &result, std::string &messages) {
+			const profiler::zone profile_zone("compile_shader", node->unique_name);
+
+			com_ptr<ID3DBlob> compiled, errors;
+
+			const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
+			const HRESULT hr = D3DCompile(source_str.c_str(), source_str.size(), nullptr, nullptr, nullptr, "__main", profile.c_str(), flags, 0, &compiled, &errors);
+
+			if (errors != nullptr)
+			{
+				messages.assign(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
+			}
+
+			if (FAILED(hr))
+			{
+				return false;
+			}
+
+			result.assign(static_cast<const char *>(compiled->GetBufferPointer()), compiled->GetBufferSize());
+
+			return true;
+		});
+
+		if (!success)
 		{
 			error(node->location, "internal shader compilation failed");
 			return;
 		}
 
+		HRESULT hr = S_OK;
+
 		if (shadertype == "vs")
 		{
-			hr = _runtime->_device->CreateVertexShader(static_cast<const DWORD *>(compiled->GetBufferPointer()), &pass.vertex_shader);
+			hr = _runtime->_device->CreateVertexShader(reinterpret_cast<const DWORD *>(bytecode.data()), &pass.vertex_shader);
 		}
 		else if (shadertype == "ps")
 		{
-			hr = _runtime->_device->CreatePixelShader(static_cast<const DWORD *>(compiled->GetBufferPointer()), &pass.pixel_shader);
+			hr = _runtime->_device->CreatePixelShader(reinterpret_cast<const DWORD *>(bytecode.data()), &pass.pixel_shader);
 		}
 
 		if (FAILED(hr))
@@ -2055,5 +2120,14 @@ namespace reshade::d3d9
 			error(node->location, "internal shader creation failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
 			return;
 		}
+
+		if (shadertype == "vs")
+		{
+			_vertex_shaders.insert(shader_key, pass.vertex_shader);
+		}
+		else if (shadertype == "ps")
+		{
+			_pixel_shaders.insert(shader_key, pass.pixel_shader);
+		}
 	}
 }
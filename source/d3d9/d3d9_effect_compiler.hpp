@@ -6,6 +6,9 @@
 #pragma once
 
 #include "effect_syntax_tree.hpp"
+#include "effect_dependencies.hpp"
+#include "uniform_layout.hpp"
+#include "shader_reuse_table.hpp"
 #include <sstream>
 #include <unordered_set>
 
@@ -60,7 +63,7 @@ namespace reshade::d3d9
 
 		void visit_texture(const reshadefx::nodes::variable_declaration_node *node);
 		void visit_sampler(const reshadefx::nodes::variable_declaration_node *node);
-		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node);
+		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node, size_t index);
 		void visit_technique(const reshadefx::nodes::technique_declaration_node *node);
 		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, d3d9_pass_data &pass);
 		void visit_pass_shader(const reshadefx::nodes::function_declaration_node *node, const std::string &shadertype, const std::string &samplers, d3d9_pass_data &pass);
@@ -77,11 +80,16 @@ namespace reshade::d3d9
 		const reshadefx::syntax_tree &_ast;
 		std::string &_errors;
 		size_t _uniform_storage_offset = 0, _constant_register_count = 0;
+		uniform_layout _uniform_layout { uniform_layout::packing_rules::d3d9_registers };
 		std::stringstream _global_code, _global_uniforms;
+		std::vector<reshadefx::global_declaration> _global_declarations;
 		bool _skip_shader_optimization;
 		const reshadefx::nodes::function_declaration_node *_current_function;
 		std::unordered_map<std::string, d3d9_sampler> _samplers;
 		std::unordered_map<const reshadefx::nodes::function_declaration_node *, function> _functions;
 		HMODULE _d3dcompiler_module = nullptr;
+		std::string _d3dcompiler_version;
+		shader_reuse_table<com_ptr<IDirect3DVertexShader9>> _vertex_shaders;
+		shader_reuse_table<com_ptr<IDirect3DPixelShader9>> _pixel_shaders;
 	};
 }
@@ -9,6 +9,7 @@
 #include "effect_lexer.hpp"
 #include "input.hpp"
 #include "dllmodule.hpp"
+#include "texel_conversion.hpp"
 #include <imgui.h>
 #include <algorithm>
 
@@ -235,12 +236,12 @@ namespace reshade::d3d9
 		_imgui_index_buffer_size = 0;
 
 		// Clear depth source table
-		for (auto &it : _depth_source_table)
+		for (auto &it : _depth_tracker.sources())
 		{
 			it.first->Release();
 		}
 
-		_depth_source_table.clear();
+		_depth_tracker.clear();
 	}
 	void d3d9_runtime::do_draw_fx(void* runtime)
 	{
@@ -287,6 +288,8 @@ namespace reshade::d3d9
 			_device->SetStreamSource(0, _effect_triangle_buffer.get(), 0, sizeof(float));
 			_device->SetVertexDeclaration(_effect_triangle_layout.get());
 
+			_constant_register_storage_offset = -1;
+
 			on_present_effect();
 		}
 
@@ -408,46 +411,41 @@ namespace reshade::d3d9
 		_vertices += vertices;
 		_drawcalls += 1;
 
-		com_ptr<IDirect3DSurface9> depthstencil;
-		_device->GetDepthStencilSurface(&depthstencil);
+		// Only asks the device when nothing was set since it was created or reset
+		_depth_tracker.on_draw_call(_drawcalls, vertices, [this]() {
+			com_ptr<IDirect3DSurface9> depthstencil;
+			_device->GetDepthStencilSurface(&depthstencil);
 
-		if (depthstencil != nullptr)
-		{
-			if (depthstencil == _depthstencil_replacement)
+			if (depthstencil != nullptr && depthstencil == _depthstencil_replacement)
 			{
 				depthstencil = _depthstencil;
 			}
 
-			const auto it = _depth_source_table.find(depthstencil.get());
-
-			if (it != _depth_source_table.end())
-			{
-				it->second.drawcall_count = _drawcalls;
-				it->second.vertices_count += vertices;
-			}
-		}
+			return depthstencil.get();
+		});
 	}
 	void d3d9_runtime::on_set_depthstencil_surface(IDirect3DSurface9 *&depthstencil)
 	{
-		if (_depth_source_table.find(depthstencil) == _depth_source_table.end())
-		{
+		_depth_tracker.set_current(depthstencil, [this](IDirect3DSurface9 *surface, depth_source_info &info) {
 			D3DSURFACE_DESC desc;
-			depthstencil->GetDesc(&desc);
+			surface->GetDesc(&desc);
 
 			// Early rejection
 			if ( desc.MultiSampleType != D3DMULTISAMPLE_NONE ||
 				(desc.Width < _width * 0.95 || desc.Width > _width * 1.05) ||
 				(desc.Height < _height * 0.95 || desc.Height > _height * 1.05))
 			{
-				return;
+				return false;
 			}
 	
-			depthstencil->AddRef();
+			surface->AddRef();
 
 			// Begin tracking
-			const depth_source_info info = { desc.Width, desc.Height };
-			_depth_source_table.emplace(depthstencil, info);
-		}
+			info.width = desc.Width;
+			info.height = desc.Height;
+
+			return true;
+		});
 
 		if (_depthstencil_replacement != nullptr && depthstencil == _depthstencil)
 		{
@@ -504,18 +502,17 @@ namespace reshade::d3d9
 		auto mapped_data = static_cast<BYTE *>(mapped_rect.pBits);
 		const UINT pitch = _width * 4;
 
+		const bool is_bgra = _backbuffer_format == D3DFMT_A8R8G8B8 || _backbuffer_format == D3DFMT_X8R8G8B8;
+
 		for (UINT y = 0; y < _height; y++)
 		{
-			std::memcpy(buffer, mapped_data, std::min(pitch, static_cast<UINT>(mapped_rect.Pitch)));
-
-			for (UINT x = 0; x < pitch; x += 4)
+			if (is_bgra)
 			{
-				buffer[x + 3] = 0xFF;
-
-				if (_backbuffer_format == D3DFMT_A8R8G8B8 || _backbuffer_format == D3DFMT_X8R8G8B8)
-				{
-					std::swap(buffer[x + 0], buffer[x + 2]);
-				}
+				texel_conversion::swap_red_blue(buffer, mapped_data, _width, 0xFFFFFFFF, 0xFF000000);
+			}
+			else
+			{
+				texel_conversion::fill_alpha(buffer, mapped_data, _width);
 			}
 
 			buffer += pitch;
@@ -562,35 +559,29 @@ namespace reshade::d3d9
 			return false;
 		}
 
-		const UINT size = std::min(texture.width * 4, static_cast<UINT>(mapped_rect.Pitch)) * texture.height;
 		auto mapped_data = static_cast<BYTE *>(mapped_rect.pBits);
 
-		switch (texture.format)
+		// Rows of the locked surface may be padded, so convert them one at a time
+		for (UINT y = 0; y < texture.height; y++, data += texture.width * 4, mapped_data += mapped_rect.Pitch)
 		{
-			case texture_format::r8:
-				for (UINT i = 0; i < size; i += 4, mapped_data += 4)
-					mapped_data[0] = 0,
-					mapped_data[1] = 0,
-					mapped_data[2] = data[i],
-					mapped_data[3] = 0;
-				break;
-			case texture_format::rg8:
-				for (UINT i = 0; i < size; i += 4, mapped_data += 4)
-					mapped_data[0] = 0,
-					mapped_data[1] = data[i + 1],
-					mapped_data[2] = data[i],
-					mapped_data[3] = 0;
-				break;
-			case texture_format::rgba8:
-				for (UINT i = 0; i < size; i += 4, mapped_data += 4)
-					mapped_data[0] = data[i + 2],
-					mapped_data[1] = data[i + 1],
-					mapped_data[2] = data[i],
-					mapped_data[3] = data[i + 3];
-				break;
-			default:
-				std::memcpy(mapped_data, data, size);
-				break;
+			switch (texture.format)
+			{
+				case texture_format::r8:
+					texel_conversion::swap_red_blue(mapped_data, data, texture.width, 0x00FF0000);
+					break;
+				case texture_format::rg8:
+					texel_conversion::swap_red_blue(mapped_data, data, texture.width, 0x00FFFF00);
+					break;
+				case texture_format::rgba8:
+					texel_conversion::swap_red_blue(mapped_data, data, texture.width);
+					break;
+				case texture_format::rgba16f:
+					texel_conversion::unorm8_to_float16(reinterpret_cast<uint16_t *>(mapped_data), data, texture.width * 4);
+					break;
+				default:
+					std::memcpy(mapped_data, data, std::min(texture.width * 4, static_cast<UINT>(mapped_rect.Pitch)));
+					break;
+			}
 		}
 
 		mem_texture->UnlockRect(0);
@@ -665,9 +656,20 @@ namespace reshade::d3d9
 		// Setup shader constants
 		if (technique.uniform_storage_index >= 0)
 		{
-			const auto uniform_storage_data = reinterpret_cast<const float *>(get_uniform_value_storage().data() + technique.uniform_storage_offset);
-			_device->SetVertexShaderConstantF(0, uniform_storage_data, static_cast<UINT>(technique.uniform_storage_index));
-			_device->SetPixelShaderConstantF(0, uniform_storage_data, static_cast<UINT>(technique.uniform_storage_index));
+			const size_t uniform_storage_size = static_cast<size_t>(technique.uniform_storage_index) * 4 * sizeof(float);
+
+			// The constant registers are shared with the application, so they can only be kept if they still hold the unchanged values of the same effect from earlier this frame
+			if (_constant_register_storage_offset != technique.uniform_storage_offset || is_uniform_storage_dirty(technique.uniform_storage_offset, uniform_storage_size))
+			{
+				const auto uniform_storage_data = reinterpret_cast<const float *>(get_uniform_value_storage().data() + technique.uniform_storage_offset);
+				_device->SetVertexShaderConstantF(0, uniform_storage_data, static_cast<UINT>(technique.uniform_storage_index));
+				_device->SetPixelShaderConstantF(0, uniform_storage_data, static_cast<UINT>(technique.uniform_storage_index));
+
+				clear_uniform_storage_dirty(technique.uniform_storage_offset, uniform_storage_size);
+
+				_uniform_bytes_uploaded += 2 * uniform_storage_size;
+				_constant_register_storage_offset = technique.uniform_storage_offset;
+			}
 		}
 
 		for (const auto &pass_object : technique.passes)
@@ -911,7 +913,7 @@ namespace reshade::d3d9
 			}
 		}
 
-		if (_is_multisampling_enabled || _depth_source_table.empty())
+		if (_is_multisampling_enabled || _depth_tracker.sources().empty())
 		{
 			return;
 		}
@@ -919,7 +921,7 @@ namespace reshade::d3d9
 		depth_source_info best_info = { 0 };
 		IDirect3DSurface9 *best_match = nullptr;
 
-		for (auto it = _depth_source_table.begin(); it != _depth_source_table.end();)
+		for (auto it = _depth_tracker.sources().begin(); it != _depth_tracker.sources().end();)
 		{
 			const auto depthstencil = it->first;
 			auto &depthstencil_info = it->second;
@@ -928,7 +930,7 @@ namespace reshade::d3d9
 			{
 				depthstencil->Release();
 
-				it = _depth_source_table.erase(it);
+				it = _depth_tracker.erase(it);
 				continue;
 			}
 			else
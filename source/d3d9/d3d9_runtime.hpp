@@ -8,6 +8,7 @@
 #include <d3d9.h>
 #include "runtime.hpp"
 #include "com_ptr.hpp"
+#include "d3d9_depth_tracker.hpp"
 
 namespace reshade::d3d9
 {
@@ -65,12 +66,6 @@ namespace reshade::d3d9
 		com_ptr<IDirect3DTexture9> _depthstencil_texture;
 
 	private:
-		struct depth_source_info
-		{
-			UINT width, height;
-			UINT drawcall_count, vertices_count;
-		};
-
 		bool init_backbuffer_texture();
 		bool init_default_depth_stencil();
 		bool init_fx_resources();
@@ -84,10 +79,12 @@ namespace reshade::d3d9
 		D3DFORMAT _backbuffer_format = D3DFMT_UNKNOWN;
 		com_ptr<IDirect3DStateBlock9> _stateblock;
 		com_ptr<IDirect3DSurface9> _depthstencil, _depthstencil_replacement, _default_depthstencil;
-		std::unordered_map<IDirect3DSurface9 *, depth_source_info> _depth_source_table;
+		// Tracks the surfaces the application sets, never the replacement
+		depth_stencil_tracker<IDirect3DSurface9> _depth_tracker;
 
 		com_ptr<IDirect3DVertexBuffer9> _effect_triangle_buffer;
 		com_ptr<IDirect3DVertexDeclaration9> _effect_triangle_layout;
+		ptrdiff_t _constant_register_storage_offset = -1;
 
 		com_ptr<IDirect3DVertexBuffer9> _imgui_vertex_buffer;
 		com_ptr<IDirect3DIndexBuffer9> _imgui_index_buffer;
@@ -0,0 +1,228 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace reshade
+{
+	/// <summary>
+	/// Draw call statistics of a depth stencil view, from which the runtime picks the one that most likely holds the depth of the scene.
+	/// </summary>
+	struct depth_source_info
+	{
+		unsigned int width, height;
+		bool rejected; // Depth stencil views that can never be a depth source are kept too, so that binding them again is cheap
+		std::atomic<unsigned int> drawcall_count, vertices_count;
+	};
+
+	/// <summary>
+	/// An open addressing hash table of depth stencil views, which draw calls on any thread look up and update without taking a lock.
+	/// Adding and removing entries has to be serialized by the caller. Removed entries leave a tombstone behind, so that the probe sequences of other entries stay intact while they are searched.
+	/// Inserting reuses tombstones. Once three quarters of the slots hold entries, they are copied into a table twice the size, which then replaces the current one.
+	/// Replaced tables stay alive until the table is destroyed, since other threads may still be searching them. The capacity doubles every time, so together they take up less memory than the current table.
+	/// </summary>
+	template <typename T>
+	class depth_source_table
+	{
+	public:
+		explicit depth_source_table(size_t initial_capacity = 256)
+		{
+			_tables.push_back(std::make_unique<table>(initial_capacity));
+			_current.store(_tables.back().get(), std::memory_order_release);
+		}
+
+		/// <summary>
+		/// Look up the statistics of a depth stencil view. This is safe to call from any thread at any time.
+		/// A view that is added or removed concurrently may or may not be found, and counts added to it while the table grows may be lost.
+		/// </summary>
+		/// <param name="depthstencil">The depth stencil view to look up.</param>
+		/// <returns>A pointer to the statistics, or <c>nullptr</c> if the view is not in the table.</returns>
+		depth_source_info *find(T *depthstencil)
+		{
+			const auto key = reinterpret_cast<uintptr_t>(depthstencil);
+			table &current = *_current.load(std::memory_order_acquire);
+
+			for (size_t i = 0, index = hash(key); i < current.capacity; i++, index++)
+			{
+				auto &slot = current.slots[index & (current.capacity - 1)];
+				const auto slot_key = slot.key.load(std::memory_order_acquire);
+
+				if (slot_key == key)
+				{
+					return &slot.info;
+				}
+				if (slot_key == empty_key)
+				{
+					break;
+				}
+			}
+
+			return nullptr;
+		}
+		/// <summary>
+		/// Add a depth stencil view that is not in the table yet.
+		/// </summary>
+		/// <param name="depthstencil">The depth stencil view to add.</param>
+		/// <param name="width">The width of the underlying texture.</param>
+		/// <param name="height">The height of the underlying texture.</param>
+		/// <param name="rejected">Whether this view can never be a depth source.</param>
+		void insert(T *depthstencil, unsigned int width, unsigned int height, bool rejected)
+		{
+			table *current = _current.load(std::memory_order_relaxed);
+
+			if ((_size + 1) * 4 > current->capacity * 3)
+			{
+				current = grow(current->capacity * 2);
+			}
+
+			insert(*current, reinterpret_cast<uintptr_t>(depthstencil), width, height, rejected, 0, 0);
+
+			_size++;
+		}
+		/// <summary>
+		/// Remove a depth stencil view from the table.
+		/// </summary>
+		/// <param name="depthstencil">The depth stencil view to remove.</param>
+		void erase(T *depthstencil)
+		{
+			const auto key = reinterpret_cast<uintptr_t>(depthstencil);
+			table &current = *_current.load(std::memory_order_relaxed);
+
+			for (size_t i = 0, index = hash(key); i < current.capacity; i++, index++)
+			{
+				auto &slot = current.slots[index & (current.capacity - 1)];
+				const auto slot_key = slot.key.load(std::memory_order_relaxed);
+
+				if (slot_key == key)
+				{
+					slot.key.store(tombstone_key, std::memory_order_release);
+					_size--;
+					break;
+				}
+				if (slot_key == empty_key)
+				{
+					break;
+				}
+			}
+		}
+		/// <summary>
+		/// Remove all depth stencil views from the table.
+		/// </summary>
+		void clear()
+		{
+			table &current = *_current.load(std::memory_order_relaxed);
+
+			for (size_t i = 0; i < current.capacity; i++)
+			{
+				current.slots[i].key.store(empty_key, std::memory_order_release);
+			}
+
+			_size = 0;
+		}
+
+		/// <summary>
+		/// Call a function for every depth stencil view in the table.
+		/// </summary>
+		/// <param name="func">The function to call with the depth stencil view and a reference to its statistics.</param>
+		template <typename F>
+		void for_each(F func)
+		{
+			table &current = *_current.load(std::memory_order_acquire);
+
+			for (size_t i = 0; i < current.capacity; i++)
+			{
+				auto &slot = current.slots[i];
+				const auto key = slot.key.load(std::memory_order_acquire);
+
+				if (key != empty_key && key != tombstone_key)
+				{
+					func(reinterpret_cast<T *>(key), slot.info);
+				}
+			}
+		}
+
+		bool empty() const { return _size == 0; }
+		size_t size() const { return _size; }
+		size_t capacity() const { return _current.load(std::memory_order_relaxed)->capacity; }
+
+	private:
+		static const uintptr_t empty_key = 0, tombstone_key = 1;
+
+		struct slot
+		{
+			std::atomic<uintptr_t> key = empty_key;
+			depth_source_info info;
+		};
+		struct table
+		{
+			explicit table(size_t capacity) : capacity(capacity), slots(new slot[capacity]) { }
+
+			const size_t capacity; // Must be a power of two
+			const std::unique_ptr<slot[]> slots;
+		};
+
+		static size_t hash(uintptr_t key)
+		{
+			// Objects are at least 16 byte aligned, so the lowest bits carry no information
+			return static_cast<size_t>((static_cast<uint64_t>(key >> 4) * 0x9E3779B97F4A7C15ull) >> 32);
+		}
+		static void insert(table &target, uintptr_t key, unsigned int width, unsigned int height, bool rejected, unsigned int drawcall_count, unsigned int vertices_count)
+		{
+			for (size_t index = hash(key);; index++)
+			{
+				auto &slot = target.slots[index & (target.capacity - 1)];
+				const auto slot_key = slot.key.load(std::memory_order_relaxed);
+
+				if (slot_key != empty_key && slot_key != tombstone_key)
+				{
+					continue;
+				}
+
+				slot.info.width = width;
+				slot.info.height = height;
+				slot.info.rejected = rejected;
+				slot.info.drawcall_count.store(drawcall_count, std::memory_order_relaxed);
+				slot.info.vertices_count.store(vertices_count, std::memory_order_relaxed);
+
+				// Publish the key last, so that a thread finding it also sees the information above
+				slot.key.store(key, std::memory_order_release);
+				break;
+			}
+		}
+
+		table *grow(size_t capacity)
+		{
+			const table &current = *_current.load(std::memory_order_relaxed);
+			auto replacement = std::make_unique<table>(capacity);
+
+			// Only live entries are copied, so this also gets rid of all tombstones
+			for (size_t i = 0; i < current.capacity; i++)
+			{
+				const auto &slot = current.slots[i];
+				const auto key = slot.key.load(std::memory_order_relaxed);
+
+				if (key != empty_key && key != tombstone_key)
+				{
+					insert(*replacement, key, slot.info.width, slot.info.height, slot.info.rejected, slot.info.drawcall_count.load(std::memory_order_relaxed), slot.info.vertices_count.load(std::memory_order_relaxed));
+				}
+			}
+
+			_tables.push_back(std::move(replacement));
+			_current.store(_tables.back().get(), std::memory_order_release);
+
+			return _tables.back().get();
+		}
+
+		std::atomic<table *> _current;
+		std::vector<std::unique_ptr<table>> _tables; // Every table that was ever current, the last one is the current one. Older ones are kept alive for lookups that may still be searching them
+		size_t _size = 0;
+	};
+}
@@ -4,6 +4,7 @@
  */
 
 #include "log.hpp"
+#include "ini_file.hpp"
 #include "filesystem.hpp"
 #include "input.hpp"
 #include "runtime.hpp"
@@ -11,6 +12,7 @@
 #include "dllmodule.hpp"
 #include "version.h"
 #include <Windows.h>
+#include <algorithm>
 
 HMODULE g_module_handle = nullptr;
 
@@ -27,9 +29,21 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpvReserved)
 			g_module_handle = hModule;
 			runtime::s_reshade_dll_path = filesystem::get_module_path(hModule);
 			runtime::s_target_executable_path = filesystem::get_module_path(nullptr);
+			runtime::s_configuration_path = filesystem::path(runtime::s_reshade_dll_path).replace_extension(".ini");
+			if (!filesystem::exists(runtime::s_configuration_path))
+				runtime::s_configuration_path = runtime::s_reshade_dll_path.parent_path() / "ReShade.ini";
 
 			log::open(filesystem::path(runtime::s_reshade_dll_path).replace_extension(".log"));
 
+			// Apply the log level before anything is logged, so that it covers initialization too (0 = everything, 1 = warnings and errors, 2 = errors only)
+			{
+				int log_level = 0;
+				ini_file(runtime::s_configuration_path).get("GENERAL", "LogLevel", log_level);
+
+				const log::level levels[] = { log::level::info, log::level::warning, log::level::error };
+				log::set_level(levels[std::min(std::max(log_level, 0), 2)]);
+			}
+
 #ifdef WIN64
 			LOG(INFO) << "Initializing crosire's ReShade version '" VERSION_STRING_FILE "' (64-bit) built on '" VERSION_DATE " " VERSION_TIME "' loaded from " << runtime::s_reshade_dll_path << " to " << runtime::s_target_executable_path << " ...";
 #else
@@ -58,6 +72,8 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpvReserved)
 			hooks::uninstall();
 
 			LOG(INFO) << "Exited.";
+
+			log::close();
 			break;
 		}
 	}
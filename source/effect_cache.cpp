@@ -0,0 +1,179 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "log.hpp"
+#include "effect_cache.hpp"
+#include <fstream>
+
+namespace reshade
+{
+	namespace
+	{
+		const uint32_t cache_magic = 0x43505352; // "RSPC"
+		const uint32_t cache_version = 1;
+
+		bool read_file(const filesystem::path &path, std::string &data)
+		{
+			std::ifstream file(path.wstring(), std::ios::in | std::ios::binary);
+
+			if (!file.is_open())
+			{
+				return false;
+			}
+
+			data.assign(std::istreambuf_iterator<char>(file.rdbuf()), std::istreambuf_iterator<char>());
+
+			return true;
+		}
+		bool hash_file(const filesystem::path &path, uint64_t &hash)
+		{
+			std::string data;
+
+			if (!read_file(path, data))
+			{
+				return false;
+			}
+
+			hash = effect_cache::hash(data);
+
+			return true;
+		}
+
+		template <typename T>
+		inline void write(std::ofstream &stream, const T &value)
+		{
+			stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+		}
+		inline void write(std::ofstream &stream, const std::string &value)
+		{
+			write(stream, static_cast<uint64_t>(value.size()));
+			stream.write(value.data(), value.size());
+		}
+		template <typename T>
+		inline bool read(std::ifstream &stream, T &value)
+		{
+			return !!stream.read(reinterpret_cast<char *>(&value), sizeof(T));
+		}
+		inline bool read(std::ifstream &stream, std::string &value)
+		{
+			uint64_t size = 0;
+
+			if (!read(stream, size) || size > 0x7FFFFFFF)
+			{
+				return false;
+			}
+
+			value.resize(static_cast<size_t>(size));
+
+			return !!stream.read(&value[0], value.size());
+		}
+	}
+
+	bool effect_cache::load(const filesystem::path &source_file, const std::string &environment, std::string &output) const
+	{
+		if (_directory.empty())
+		{
+			return false;
+		}
+
+		const uint64_t environment_hash = hash(environment);
+
+		std::ifstream file(entry_path(source_file, environment_hash).wstring(), std::ios::in | std::ios::binary);
+
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		uint32_t magic = 0, version = 0, dependency_count = 0;
+		uint64_t cached_environment_hash = 0, cached_source_hash = 0, source_hash = 0;
+
+		if (!read(file, magic) || magic != cache_magic ||
+			!read(file, version) || version != cache_version ||
+			!read(file, cached_environment_hash) || cached_environment_hash != environment_hash ||
+			!read(file, cached_source_hash) || !hash_file(source_file, source_hash) || cached_source_hash != source_hash ||
+			!read(file, dependency_count))
+		{
+			return false;
+		}
+
+		// Any change to an included file invalidates the entry
+		for (uint32_t i = 0; i < dependency_count; i++)
+		{
+			std::string dependency_path;
+			uint64_t cached_dependency_hash = 0, dependency_hash = 0;
+
+			if (!read(file, dependency_path) || !read(file, cached_dependency_hash) ||
+				!hash_file(dependency_path, dependency_hash) || cached_dependency_hash != dependency_hash)
+			{
+				return false;
+			}
+		}
+
+		return read(file, output);
+	}
+	void effect_cache::save(const filesystem::path &source_file, const std::string &environment, const std::vector<filesystem::path> &included_files, const std::string &output) const
+	{
+		if (_directory.empty())
+		{
+			return;
+		}
+
+		uint64_t source_hash = 0;
+
+		if (!hash_file(source_file, source_hash))
+		{
+			return;
+		}
+
+		std::vector<uint64_t> dependency_hashes(included_files.size());
+
+		for (size_t i = 0; i < included_files.size(); i++)
+		{
+			if (!hash_file(included_files[i], dependency_hashes[i]))
+			{
+				return;
+			}
+		}
+
+		if (!filesystem::exists(_directory) && !filesystem::create_directory(_directory))
+		{
+			LOG(WARNING) << "Failed to create effect cache directory " << _directory << ".";
+			return;
+		}
+
+		const uint64_t environment_hash = hash(environment);
+		const filesystem::path path = entry_path(source_file, environment_hash);
+
+		std::ofstream file(path.wstring(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open())
+		{
+			return;
+		}
+
+		write(file, cache_magic);
+		write(file, cache_version);
+		write(file, environment_hash);
+		write(file, source_hash);
+		write(file, static_cast<uint32_t>(included_files.size()));
+
+		for (size_t i = 0; i < included_files.size(); i++)
+		{
+			write(file, included_files[i].string());
+			write(file, dependency_hashes[i]);
+		}
+
+		write(file, output);
+	}
+
+	filesystem::path effect_cache::entry_path(const filesystem::path &source_file, uint64_t environment_hash) const
+	{
+		char name[17];
+		sprintf_s(name, "%016llx", hash(source_file.string(), environment_hash));
+
+		return _directory / (source_file.filename_without_extension().string() + '-' + name + ".i");
+	}
+}
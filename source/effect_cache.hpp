@@ -0,0 +1,69 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <vector>
+#include "filesystem.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// A persistent on-disk cache of preprocessed effect source code.
+	/// This only skips the preprocessor. Parsing and code generation still run on every load, because the syntax tree is a graph of arena-allocated nodes that has no serialized form.
+	/// The expensive part of code generation, compiling the generated HLSL, is cached separately by <see cref="shader_cache"/>.
+	/// </summary>
+	class effect_cache
+	{
+	public:
+		/// <summary>
+		/// Calculate a 64-bit FNV-1a hash of a block of memory.
+		/// </summary>
+		/// <param name="data">The data to hash.</param>
+		/// <param name="size">The size of the data in bytes.</param>
+		/// <param name="seed">The hash to continue from.</param>
+		static uint64_t hash(const void *data, size_t size, uint64_t seed = 14695981039346656037ull)
+		{
+			uint64_t hash = seed;
+
+			for (auto it = static_cast<const unsigned char *>(data), end = it + size; it != end; ++it)
+			{
+				hash ^= *it;
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+		static uint64_t hash(const std::string &data, uint64_t seed = 14695981039346656037ull) { return hash(data.data(), data.size(), seed); }
+
+		/// <summary>
+		/// Set the directory that cache entries are stored in. An empty path disables the cache.
+		/// </summary>
+		/// <param name="path">The path to the cache directory.</param>
+		void set_directory(const filesystem::path &path) { _directory = path; }
+
+		/// <summary>
+		/// Look up the preprocessed output of an effect file.
+		/// </summary>
+		/// <param name="source_file">The path to the effect source code file.</param>
+		/// <param name="environment">A string describing everything else that influenced preprocessing (macro definitions, include paths, ...).</param>
+		/// <param name="output">The string to store the cached output in.</param>
+		/// <returns>A boolean value indicating whether a cache entry was found and neither the source file nor any of its included files changed since.</returns>
+		bool load(const filesystem::path &source_file, const std::string &environment, std::string &output) const;
+		/// <summary>
+		/// Store the preprocessed output of an effect file.
+		/// </summary>
+		/// <param name="source_file">The path to the effect source code file.</param>
+		/// <param name="environment">A string describing everything else that influenced preprocessing (macro definitions, include paths, ...).</param>
+		/// <param name="included_files">The list of files that were included while preprocessing.</param>
+		/// <param name="output">The preprocessed output to store.</param>
+		void save(const filesystem::path &source_file, const std::string &environment, const std::vector<filesystem::path> &included_files, const std::string &output) const;
+
+	private:
+		filesystem::path entry_path(const filesystem::path &source_file, uint64_t environment_hash) const;
+
+		filesystem::path _directory;
+	};
+}
@@ -0,0 +1,206 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_dependencies.hpp"
+
+namespace reshadefx
+{
+	using namespace nodes;
+
+	namespace
+	{
+		class dependency_walker
+		{
+		public:
+			explicit dependency_walker(std::unordered_set<const declaration_node *> &result) : _result(result) { }
+
+			void visit(const type_node &type)
+			{
+				if (!type.is_struct() || type.definition == nullptr || !_result.insert(type.definition).second)
+				{
+					return;
+				}
+
+				for (auto field : type.definition->field_list)
+				{
+					visit(field->type);
+				}
+			}
+			void visit(const variable_declaration_node *node)
+			{
+				if (node == nullptr || !_result.insert(node).second)
+				{
+					return;
+				}
+
+				visit(node->type);
+				visit(node->initializer_expression);
+
+				// Samplers refer to the texture declaration they read from
+				if (node->type.is_sampler())
+				{
+					visit(node->properties.texture);
+				}
+			}
+			void visit(const function_declaration_node *node)
+			{
+				if (node == nullptr || !_result.insert(node).second)
+				{
+					return;
+				}
+
+				visit(node->return_type);
+
+				for (auto parameter : node->parameter_list)
+				{
+					visit(parameter);
+				}
+
+				visit(node->definition);
+			}
+			void visit(const expression_node *node)
+			{
+				if (node == nullptr)
+				{
+					return;
+				}
+
+				visit(node->type);
+
+				switch (node->id)
+				{
+					case nodeid::lvalue_expression:
+						visit(static_cast<const lvalue_expression_node *>(node)->reference);
+						break;
+					case nodeid::unary_expression:
+						visit(static_cast<const unary_expression_node *>(node)->operand);
+						break;
+					case nodeid::binary_expression:
+						for (auto operand : static_cast<const binary_expression_node *>(node)->operands)
+							visit(operand);
+						break;
+					case nodeid::intrinsic_expression:
+						for (auto argument : static_cast<const intrinsic_expression_node *>(node)->arguments)
+							visit(argument);
+						break;
+					case nodeid::conditional_expression:
+						visit(static_cast<const conditional_expression_node *>(node)->condition);
+						visit(static_cast<const conditional_expression_node *>(node)->expression_when_true);
+						visit(static_cast<const conditional_expression_node *>(node)->expression_when_false);
+						break;
+					case nodeid::assignment_expression:
+						visit(static_cast<const assignment_expression_node *>(node)->left);
+						visit(static_cast<const assignment_expression_node *>(node)->right);
+						break;
+					case nodeid::expression_sequence:
+						for (auto expression : static_cast<const expression_sequence_node *>(node)->expression_list)
+							visit(expression);
+						break;
+					case nodeid::call_expression:
+						visit(static_cast<const call_expression_node *>(node)->callee);
+						for (auto argument : static_cast<const call_expression_node *>(node)->arguments)
+							visit(argument);
+						break;
+					case nodeid::constructor_expression:
+						for (auto argument : static_cast<const constructor_expression_node *>(node)->arguments)
+							visit(argument);
+						break;
+					case nodeid::swizzle_expression:
+						visit(static_cast<const swizzle_expression_node *>(node)->operand);
+						break;
+					case nodeid::field_expression:
+						visit(static_cast<const field_expression_node *>(node)->operand);
+						break;
+					case nodeid::initializer_list:
+						for (auto value : static_cast<const initializer_list_node *>(node)->values)
+							visit(value);
+						break;
+					default:
+						break;
+				}
+			}
+			void visit(const statement_node *node)
+			{
+				if (node == nullptr)
+				{
+					return;
+				}
+
+				switch (node->id)
+				{
+					case nodeid::compound_statement:
+						for (auto statement : static_cast<const compound_statement_node *>(node)->statement_list)
+							visit(statement);
+						break;
+					case nodeid::declarator_list:
+						for (auto declarator : static_cast<const declarator_list_node *>(node)->declarator_list)
+							visit(declarator);
+						break;
+					case nodeid::expression_statement:
+						visit(static_cast<const expression_statement_node *>(node)->expression);
+						break;
+					case nodeid::if_statement:
+						visit(static_cast<const if_statement_node *>(node)->condition);
+						visit(static_cast<const if_statement_node *>(node)->statement_when_true);
+						visit(static_cast<const if_statement_node *>(node)->statement_when_false);
+						break;
+					case nodeid::switch_statement:
+						visit(static_cast<const switch_statement_node *>(node)->test_expression);
+						for (auto case_statement : static_cast<const switch_statement_node *>(node)->case_list)
+							visit(case_statement);
+						break;
+					case nodeid::case_statement:
+						visit(static_cast<const case_statement_node *>(node)->statement_list);
+						break;
+					case nodeid::for_statement:
+						visit(static_cast<const for_statement_node *>(node)->init_statement);
+						visit(static_cast<const for_statement_node *>(node)->condition);
+						visit(static_cast<const for_statement_node *>(node)->increment_expression);
+						visit(static_cast<const for_statement_node *>(node)->statement_list);
+						break;
+					case nodeid::while_statement:
+						visit(static_cast<const while_statement_node *>(node)->condition);
+						visit(static_cast<const while_statement_node *>(node)->statement_list);
+						break;
+					case nodeid::return_statement:
+						visit(static_cast<const return_statement_node *>(node)->return_value);
+						break;
+					default:
+						break;
+				}
+			}
+
+		private:
+			std::unordered_set<const declaration_node *> &_result;
+		};
+	}
+
+	std::unordered_set<const declaration_node *> find_dependencies(const function_declaration_node *entry_point)
+	{
+		std::unordered_set<const declaration_node *> result;
+
+		dependency_walker(result).visit(entry_point);
+
+		return result;
+	}
+	std::string extract_dependencies(const function_declaration_node *entry_point, const std::string &code, const std::vector<global_declaration> &declarations)
+	{
+		const auto dependencies = find_dependencies(entry_point);
+		std::string result;
+
+		for (size_t i = 0; i < declarations.size(); i++)
+		{
+			const size_t offset = declarations[i].offset;
+			const size_t end = i + 1 < declarations.size() ? declarations[i + 1].offset : code.size();
+
+			if (dependencies.count(declarations[i].node) != 0)
+			{
+				result.append(code, offset, end - offset);
+			}
+		}
+
+		return result;
+	}
+}
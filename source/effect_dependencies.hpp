@@ -0,0 +1,38 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "effect_syntax_tree_nodes.hpp"
+#include <vector>
+#include <unordered_set>
+
+namespace reshadefx
+{
+	/// <summary>
+	/// Collect all declarations a shader entry point uses, either directly or through any of the functions it calls.
+	/// </summary>
+	/// <param name="entry_point">The entry point function to start from.</param>
+	/// <returns>The set of struct, variable and function declarations reachable from the entry point, including the entry point itself.</returns>
+	std::unordered_set<const nodes::declaration_node *> find_dependencies(const nodes::function_declaration_node *entry_point);
+
+	/// <summary>
+	/// The position of a global declaration in a block of generated code. Its code ends where the code of the next one starts.
+	/// </summary>
+	struct global_declaration
+	{
+		const nodes::declaration_node *node;
+		size_t offset;
+	};
+
+	/// <summary>
+	/// Extract the code of those global declarations a shader entry point uses, so that the shader compiler does not have to parse and strip all the others.
+	/// </summary>
+	/// <param name="entry_point">The entry point function to start from.</param>
+	/// <param name="code">The generated code of all global declarations.</param>
+	/// <param name="declarations">The positions of the global declarations in <paramref name="code"/>, in ascending order.</param>
+	/// <returns>The code of all declarations reachable from the entry point, in their original order.</returns>
+	std::string extract_dependencies(const nodes::function_declaration_node *entry_point, const std::string &code, const std::vector<global_declaration> &declarations);
+}
@@ -4,7 +4,9 @@
  */
 
 #include "effect_lexer.hpp"
-#include <unordered_map>
+#include <assert.h>
+#include <string.h>
+#include <type_traits>
 
 namespace reshadefx
 {
@@ -32,7 +34,30 @@ namespace reshadefx
 			IDENT, IDENT, IDENT, IDENT, IDENT, IDENT, IDENT, IDENT, IDENT, IDENT,
 			IDENT, IDENT, IDENT,   '{',   '|',   '}',   '~',  0x00,  0x00,  0x00,
 		};
-		const std::unordered_map<std::string, tokenid> keyword_lookup = {
+
+		struct keyword
+		{
+			template <size_t N>
+			constexpr keyword(const char(&name)[N], tokenid id) : name(name), length(N - 1), id(id) { }
+
+			const char *name;
+			size_t length;
+			tokenid id;
+		};
+
+		constexpr uint32_t hash_string(const char *data, size_t length, uint32_t seed)
+		{
+			uint32_t hash = 2166136261u ^ seed;
+
+			for (size_t i = 0; i < length; ++i)
+			{
+				hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+			}
+
+			return hash;
+		}
+
+		constexpr keyword keywords[] = {
 			{ "asm", tokenid::reserved },
 			{ "asm_fragment", tokenid::reserved },
 			{ "auto", tokenid::reserved },
@@ -195,7 +220,72 @@ namespace reshadefx
 			{ "volatile", tokenid::volatile_ },
 			{ "while", tokenid::while_ }
 		};
-		const std::unordered_map<std::string, tokenid> pp_directive_lookup = {
+
+		// Keywords are looked up with a two-level perfect hash: The first hash of a word selects one of the buckets below and the seed stored in that bucket is used to hash the word a second time, which gives its slot in the keyword table.
+		// The bucket seeds were searched offline so that no two keywords end up in the same slot. This is verified at compile time, so adding a keyword that collides requires searching new seeds.
+		constexpr uint32_t keyword_bucket_seeds[64] = {
+			 2,  1,  1,  2,  1,  1,  3,  7,  1,  2,  1,  2,  1,  6,  1,  1,
+			 4,  3,  7,  3,  2,  1,  2,  5,  6,  3,  2,  6,  4,  3,  1,  2,
+			 2,  1,  1,  1,  1,  5, 14,  1,  0,  1,  1,  4,  7,  1,  0,  4,
+			 3,  2,  1,  4,  1,  2,  0, 11,  1,  1,  1,  1, 10,  1,  4,  2
+		};
+
+		constexpr size_t keyword_slot(const char *name, size_t length)
+		{
+			return hash_string(name, length, keyword_bucket_seeds[hash_string(name, length, 0) % _countof(keyword_bucket_seeds)]) % 256;
+		}
+
+		struct keyword_table
+		{
+			unsigned char slots[256];
+		};
+
+		constexpr keyword_table build_keyword_table()
+		{
+			keyword_table table = { };
+
+			for (size_t i = 0; i < _countof(table.slots); ++i)
+			{
+				table.slots[i] = 0xFF;
+			}
+			for (size_t i = 0; i < _countof(keywords); ++i)
+			{
+				table.slots[keyword_slot(keywords[i].name, keywords[i].length)] = static_cast<unsigned char>(i);
+			}
+
+			return table;
+		}
+		constexpr bool is_perfect_keyword_table(const keyword_table &table)
+		{
+			for (size_t i = 0; i < _countof(keywords); ++i)
+			{
+				if (table.slots[keyword_slot(keywords[i].name, keywords[i].length)] != i)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		constexpr keyword_table keyword_lookup = build_keyword_table();
+
+		static_assert(_countof(keywords) < 0xFF, "too many keywords for the keyword table");
+		static_assert(is_perfect_keyword_table(keyword_lookup), "keyword hash has collisions, new bucket seeds need to be searched");
+		static_assert(std::is_trivially_copyable<token>::value, "tokens are copied a lot by the preprocessor and parser and should stay plain data");
+
+		tokenid find_keyword(const char *name, size_t length)
+		{
+			const auto index = keyword_lookup.slots[keyword_slot(name, length)];
+
+			if (index < _countof(keywords) && keywords[index].length == length && memcmp(keywords[index].name, name, length) == 0)
+			{
+				return keywords[index].id;
+			}
+
+			return tokenid::identifier;
+		}
+		constexpr keyword pp_directives[] = {
 			{ "define", tokenid::hash_def },
 			{ "undef", tokenid::hash_undef },
 			{ "if", tokenid::hash_if },
@@ -258,34 +348,108 @@ namespace reshadefx
 		}
 	}
 
-	lexer::lexer(const std::string &source, bool ignore_whitespace, bool ignore_pp_directives, bool ignore_keywords, bool escape_string_literals) :
-		_input(source),
+	string_table::string_table() : _slots(1024)
+	{
+	}
+
+	const std::string *string_table::intern(const char *begin, const char *end)
+	{
+		const size_t length = end - begin;
+		const uint32_t hash = hash_string(begin, length, 0);
+		size_t index = probe(hash, begin, length);
+
+		if (_slots[index].string != nullptr)
+		{
+			return _slots[index].string;
+		}
+
+		// Keep the load factor below one half so that probe sequences stay short
+		if ((_strings.size() + 1) * 2 > _slots.size())
+		{
+			std::vector<slot> slots(_slots.size() * 2);
+			_slots.swap(slots);
+
+			for (const auto &slot : slots)
+			{
+				if (slot.string != nullptr)
+				{
+					_slots[probe(slot.hash, slot.string->data(), slot.string->size())] = slot;
+				}
+			}
+
+			index = probe(hash, begin, length);
+		}
+
+		_strings.emplace_back(begin, end);
+
+		_slots[index].hash = hash;
+		_slots[index].string = &_strings.back();
+
+		return _slots[index].string;
+	}
+	const std::string *string_table::find(const char *begin, const char *end) const
+	{
+		const size_t length = end - begin;
+
+		return _slots[probe(hash_string(begin, length, 0), begin, length)].string;
+	}
+	size_t string_table::probe(uint32_t hash, const char *begin, size_t length) const
+	{
+		const size_t mask = _slots.size() - 1;
+
+		for (size_t index = hash & mask;; index = (index + 1) & mask)
+		{
+			const auto &slot = _slots[index];
+
+			if (slot.string == nullptr || (slot.hash == hash && slot.string->size() == length && memcmp(slot.string->data(), begin, length) == 0))
+			{
+				return index;
+			}
+		}
+	}
+
+	lexer::lexer(const std::string &source, bool ignore_whitespace, bool ignore_pp_directives, bool ignore_keywords, bool escape_string_literals, std::shared_ptr<string_table> strings) :
+		lexer(std::make_shared<const std::string>(source), ignore_whitespace, ignore_pp_directives, ignore_keywords, escape_string_literals, std::move(strings))
+	{
+	}
+	lexer::lexer(std::shared_ptr<const std::string> source, bool ignore_whitespace, bool ignore_pp_directives, bool ignore_keywords, bool escape_string_literals, std::shared_ptr<string_table> strings) :
+		_input(std::move(source)),
+		_strings(strings != nullptr ? std::move(strings) : std::make_shared<string_table>()),
+		_cur_line(1),
+		_cur_column(1),
 		_ignore_whitespace(ignore_whitespace),
 		_ignore_pp_directives(ignore_pp_directives),
 		_ignore_keywords(ignore_keywords),
 		_escape_string_literals(escape_string_literals)
 	{
-		_cur = _input.data();
-		_end = _cur + _input.size();
+		_cur = _input->data();
+		_end = _cur + _input->size();
+		_cur_source = _strings->intern(std::string());
 	}
 	lexer::lexer(const lexer &lexer) :
 		_input(lexer._input),
-		_cur_location(lexer._cur_location),
+		_strings(lexer._strings),
+		_cur_source(lexer._cur_source),
+		_cur_line(lexer._cur_line),
+		_cur_column(lexer._cur_column),
+		_cur(lexer._cur),
+		_end(lexer._end),
 		_ignore_whitespace(lexer._ignore_whitespace),
 		_ignore_pp_directives(lexer._ignore_pp_directives),
 		_ignore_keywords(lexer._ignore_keywords),
 		_escape_string_literals(lexer._escape_string_literals)
 	{
-		_cur = _input.data() + (lexer._cur - lexer._input.data());
-		_end = _input.data() + _input.size();
 	}
 
 	lexer &lexer::operator=(const lexer &lexer)
 	{
 		_input = lexer._input;
-		_cur_location = lexer._cur_location;
-		_cur = _input.data() + (lexer._cur - lexer._input.data());
-		_end = _input.data() + _input.size();
+		_strings = lexer._strings;
+		_cur_source = lexer._cur_source;
+		_cur_line = lexer._cur_line;
+		_cur_column = lexer._cur_column;
+		_cur = lexer._cur;
+		_end = lexer._end;
 		_ignore_whitespace = lexer._ignore_whitespace;
 		_ignore_pp_directives = lexer._ignore_pp_directives;
 		_ignore_keywords = lexer._ignore_keywords;
@@ -294,13 +458,29 @@ namespace reshadefx
 		return *this;
 	}
 
+	lexer::state lexer::save() const
+	{
+		return { _cur_source, _cur_line, _cur_column, static_cast<size_t>(_cur - _input->data()) };
+	}
+	void lexer::restore(const state &state)
+	{
+		assert(state.offset <= _input->size());
+
+		_cur = _input->data() + state.offset;
+		_cur_source = state.source;
+		_cur_line = state.line;
+		_cur_column = state.column;
+	}
+
 	token lexer::lex()
 	{
-		bool is_at_line_begin = _cur_location.column <= 1;
+		bool is_at_line_begin = _cur_column <= 1;
 		token tok;
 	next_token:
-		tok.location = _cur_location;
-		tok.offset = _cur - _input.data();
+		tok.source = _cur_source;
+		tok.line = _cur_line;
+		tok.column = _cur_column;
+		tok.offset = _cur - _input->data();
 		tok.length = 1;
 		tok.literal_as_double = 0;
 
@@ -317,8 +497,8 @@ namespace reshadefx
 				return tok;
 			case '\n':
 				_cur++;
-				_cur_location.line++;
-				_cur_location.column = 1;
+				_cur_line++;
+				_cur_column = 1;
 				is_at_line_begin = true;
 				if (_ignore_whitespace)
 					goto next_token;
@@ -432,8 +612,8 @@ namespace reshadefx
 					{
 						if (*_cur == '\n')
 						{
-							_cur_location.line++;
-							_cur_location.column = 1;
+							_cur_line++;
+							_cur_column = 1;
 						}
 						else if (_cur[0] == '*' && _cur[1] == '/')
 						{
@@ -549,7 +729,7 @@ namespace reshadefx
 	void lexer::skip(size_t length)
 	{
 		_cur += length;
-		_cur_location.column += static_cast<unsigned int>(length);
+		_cur_column += static_cast<unsigned int>(length);
 	}
 	void lexer::skip_space()
 	{
@@ -574,19 +754,18 @@ namespace reshadefx
 
 		tok.id = tokenid::identifier;
 		tok.length = end - begin;
-		tok.literal_as_string.assign(begin, end);
 
-		if (_ignore_keywords)
+		if (!_ignore_keywords)
 		{
-			return;
-		}
-
-		const auto it = keyword_lookup.find(tok.literal_as_string);
+			tok.id = find_keyword(begin, tok.length);
 
-		if (it != keyword_lookup.end())
-		{
-			tok.id = it->second;
+			if (tok.id != tokenid::identifier)
+			{
+				return;
+			}
 		}
+
+		tok.literal_as_identifier = _strings->intern(begin, end);
 	}
 	bool lexer::parse_pp_directive(token &tok)
 	{
@@ -594,26 +773,28 @@ namespace reshadefx
 		skip_space();
 		parse_identifier(tok);
 
-		const auto it = pp_directive_lookup.find(tok.literal_as_string);
-
-		if (it != pp_directive_lookup.end())
+		for (const auto &directive : pp_directives)
 		{
-			tok.id = it->second;
+			if (directive.length == tok.length && memcmp(directive.name, _cur, tok.length) == 0)
+			{
+				tok.id = directive.id;
 
-			return true;
+				return true;
+			}
 		}
-		else if (tok.literal_as_string == "line")
+
+		if (tok.length == 4 && memcmp(_cur, "line", 4) == 0)
 		{
 			skip(tok.length);
 			skip_space();
 			parse_numeric_literal(tok);
 			skip(tok.length);
 
-			_cur_location.line = tok.literal_as_int;
+			_cur_line = tok.literal_as_int;
 
-			if (_cur_location.line != 0)
+			if (_cur_line != 0)
 			{
-				_cur_location.line--;
+				_cur_line--;
 			}
 
 			skip_space();
@@ -623,7 +804,7 @@ namespace reshadefx
 				token temptok;
 				parse_string_literal(temptok, false);
 
-				_cur_location.source = temptok.literal_as_string;
+				_cur_source = temptok.literal_as_string;
 			}
 
 			return false;
@@ -636,6 +817,7 @@ namespace reshadefx
 	void lexer::parse_string_literal(token &tok, bool escape) const
 	{
 		auto *const begin = _cur, *end = begin + 1;
+		std::string value;
 
 		for (char c = *end; c != '"'; c = *++end)
 		{
@@ -709,11 +891,12 @@ namespace reshadefx
 				}
 			}
 
-			tok.literal_as_string += c;
+			value += c;
 		}
 
 		tok.id = tokenid::string_literal;
 		tok.length = end - begin + 1;
+		tok.literal_as_string = _strings->intern(value);
 	}
 	void lexer::parse_numeric_literal(token &tok) const
 	{
@@ -5,6 +5,10 @@
 
 #pragma once
 
+#include <deque>
+#include <memory>
+#include <vector>
+#include <stdint.h>
 #include "source_location.hpp"
 
 namespace reshadefx
@@ -167,13 +171,53 @@ namespace reshadefx
 		hash_unknown,
 	};
 
+	/// <summary>
+	/// A table of unique strings. Every distinct string is stored once and keeps its address for the lifetime of the table, so interned strings can be compared by pointer.
+	/// </summary>
+	class string_table
+	{
+	public:
+		string_table();
+
+		/// <summary>
+		/// Add a string to the table if it is not in there yet.
+		/// </summary>
+		/// <returns>A pointer to the unique copy of the string in the table.</returns>
+		const std::string *intern(const char *begin, const char *end);
+		const std::string *intern(const std::string &string) { return intern(string.data(), string.data() + string.size()); }
+		/// <summary>
+		/// Look up a string without adding it to the table.
+		/// </summary>
+		/// <returns>A pointer to the unique copy of the string in the table, or <c>nullptr</c> if it was never interned.</returns>
+		const std::string *find(const char *begin, const char *end) const;
+		const std::string *find(const std::string &string) const { return find(string.data(), string.data() + string.size()); }
+
+		/// <summary>
+		/// Returns the number of unique strings in the table.
+		/// </summary>
+		size_t size() const { return _strings.size(); }
+
+	private:
+		struct slot
+		{
+			uint32_t hash;
+			const std::string *string;
+		};
+
+		size_t probe(uint32_t hash, const char *begin, size_t length) const;
+
+		std::vector<slot> _slots;
+		std::deque<std::string> _strings;
+	};
+
 	/// <summary>
 	/// A structure describing a single token in the input string.
 	/// </summary>
 	struct token
 	{
 		tokenid id;
-		location location;
+		const std::string *source;
+		unsigned int line, column;
 		size_t offset, length;
 		union
 		{
@@ -181,10 +225,16 @@ namespace reshadefx
 			unsigned int literal_as_uint;
 			float literal_as_float;
 			double literal_as_double;
+			const std::string *literal_as_identifier;
+			const std::string *literal_as_string;
 		};
-		std::string literal_as_string;
 
 		inline operator tokenid() const { return id; }
+
+		/// <summary>
+		/// Get the full location of this token in the source code.
+		/// </summary>
+		inline reshadefx::location location() const { return reshadefx::location(*source, line, column); }
 	};
 
 	/// <summary>
@@ -193,18 +243,42 @@ namespace reshadefx
 	class lexer
 	{
 	public:
+		/// <summary>
+		/// A snapshot of the position of a lexical analyzer in its input string.
+		/// </summary>
+		struct state
+		{
+			const std::string *source;
+			unsigned int line, column;
+			size_t offset;
+		};
+
 		/// <summary>
 		/// Construct a new lexical analyzer for an input string.
 		/// </summary>
-		/// <param name="source">The string to analyze.</param>
+		/// <param name="input">The string to analyze.</param>
+		/// <param name="strings">The table to intern identifiers, string literals and source file names into. A new one is created if this is <c>nullptr</c>.</param>
 		explicit lexer(
 			const std::string &input,
 			bool ignore_whitespace = true,
 			bool ignore_pp_directives = true,
 			bool ignore_keywords = false,
-			bool escape_string_literals = true);
+			bool escape_string_literals = true,
+			std::shared_ptr<string_table> strings = nullptr);
+		/// <summary>
+		/// Construct a new lexical analyzer for an input string that is shared with other instances.
+		/// </summary>
+		/// <param name="input">The string to analyze. It must not be modified while any lexical analyzer references it.</param>
+		/// <param name="strings">The table to intern identifiers, string literals and source file names into. A new one is created if this is <c>nullptr</c>.</param>
+		explicit lexer(
+			std::shared_ptr<const std::string> input,
+			bool ignore_whitespace = true,
+			bool ignore_pp_directives = true,
+			bool ignore_keywords = false,
+			bool escape_string_literals = true,
+			std::shared_ptr<string_table> strings = nullptr);
 		/// <summary>
-		/// Construct a copy of an existing instance.
+		/// Construct a copy of an existing instance. The copy shares the input string with the original.
 		/// </summary>
 		/// <param name="lexer">The instance to copy.</param>
 		lexer(const lexer &lexer);
@@ -214,7 +288,22 @@ namespace reshadefx
 		/// Get the input string this lexical analyzer works on.
 		/// </summary>
 		/// <returns>A constant reference to the input string.</returns>
-		inline const std::string &input_string() const { return _input; }
+		inline const std::string &input_string() const { return *_input; }
+		/// <summary>
+		/// Get the table identifiers, string literals and source file names are interned into. It is shared with all copies of this instance.
+		/// </summary>
+		inline const std::shared_ptr<string_table> &strings() const { return _strings; }
+
+		/// <summary>
+		/// Save the current position in the input string, so that it can be returned to later.
+		/// </summary>
+		/// <returns>The current state of the lexical analyzer.</returns>
+		state save() const;
+		/// <summary>
+		/// Return to a position in the input string that was previously saved.
+		/// </summary>
+		/// <param name="state">The state to return to.</param>
+		void restore(const state &state);
 
 		/// <summary>
 		/// Perform lexical analysis on the input string and return the next token in sequence.
@@ -243,8 +332,10 @@ namespace reshadefx
 		void parse_string_literal(token &tok, bool escape) const;
 		void parse_numeric_literal(token &tok) const;
 
-		std::string _input;
-		location _cur_location;
+		std::shared_ptr<const std::string> _input;
+		std::shared_ptr<string_table> _strings;
+		const std::string *_cur_source;
+		unsigned int _cur_line, _cur_column;
 		const std::string::value_type *_cur, *_end;
 		bool _ignore_whitespace;
 		bool _ignore_pp_directives;
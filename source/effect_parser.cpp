@@ -252,7 +252,8 @@ namespace reshadefx
 
 	parser::parser(syntax_tree &ast) :
 		_ast(ast),
-		_symbol_table(new symbol_table())
+		_strings(std::make_shared<string_table>()),
+		_symbol_table(new symbol_table(_strings))
 	{
 	}
 	parser::~parser()
@@ -261,10 +262,20 @@ namespace reshadefx
 
 	bool parser::run(const std::string &input)
 	{
-		_lexer.reset(new lexer(input));
-		_lexer_backup.reset();
+		lexer input_lexer(input, true, true, false, true, _strings);
 
-		consume();
+		// Run lexical analysis on the entire input up front, so that backtracking is just a matter of resetting the token index
+		_tokens.clear();
+		_tokens.reserve(input.size() / 4);
+
+		do
+		{
+			_tokens.push_back(input_lexer.lex());
+		}
+		while (_tokens.back() != tokenid::end_of_file);
+
+		_token_index = 0;
+		_token_next = _tokens[0];
 
 		while (!peek(tokenid::end_of_file))
 		{
@@ -312,14 +323,12 @@ namespace reshadefx
 	// Input management
 	void parser::backup()
 	{
-		_lexer.swap(_lexer_backup);
-		_lexer.reset(new lexer(*_lexer_backup));
-		_token_backup = _token_next;
+		_token_backup_index = _token_index;
 	}
 	void parser::restore()
 	{
-		_lexer.swap(_lexer_backup);
-		_token_next = _token_backup;
+		_token_index = _token_backup_index;
+		_token_next = _tokens[_token_index];
 	}
 
 	bool parser::peek(tokenid tokid) const
@@ -329,7 +338,14 @@ namespace reshadefx
 	void parser::consume()
 	{
 		_token = _token_next;
-		_token_next = _lexer->lex();
+
+		// The last token is always the end of file token, which is repeated once the end of input is reached
+		if (_token_index + 1 < _tokens.size())
+		{
+			_token_index++;
+		}
+
+		_token_next = _tokens[_token_index];
 	}
 	void parser::consume_until(tokenid tokid)
 	{
@@ -353,7 +369,7 @@ namespace reshadefx
 	{
 		if (!accept(tokid))
 		{
-			error(_token_next.location, 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "', expected '" + get_token_name(tokid) + "'");
+			error(_token_next.location(), 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "', expected '" + get_token_name(tokid) + "'");
 
 			return false;
 		}
@@ -372,7 +388,7 @@ namespace reshadefx
 			type.rows = type.cols = 0;
 			type.basetype = type_node::datatype_struct;
 
-			const auto symbol = _symbol_table->find(_token_next.literal_as_string);
+			const auto symbol = _symbol_table->find(_token_next.literal_as_identifier);
 
 			if (symbol != nullptr && symbol->id == nodeid::struct_declaration)
 			{
@@ -394,14 +410,14 @@ namespace reshadefx
 			{
 				if (!accept_type_class(type))
 				{
-					error(_token_next.location, 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "', expected vector element type");
+					error(_token_next.location(), 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "', expected vector element type");
 
 					return false;
 				}
 
 				if (!type.is_scalar())
 				{
-					error(_token.location, 3122, "vector element type must be a scalar type");
+					error(_token.location(), 3122, "vector element type must be a scalar type");
 
 					return false;
 				}
@@ -413,7 +429,7 @@ namespace reshadefx
 
 				if (_token.literal_as_int < 1 || _token.literal_as_int > 4)
 				{
-					error(_token.location, 3052, "vector dimension must be between 1 and 4");
+					error(_token.location(), 3052, "vector dimension must be between 1 and 4");
 
 					return false;
 				}
@@ -435,14 +451,14 @@ namespace reshadefx
 			{
 				if (!accept_type_class(type))
 				{
-					error(_token_next.location, 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "', expected matrix element type");
+					error(_token_next.location(), 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "', expected matrix element type");
 
 					return false;
 				}
 
 				if (!type.is_scalar())
 				{
-					error(_token.location, 3123, "matrix element type must be a scalar type");
+					error(_token.location(), 3123, "matrix element type must be a scalar type");
 
 					return false;
 				}
@@ -454,7 +470,7 @@ namespace reshadefx
 
 				if (_token.literal_as_int < 1 || _token.literal_as_int > 4)
 				{
-					error(_token.location, 3053, "matrix dimensions must be between 1 and 4");
+					error(_token.location(), 3053, "matrix dimensions must be between 1 and 4");
 
 					return false;
 				}
@@ -468,7 +484,7 @@ namespace reshadefx
 
 				if (_token.literal_as_int < 1 || _token.literal_as_int > 4)
 				{
-					error(_token.location, 3053, "matrix dimensions must be between 1 and 4");
+					error(_token.location(), 3053, "matrix dimensions must be between 1 and 4");
 
 					return false;
 				}
@@ -689,7 +705,7 @@ namespace reshadefx
 		}
 		if ((type.qualifiers & qualifiers) == qualifiers)
 		{
-			warning(_token.location, 3048, "duplicate usages specified");
+			warning(_token.location(), 3048, "duplicate usages specified");
 		}
 
 		type.qualifiers |= qualifiers;
@@ -704,7 +720,7 @@ namespace reshadefx
 
 		accept_type_qualifiers(type);
 
-		const auto location = _token_next.location;
+		const auto location = _token_next.location();
 
 		if (!accept_type_class(type))
 		{
@@ -941,7 +957,7 @@ namespace reshadefx
 	{
 		type_node type;
 		enum unary_expression_node::op op;
-		auto location = _token_next.location;
+		auto location = _token_next.location();
 
 		#pragma region Prefix
 		if (accept_unary_op(op))
@@ -1125,11 +1141,11 @@ namespace reshadefx
 			literal->type.basetype = type_node::datatype_string;
 			literal->type.qualifiers = type_node::qualifier_const;
 			literal->type.rows = literal->type.cols = 0, literal->type.array_length = 0;
-			literal->value_string = _token.literal_as_string;
+			literal->value_string = *_token.literal_as_string;
 
 			while (accept(tokenid::string_literal))
 			{
-				literal->value_string += _token.literal_as_string;
+				literal->value_string += *_token.literal_as_string;
 			}
 
 			node = literal;
@@ -1222,6 +1238,7 @@ namespace reshadefx
 			scope scope;
 			bool exclusive;
 			std::string identifier;
+			const std::string *interned_identifier = nullptr;
 
 			if (accept(tokenid::colon_colon))
 			{
@@ -1237,7 +1254,8 @@ namespace reshadefx
 
 			if (exclusive ? expect(tokenid::identifier) : accept(tokenid::identifier))
 			{
-				identifier = _token.literal_as_string;
+				interned_identifier = _token.literal_as_identifier;
+				identifier = *interned_identifier;
 			}
 			else
 			{
@@ -1251,10 +1269,12 @@ namespace reshadefx
 					return false;
 				}
 
-				identifier += "::" + _token.literal_as_string;
+				identifier += "::" + *_token.literal_as_identifier;
+				interned_identifier = nullptr;
 			}
 
-			const auto symbol = _symbol_table->find(identifier, scope, exclusive);
+			// Unqualified names can be looked up by their interned pointer directly
+			const auto symbol = interned_identifier != nullptr ? _symbol_table->find(interned_identifier, scope, exclusive) : _symbol_table->find(identifier, scope, exclusive);
 
 			if (accept('('))
 			{
@@ -1379,7 +1399,7 @@ namespace reshadefx
 		#pragma region Postfix
 		while (!peek(tokenid::end_of_file))
 		{
-			location = _token_next.location;
+			location = _token_next.location();
 
 			if (accept_postfix_op(op))
 			{
@@ -1413,8 +1433,8 @@ namespace reshadefx
 					return false;
 				}
 
-				location = _token.location;
-				const auto subscript = _token.literal_as_string;
+				location = _token.location();
+				const auto subscript = *_token.literal_as_identifier;
 
 				if (accept('('))
 				{
@@ -1565,7 +1585,7 @@ namespace reshadefx
 						}
 					}
 
-					const auto newexpression = _ast.make_node<swizzle_expression_node>(_token.location);
+					const auto newexpression = _ast.make_node<swizzle_expression_node>(_token.location());
 					newexpression->type = type;
 					newexpression->type.rows = static_cast<unsigned int>(length / (3 + set));
 					newexpression->type.cols = 1;
@@ -1915,7 +1935,7 @@ namespace reshadefx
 		{
 			if (expect(tokenid::identifier))
 			{
-				const auto attribute = _token.literal_as_string;
+				const auto attribute = *_token.literal_as_identifier;
 
 				if (expect(']'))
 				{
@@ -1950,7 +1970,7 @@ namespace reshadefx
 		#pragma region If
 		if (accept(tokenid::if_))
 		{
-			const auto newstatement = _ast.make_node<if_statement_node>(_token.location);
+			const auto newstatement = _ast.make_node<if_statement_node>(_token.location());
 			newstatement->attributes = attributes;
 
 			if (!(expect('(') && parse_expression(newstatement->condition) && expect(')')))
@@ -1984,7 +2004,7 @@ namespace reshadefx
 		#pragma region Switch
 		if (accept(tokenid::switch_))
 		{
-			const auto newstatement = _ast.make_node<switch_statement_node>(_token.location);
+			const auto newstatement = _ast.make_node<switch_statement_node>(_token.location());
 			newstatement->attributes = attributes;
 
 			if (!(expect('(') && parse_expression(newstatement->test_expression) && expect(')')))
@@ -2006,7 +2026,7 @@ namespace reshadefx
 
 			while (!peek('}') && !peek(tokenid::end_of_file))
 			{
-				const auto casenode = _ast.make_node<case_statement_node>(_token_next.location);
+				const auto casenode = _ast.make_node<case_statement_node>(_token_next.location());
 
 				while (accept(tokenid::case_) || accept(tokenid::default_))
 				{
@@ -2068,7 +2088,7 @@ namespace reshadefx
 		#pragma region For
 		if (accept(tokenid::for_))
 		{
-			const auto newstatement = _ast.make_node<for_statement_node>(_token.location);
+			const auto newstatement = _ast.make_node<for_statement_node>(_token.location());
 			newstatement->attributes = attributes;
 
 			if (!expect('('))
@@ -2141,7 +2161,7 @@ namespace reshadefx
 		#pragma region While
 		if (accept(tokenid::while_))
 		{
-			const auto newstatement = _ast.make_node<while_statement_node>(_token.location);
+			const auto newstatement = _ast.make_node<while_statement_node>(_token.location());
 			newstatement->attributes = attributes;
 			newstatement->is_do_while = false;
 
@@ -2181,7 +2201,7 @@ namespace reshadefx
 		#pragma region DoWhile
 		if (accept(tokenid::do_))
 		{
-			const auto newstatement = _ast.make_node<while_statement_node>(_token.location);
+			const auto newstatement = _ast.make_node<while_statement_node>(_token.location());
 			newstatement->attributes = attributes;
 			newstatement->is_do_while = true;
 
@@ -2206,7 +2226,7 @@ namespace reshadefx
 		#pragma region Break
 		if (accept(tokenid::break_))
 		{
-			const auto newstatement = _ast.make_node<jump_statement_node>(_token.location);
+			const auto newstatement = _ast.make_node<jump_statement_node>(_token.location());
 			newstatement->attributes = attributes;
 			newstatement->is_break = true;
 
@@ -2219,7 +2239,7 @@ namespace reshadefx
 		#pragma region Continue
 		if (accept(tokenid::continue_))
 		{
-			const auto newstatement = _ast.make_node<jump_statement_node>(_token.location);
+			const auto newstatement = _ast.make_node<jump_statement_node>(_token.location());
 			newstatement->attributes = attributes;
 			newstatement->is_continue = true;
 
@@ -2232,7 +2252,7 @@ namespace reshadefx
 		#pragma region Return
 		if (accept(tokenid::return_))
 		{
-			const auto newstatement = _ast.make_node<return_statement_node>(_token.location);
+			const auto newstatement = _ast.make_node<return_statement_node>(_token.location());
 			newstatement->attributes = attributes;
 			newstatement->is_discard = false;
 
@@ -2284,7 +2304,7 @@ namespace reshadefx
 		#pragma region Discard
 		if (accept(tokenid::discard_))
 		{
-			const auto newstatement = _ast.make_node<return_statement_node>(_token.location);
+			const auto newstatement = _ast.make_node<return_statement_node>(_token.location());
 			newstatement->attributes = attributes;
 			newstatement->is_discard = true;
 
@@ -2318,7 +2338,7 @@ namespace reshadefx
 		}
 		#pragma endregion
 
-		error(_token_next.location, 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "'");
+		error(_token_next.location(), 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "'");
 
 		consume_until(';');
 
@@ -2331,7 +2351,7 @@ namespace reshadefx
 			return false;
 		}
 
-		const auto compound = _ast.make_node<compound_statement_node>(_token.location);
+		const auto compound = _ast.make_node<compound_statement_node>(_token.location());
 
 		if (scoped)
 		{
@@ -2389,7 +2409,7 @@ namespace reshadefx
 	{
 		type_node type;
 
-		const auto location = _token_next.location;
+		const auto location = _token_next.location();
 
 		if (!parse_type(type))
 		{
@@ -2413,7 +2433,7 @@ namespace reshadefx
 
 			variable_declaration_node *declarator = nullptr;
 
-			if (!parse_variable_declaration(type, _token.literal_as_string, declarator))
+			if (!parse_variable_declaration(type, *_token.literal_as_identifier, declarator))
 			{
 				return false;
 			}
@@ -2472,7 +2492,7 @@ namespace reshadefx
 			{
 				function_declaration_node *function = nullptr;
 
-				if (!parse_function_declaration(type, _token.literal_as_string, function))
+				if (!parse_function_declaration(type, *_token.literal_as_identifier, function))
 				{
 					return false;
 				}
@@ -2492,7 +2512,7 @@ namespace reshadefx
 
 					variable_declaration_node *variable = nullptr;
 
-					if (!parse_variable_declaration(type, _token.literal_as_string, variable, true))
+					if (!parse_variable_declaration(type, *_token.literal_as_identifier, variable, true))
 					{
 						consume_until(';');
 
@@ -2513,7 +2533,7 @@ namespace reshadefx
 		{
 			consume();
 
-			error(_token.location, 3000, "syntax error: unexpected '" + get_token_name(_token.id) + "'");
+			error(_token.location(), 3000, "syntax error: unexpected '" + get_token_name(_token.id) + "'");
 
 			return false;
 		}
@@ -2532,7 +2552,7 @@ namespace reshadefx
 			return false;
 		}
 
-		const auto name = _token.literal_as_string;
+		const auto name = *_token.literal_as_identifier;
 
 		if (!expect('{'))
 		{
@@ -2607,7 +2627,7 @@ namespace reshadefx
 
 			if (accept_type_class(type))
 			{
-				warning(_token.location, 4717, "type prefixes for annotations are deprecated");
+				warning(_token.location(), 4717, "type prefixes for annotations are deprecated");
 			}
 
 			if (!expect(tokenid::identifier))
@@ -2615,7 +2635,7 @@ namespace reshadefx
 				return false;
 			}
 
-			const auto name = _token.literal_as_string;
+			const auto name = *_token.literal_as_identifier;
 			literal_expression_node *expression = nullptr;
 
 			if (!(expect('=') && parse_expression_unary(reinterpret_cast<expression_node *&>(expression)) && expect(';')))
@@ -2657,15 +2677,15 @@ namespace reshadefx
 			return false;
 		}
 
-		structure = _ast.make_node<struct_declaration_node>(_token.location);
+		structure = _ast.make_node<struct_declaration_node>(_token.location());
 
 		if (accept(tokenid::identifier))
 		{
-			structure->name = _token.literal_as_string;
+			structure->name = *_token.literal_as_identifier;
 
 			if (!_symbol_table->insert(structure, true))
 			{
-				error(_token.location, 3003, "redefinition of '" + structure->name + "'");
+				error(_token.location(), 3003, "redefinition of '" + structure->name + "'");
 
 				return false;
 			}
@@ -2689,7 +2709,7 @@ namespace reshadefx
 
 			if (!parse_type(type))
 			{
-				error(_token_next.location, 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "', expected struct member type");
+				error(_token_next.location(), 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "', expected struct member type");
 
 				consume_until('}');
 
@@ -2698,7 +2718,7 @@ namespace reshadefx
 
 			if (type.is_void())
 			{
-				error(_token_next.location, 3038, "struct members cannot be void");
+				error(_token_next.location(), 3038, "struct members cannot be void");
 
 				consume_until('}');
 
@@ -2706,7 +2726,7 @@ namespace reshadefx
 			}
 			if (type.has_qualifier(type_node::qualifier_in) || type.has_qualifier(type_node::qualifier_out))
 			{
-				error(_token_next.location, 3055, "struct members cannot be declared 'in' or 'out'");
+				error(_token_next.location(), 3055, "struct members cannot be declared 'in' or 'out'");
 
 				consume_until('}');
 
@@ -2731,8 +2751,8 @@ namespace reshadefx
 					return false;
 				}
 
-				const auto field = _ast.make_node<variable_declaration_node>(_token.location);
-				field->unique_name = field->name = _token.literal_as_string;
+				const auto field = _ast.make_node<variable_declaration_node>(_token.location());
+				field->unique_name = field->name = *_token.literal_as_identifier;
 				field->type = type;
 
 				if (!parse_array(field->type.array_length))
@@ -2749,7 +2769,7 @@ namespace reshadefx
 						return false;
 					}
 
-					field->semantic = _token.literal_as_string;
+					field->semantic = *_token.literal_as_identifier;
 					std::transform(field->semantic.begin(), field->semantic.end(), field->semantic.begin(), ::toupper);
 				}
 
@@ -2776,7 +2796,7 @@ namespace reshadefx
 	}
 	bool parser::parse_function_declaration(type_node &type, std::string name, function_declaration_node *&function)
 	{
-		const auto location = _token.location;
+		const auto location = _token.location();
 
 		if (!expect('('))
 		{
@@ -2817,7 +2837,7 @@ namespace reshadefx
 			{
 				_symbol_table->leave_scope();
 
-				error(_token_next.location, 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "', expected parameter type");
+				error(_token_next.location(), 3000, "syntax error: unexpected '" + get_token_name(_token_next.id) + "', expected parameter type");
 
 				return false;
 			}
@@ -2829,8 +2849,8 @@ namespace reshadefx
 				return false;
 			}
 
-			parameter->unique_name = parameter->name = _token.literal_as_string;
-			parameter->location = _token.location;
+			parameter->unique_name = parameter->name = *_token.literal_as_identifier;
+			parameter->location = _token.location();
 
 			if (parameter->type.is_void())
 			{
@@ -2904,7 +2924,7 @@ namespace reshadefx
 					return false;
 				}
 
-				parameter->semantic = _token.literal_as_string;
+				parameter->semantic = *_token.literal_as_identifier;
 				std::transform(parameter->semantic.begin(), parameter->semantic.end(), parameter->semantic.begin(), ::toupper);
 			}
 
@@ -2927,12 +2947,12 @@ namespace reshadefx
 				return false;
 			}
 
-			function->return_semantic = _token.literal_as_string;
+			function->return_semantic = *_token.literal_as_identifier;
 			std::transform(function->return_semantic.begin(), function->return_semantic.end(), function->return_semantic.begin(), ::toupper);
 
 			if (type.is_void())
 			{
-				error(_token.location, 3076, "void function cannot have a semantic");
+				error(_token.location(), 3076, "void function cannot have a semantic");
 
 				return false;
 			}
@@ -2951,7 +2971,7 @@ namespace reshadefx
 	}
 	bool parser::parse_variable_declaration(type_node &type, std::string name, variable_declaration_node *&variable, bool global)
 	{
-		auto location = _token.location;
+		auto location = _token.location();
 
 		if (type.is_void())
 		{
@@ -3043,7 +3063,7 @@ namespace reshadefx
 				return false;
 			}
 
-			variable->semantic = _token.literal_as_string;
+			variable->semantic = *_token.literal_as_identifier;
 			std::transform(variable->semantic.begin(), variable->semantic.end(), variable->semantic.begin(), ::toupper);
 
 			return true;
@@ -3056,7 +3076,7 @@ namespace reshadefx
 
 		if (accept('='))
 		{
-			location = _token.location;
+			location = _token.location();
 
 			if (!parse_variable_assignment(variable->initializer_expression))
 			{
@@ -3142,7 +3162,7 @@ namespace reshadefx
 	{
 		if (accept('{'))
 		{
-			const auto initializerlist = _ast.make_node<initializer_list_node>(_token.location);
+			const auto initializerlist = _ast.make_node<initializer_list_node>(_token.location());
 
 			while (!peek('}'))
 			{
@@ -3198,8 +3218,8 @@ namespace reshadefx
 				return false;
 			}
 
-			const auto name = _token.literal_as_string;
-			const auto location = _token.location;
+			const auto name = *_token.literal_as_identifier;
+			const auto location = _token.location();
 
 			expression_node *value = nullptr;
 
@@ -3375,12 +3395,13 @@ namespace reshadefx
 				{ "LATC2", static_cast<unsigned int>(reshade::texture_format::latc2) },
 			};
 
-			const auto location = _token.location;
-			std::transform(_token.literal_as_string.begin(), _token.literal_as_string.end(), _token.literal_as_string.begin(), ::toupper);
+			const auto location = _token.location();
+			auto value_name = *_token.literal_as_identifier;
+			std::transform(value_name.begin(), value_name.end(), value_name.begin(), ::toupper);
 
 			for (const auto &value : s_values)
 			{
-				if (value.first == _token.literal_as_string)
+				if (value.first == value_name)
 				{
 					const auto newexpression = _ast.make_node<literal_expression_node>(location);
 					newexpression->type.basetype = type_node::datatype_uint;
@@ -3405,7 +3426,7 @@ namespace reshadefx
 			return false;
 		}
 
-		const auto location = _token.location;
+		const auto location = _token.location();
 
 		if (!expect(tokenid::identifier))
 		{
@@ -3413,7 +3434,7 @@ namespace reshadefx
 		}
 
 		technique = _ast.make_node<technique_declaration_node>(location);
-		technique->name = _token.literal_as_string;
+		technique->name = *_token.literal_as_identifier;
 
 		technique->unique_name = 'T' + _symbol_table->current_scope().name + technique->name;
 		std::replace(technique->unique_name.begin(), technique->unique_name.end(), ':', '_');
@@ -3449,11 +3470,11 @@ namespace reshadefx
 			return false;
 		}
 
-		pass = _ast.make_node<pass_declaration_node>(_token.location);
+		pass = _ast.make_node<pass_declaration_node>(_token.location());
 
 		if (accept(tokenid::identifier))
 		{
-			pass->unique_name = pass->name = _token.literal_as_string;
+			pass->unique_name = pass->name = *_token.literal_as_identifier;
 		}
 
 		if (!expect('{'))
@@ -3468,8 +3489,8 @@ namespace reshadefx
 				return false;
 			}
 
-			const auto passstate = _token.literal_as_string;
-			const auto location = _token.location;
+			const auto passstate = *_token.literal_as_identifier;
+			const auto location = _token.location();
 
 			expression_node *value = nullptr;
 
@@ -3665,13 +3686,14 @@ namespace reshadefx
 				{ "NOTEQUAL", pass_declaration_node::NOTEQUAL },
 			};
 
-			auto identifier = _token.literal_as_string;
-			const auto location = _token.location;
-			std::transform(_token.literal_as_string.begin(), _token.literal_as_string.end(), _token.literal_as_string.begin(), ::toupper);
+			auto identifier = *_token.literal_as_identifier;
+			const auto location = _token.location();
+			auto value_name = identifier;
+			std::transform(value_name.begin(), value_name.end(), value_name.begin(), ::toupper);
 
 			for (const auto &value : s_enums)
 			{
-				if (value.first == _token.literal_as_string)
+				if (value.first == value_name)
 				{
 					const auto newexpression = _ast.make_node<literal_expression_node>(location);
 					newexpression->type.basetype = type_node::datatype_uint;
@@ -3686,7 +3708,7 @@ namespace reshadefx
 
 			while (accept(tokenid::colon_colon) && expect(tokenid::identifier))
 			{
-				identifier += "::" + _token.literal_as_string;
+				identifier += "::" + *_token.literal_as_identifier;
 			}
 
 			const auto symbol = _symbol_table->find(identifier, scope, exclusive);
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "effect_lexer.hpp"
 #include "effect_syntax_tree.hpp"
 
@@ -85,8 +86,10 @@ namespace reshadefx
 
 		syntax_tree &_ast;
 		std::string _errors;
-		std::unique_ptr<lexer> _lexer, _lexer_backup;
-		token _token, _token_next, _token_backup;
+		std::shared_ptr<string_table> _strings;
+		std::vector<token> _tokens;
+		size_t _token_index = 0, _token_backup_index = 0;
+		token _token, _token_next;
 		std::unique_ptr<class symbol_table> _symbol_table;
 	};
 }
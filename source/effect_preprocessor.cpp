@@ -5,6 +5,8 @@
 
 #include "effect_preprocessor.hpp"
 #include <fstream>
+#include <algorithm>
+#include <functional>
 #include <assert.h>
 
 namespace reshadefx
@@ -22,6 +24,19 @@ namespace reshadefx
 
 	namespace filesystem = reshade::filesystem;
 
+	namespace
+	{
+		bool is_same_macro(const preprocessor::macro *lhs, const preprocessor::macro *rhs)
+		{
+			if (lhs == nullptr || rhs == nullptr)
+			{
+				return lhs == rhs;
+			}
+
+			return lhs->replacement_list == rhs->replacement_list && lhs->is_function_like == rhs->is_function_like && lhs->is_variadic == rhs->is_variadic && lhs->parameters == rhs->parameters;
+		}
+	}
+
 	void preprocessor::add_include_path(const filesystem::path &path)
 	{
 		assert(!path.empty());
@@ -32,7 +47,18 @@ namespace reshadefx
 	{
 		assert(!name.empty());
 
-		return _macros.emplace(name, macro).second;
+		const auto interned_name = _strings->intern(name);
+
+		record_macro_read(interned_name);
+
+		if (!_macros.emplace(interned_name, macro).second)
+		{
+			return false;
+		}
+
+		record_macro_write(interned_name);
+
+		return true;
 	}
 	bool preprocessor::add_macro_definition(const std::string &name, const std::string &value)
 	{
@@ -53,6 +79,7 @@ namespace reshadefx
 
 		_success = true;
 		_filecache.clear();
+		_include_frames.clear();
 
 		const std::string filedata(std::istreambuf_iterator<char>(file.rdbuf()), std::istreambuf_iterator<char>());
 
@@ -110,7 +137,7 @@ namespace reshadefx
 	{
 		const auto parent = _input_stack.empty() ? nullptr : &_input_stack.top();
 
-		_input_stack.emplace(name, input, parent);
+		_input_stack.emplace(name, input, parent, _strings);
 
 		if (name.empty())
 		{
@@ -121,7 +148,9 @@ namespace reshadefx
 		}
 		else
 		{
+			_output_location.line = 0;
 			_output_location.source = name;
+			_output_source = _strings->intern(name);
 			_output += "#line 1 \"" + name + "\"\n";
 		}
 
@@ -139,8 +168,15 @@ namespace reshadefx
 
 		auto &input_level = _input_stack.top();
 		_token = input_level._next_token;
-		_token.location.source = _output_location.source;
-		_current_token_raw_data = current_lexer().input_string().substr(_token.offset, _token.length);
+		_token.source = _output_source;
+
+		// Keep the input alive, since the input level the token belongs to may be popped below
+		if (_current_token_input != input_level._input)
+		{
+			_current_token_input = input_level._input;
+		}
+
+		_current_token_raw_data = _current_token_input->data() + _token.offset;
 
 		input_level._next_token = input_level._lexer->lex();
 		input_level._offset = input_level._next_token.offset;
@@ -150,11 +186,16 @@ namespace reshadefx
 		{
 			if (!current_if_stack().empty())
 			{
-				error(current_if_level().token.location, "unterminated #if");
+				error(current_if_level().token.location(), "unterminated #if");
 			}
 
 			_input_stack.pop();
 
+			if (!_include_frames.empty() && _include_frames.back().input_level == _input_stack.size() + 1)
+			{
+				end_include_frame();
+			}
+
 			if (_input_stack.empty())
 			{
 				break;
@@ -164,6 +205,7 @@ namespace reshadefx
 			{
 				_output_location.line = 1;
 				_output_location.source = _input_stack.top()._name;
+				_output_source = _strings->intern(_output_location.source);
 				_output += "#line 1 \"" + _output_location.source + "\"\n";
 			}
 		}
@@ -199,7 +241,7 @@ namespace reshadefx
 
 			const auto &actual_token = _input_stack.top()._next_token;
 
-			error(actual_token.location, "syntax error: unexpected token '" + current_lexer().input_string().substr(actual_token.offset, actual_token.length) + "'");
+			error(actual_token.location(), "syntax error: unexpected token '" + current_lexer().input_string().substr(actual_token.offset, actual_token.length) + "'");
 
 			return false;
 		}
@@ -210,8 +252,6 @@ namespace reshadefx
 	// Parsing routines
 	void preprocessor::parse()
 	{
-		std::string line;
-
 		while (!_input_stack.empty())
 		{
 			_recursion_count = 0;
@@ -290,21 +330,21 @@ namespace reshadefx
 					parse_include();
 					continue;
 				case tokenid::hash_unknown:
-					error(current_token().location, "unrecognized preprocessing directive '" + current_token().literal_as_string + "'");
+					error(current_token().location(), "unrecognized preprocessing directive '" + *current_token().literal_as_identifier + "'");
 					consume_until(tokenid::end_of_line);
 					continue;
 
 				case tokenid::end_of_line:
-					if (line.empty())
+					if (_current_line.empty())
 					{
 						continue;
 					}
-					if (++_output_location.line != current_token().location.line)
+					if (++_output_location.line != current_token().location().line)
 					{
-						_output += "#line " + std::to_string(_output_location.line = current_token().location.line) + '\n';
+						_output += "#line " + std::to_string(_output_location.line = current_token().location().line) + '\n';
 					}
-					_output += line + '\n';
-					line.clear();
+					_output += _current_line + '\n';
+					_current_line.clear();
 					continue;
 
 				case tokenid::identifier:
@@ -313,12 +353,13 @@ namespace reshadefx
 						continue;
 					}
 				default:
-					line += _current_token_raw_data;
+					_current_line.append(_current_token_raw_data, _token.length);
 					break;
 			}
 		}
 
-		_output += line;
+		_output += _current_line;
+		_current_line.clear();
 	}
 	void preprocessor::parse_def()
 	{
@@ -328,8 +369,8 @@ namespace reshadefx
 		}
 
 		macro m;
-		const auto location = current_token().location;
-		const auto macro_name = current_token().literal_as_string;
+		const auto location = current_token().location();
+		const auto macro_name = *current_token().literal_as_identifier;
 		const auto macro_name_end_offset = current_token().offset + current_token().length;
 
 		if (macro_name == "defined")
@@ -346,7 +387,7 @@ namespace reshadefx
 
 			while (accept(tokenid::identifier))
 			{
-				m.parameters.push_back(current_token().literal_as_string);
+				m.parameters.push_back(*current_token().literal_as_identifier);
 
 				if (!accept(tokenid::comma))
 				{
@@ -360,7 +401,7 @@ namespace reshadefx
 				m.parameters.push_back("__VA_ARGS__");
 
 				// TODO: Implement variadic macros
-				error(current_token().location, "variadic macros are not currently supported");
+				error(current_token().location(), "variadic macros are not currently supported");
 				return;
 			}
 
@@ -385,16 +426,18 @@ namespace reshadefx
 			return;
 		}
 
-		const auto location = current_token().location;
-		const auto &macro_name = current_token().literal_as_string;
+		const auto location = current_token().location();
+		const auto macro_name = current_token().literal_as_identifier;
 
-		if (macro_name == "defined")
+		if (*macro_name == "defined")
 		{
 			warning(location, "macro name 'defined' is reserved");
 			return;
 		}
 
 		_macros.erase(macro_name);
+
+		record_macro_write(macro_name);
 	}
 	void preprocessor::parse_if()
 	{
@@ -421,9 +464,9 @@ namespace reshadefx
 			return;
 		}
 
-		const auto &macro_name = current_token().literal_as_string;
+		record_macro_read(current_token().literal_as_identifier);
 
-		level.value = _macros.find(macro_name) != _macros.end();
+		level.value = _macros.find(current_token().literal_as_identifier) != _macros.end();
 		level.skipping = (parent != nullptr && parent->skipping) || !level.value;
 		level.parent = parent;
 
@@ -441,9 +484,9 @@ namespace reshadefx
 			return;
 		}
 
-		const auto &macro_name = current_token().literal_as_string;
+		record_macro_read(current_token().literal_as_identifier);
 
-		level.value = _macros.find(macro_name) == _macros.end();
+		level.value = _macros.find(current_token().literal_as_identifier) == _macros.end();
 		level.skipping = (parent != nullptr && parent->skipping) || !level.value;
 		level.parent = parent;
 
@@ -451,7 +494,7 @@ namespace reshadefx
 	}
 	void preprocessor::parse_elif()
 	{
-		const auto keyword_location = current_token().location;
+		const auto keyword_location = current_token().location();
 
 		if (current_if_stack().empty())
 		{
@@ -477,7 +520,7 @@ namespace reshadefx
 	}
 	void preprocessor::parse_else()
 	{
-		const auto keyword_location = current_token().location;
+		const auto keyword_location = current_token().location();
 
 		if (current_if_stack().empty())
 		{
@@ -501,7 +544,7 @@ namespace reshadefx
 	}
 	void preprocessor::parse_endif()
 	{
-		const auto keyword_location = current_token().location;
+		const auto keyword_location = current_token().location();
 
 		if (current_if_stack().empty())
 		{
@@ -513,25 +556,25 @@ namespace reshadefx
 	}
 	void preprocessor::parse_error()
 	{
-		const auto keyword_location = current_token().location;
+		const auto keyword_location = current_token().location();
 				
 		if (!expect(tokenid::string_literal))
 		{
 			return;
 		}
 
-		error(keyword_location, current_token().literal_as_string);
+		error(keyword_location, *current_token().literal_as_string);
 	}
 	void preprocessor::parse_warning()
 	{
-		const auto keyword_location = current_token().location;
+		const auto keyword_location = current_token().location();
 
 		if (!expect(tokenid::string_literal))
 		{
 			return;
 		}
 
-		warning(keyword_location, current_token().literal_as_string);
+		warning(keyword_location, *current_token().literal_as_string);
 	}
 	void preprocessor::parse_pragma()
 	{
@@ -540,7 +583,7 @@ namespace reshadefx
 			return;
 		}
 
-		std::string pragma = current_token().literal_as_string;
+		std::string pragma = *current_token().literal_as_identifier;
 
 		while (!peek(tokenid::end_of_line) && !peek(tokenid::end_of_file))
 		{
@@ -558,7 +601,7 @@ namespace reshadefx
 						continue;
 					}
 				default:
-					pragma += _current_token_raw_data;
+					pragma.append(_current_token_raw_data, _token.length);
 					break;
 			}
 		}
@@ -577,13 +620,13 @@ namespace reshadefx
 	}
 	void preprocessor::parse_include()
 	{
-		const auto keyword_location = current_token().location;
+		const auto keyword_location = current_token().location();
 
 		while (accept(tokenid::identifier))
 		{
 			if (!evaluate_identifier_as_macro())
 			{
-				error(current_token().location, "syntax error: unexpected identifier in #include");
+				error(current_token().location(), "syntax error: unexpected identifier in #include");
 				consume_until(tokenid::end_of_line);
 				return;
 			}
@@ -595,7 +638,7 @@ namespace reshadefx
 			return;
 		}
 
-		filesystem::path filename = current_token().literal_as_string;
+		filesystem::path filename = *current_token().literal_as_string;
 		filesystem::path filepath = filesystem::path(_output_location.source).remove_filename() / filename;
 
 		if (!filesystem::exists(filepath))
@@ -621,6 +664,22 @@ namespace reshadefx
 			it = _filecache.emplace(filepath.string(), filedata + '\n').first;
 		}
 
+		// Nested includes are not tracked, so any file that is currently being recorded cannot be cached anymore
+		for (auto &frame : _include_frames)
+		{
+			frame.is_cacheable = false;
+		}
+
+		if (_include_cache != nullptr && !it->second.empty())
+		{
+			if (replay_include(filepath.string(), it->second))
+			{
+				return;
+			}
+
+			begin_include_frame(filepath.string(), it->second);
+		}
+
 		push(it->second, filepath.string());
 	}
 
@@ -671,7 +730,7 @@ namespace reshadefx
 		{
 			if (stack_count >= _countof(stack) || rpn_count >= _countof(rpn))
 			{
-				error(current_token().location, "expression evaluator ran out of stack space");
+				error(current_token().location(), "expression evaluator ran out of stack space");
 				return false;
 			}
 
@@ -785,7 +844,7 @@ namespace reshadefx
 
 					if (!matched)
 					{
-						error(current_token().location, "unmatched ')'");
+						error(current_token().location(), "unmatched ')'");
 						return false;
 					}
 					break;
@@ -796,7 +855,7 @@ namespace reshadefx
 					{
 						continue;
 					}
-					else if (current_token().literal_as_string == "exists")
+					else if (*current_token().literal_as_identifier == "exists")
 					{
 						const bool has_parentheses = accept(tokenid::parenthesis_open);
 
@@ -804,7 +863,7 @@ namespace reshadefx
 						{
 							if (!evaluate_identifier_as_macro())
 							{
-								error(current_token().location, "syntax error: unexpected identifier after 'exists'");
+								error(current_token().location(), "syntax error: unexpected identifier after 'exists'");
 								return false;
 							}
 						}
@@ -814,7 +873,13 @@ namespace reshadefx
 							return false;
 						}
 
-						const filesystem::path filename = current_token().literal_as_string;
+						// The result depends on the file system, which is not tracked by the include cache
+						if (!_include_frames.empty())
+						{
+							_include_frames.back().is_cacheable = false;
+						}
+
+						const filesystem::path filename = *current_token().literal_as_string;
 						const filesystem::path filename_with_current_directory = filesystem::path(_output_location.source).remove_filename() / filename;
 
 						if (has_parentheses && !expect(tokenid::parenthesis_close))
@@ -826,7 +891,7 @@ namespace reshadefx
 						rpn[rpn_count++].value = filesystem::exists(filename_with_current_directory) || filesystem::exists(filesystem::resolve(filename, _include_paths));
 						continue;
 					}
-					else if (current_token().literal_as_string == "defined")
+					else if (*current_token().literal_as_identifier == "defined")
 					{
 						const bool has_parentheses = accept(tokenid::parenthesis_open);
 
@@ -835,7 +900,9 @@ namespace reshadefx
 							return false;
 						}
 
-						const bool is_macro_defined = _macros.find(current_token().literal_as_string) != _macros.end();
+						record_macro_read(current_token().literal_as_identifier);
+
+						const bool is_macro_defined = _macros.find(current_token().literal_as_identifier) != _macros.end();
 
 						if (has_parentheses && !expect(tokenid::parenthesis_close))
 						{
@@ -863,7 +930,7 @@ namespace reshadefx
 				{
 					if (op == op_none)
 					{
-						error(current_token().location, "invalid expression");
+						error(current_token().location(), "invalid expression");
 						return false;
 					}
 
@@ -906,7 +973,7 @@ namespace reshadefx
 
 			if (op == op_parentheses)
 			{
-				error(current_token().location, "unmatched ')'");
+				error(current_token().location(), "unmatched ')'");
 				return false;
 			}
 
@@ -956,7 +1023,7 @@ namespace reshadefx
 
 		if (stack_count != 1)
 		{
-			error(current_token().location, "invalid expression");
+			error(current_token().location(), "invalid expression");
 			return false;
 		}
 
@@ -966,11 +1033,13 @@ namespace reshadefx
 	{
 		if (_recursion_count++ >= 256)
 		{
-			error(current_token().location, "macro recursion too high");
+			error(current_token().location(), "macro recursion too high");
 			return false;
 		}
 
-		const auto it = _macros.find(current_token().literal_as_string);
+		record_macro_read(current_token().literal_as_identifier);
+
+		const auto it = _macros.find(current_token().literal_as_identifier);
 
 		if (it == _macros.end())
 		{
@@ -1007,7 +1076,7 @@ namespace reshadefx
 						break;
 					}
 
-					argument += _current_token_raw_data;
+					argument.append(_current_token_raw_data, _token.length);
 				}
 
 				if (!argument.empty() && argument.back() == ' ')
@@ -1061,7 +1130,7 @@ namespace reshadefx
 								continue;
 							}
 
-							out += _current_token_raw_data;
+							out.append(_current_token_raw_data, _token.length);
 						}
 						assert(_current_token_raw_data[0] == macro_replacement_argument);
 						break;
@@ -1077,7 +1146,7 @@ namespace reshadefx
 	{
 		if (macro.parameters.size() >= 0xFF)
 		{
-			error(current_token().location, "too many macro parameters");
+			error(current_token().location(), "too many macro parameters");
 			return;
 		}
 
@@ -1093,7 +1162,7 @@ namespace reshadefx
 					{
 						if (peek(tokenid::end_of_line))
 						{
-							error(current_token().location, "## cannot appear at end of macro text");
+							error(current_token().location(), "## cannot appear at end of macro text");
 							return;
 						}
 
@@ -1109,11 +1178,11 @@ namespace reshadefx
 							return;
 						}
 
-						const auto it = std::find(macro.parameters.begin(), macro.parameters.end(), current_token().literal_as_string);
+						const auto it = std::find(macro.parameters.begin(), macro.parameters.end(), *current_token().literal_as_identifier);
 
 						if (it == macro.parameters.end())
 						{
-							error(current_token().location, "# must be followed by parameter name");
+							error(current_token().location(), "# must be followed by parameter name");
 							return;
 						}
 
@@ -1136,7 +1205,7 @@ namespace reshadefx
 				}
 				case tokenid::identifier:
 				{
-					const auto it = std::find(macro.parameters.begin(), macro.parameters.end(), current_token().literal_as_string);
+					const auto it = std::find(macro.parameters.begin(), macro.parameters.end(), *current_token().literal_as_identifier);
 
 					if (it != macro.parameters.end())
 					{
@@ -1149,7 +1218,178 @@ namespace reshadefx
 				}
 			}
 
-			macro.replacement_list += _current_token_raw_data;
+			macro.replacement_list.append(_current_token_raw_data, _token.length);
+		}
+	}
+
+	// Include caching
+	void preprocessor::record_macro_read(const std::string *name)
+	{
+		if (_include_frames.empty())
+		{
+			return;
+		}
+
+		auto &frame = _include_frames.back();
+
+		// Only the value a macro had when the file was entered matters, later reads see what the file itself did
+		if (!frame.is_cacheable || frame.side_effects.count(name) != 0 || frame.dependencies.count(name) != 0)
+		{
+			return;
+		}
+
+		const auto it = _macros.find(name);
+
+		frame.dependencies.emplace(name, it != _macros.end() ? std::make_shared<const macro>(it->second) : nullptr);
+	}
+	void preprocessor::record_macro_write(const std::string *name)
+	{
+		if (!_include_frames.empty())
+		{
+			_include_frames.back().side_effects.insert(name);
+		}
+	}
+	void preprocessor::begin_include_frame(const std::string &path, const std::string &text)
+	{
+		include_frame frame;
+		frame.path = path;
+		frame.text = text;
+		frame.input_level = _input_stack.size() + 1;
+		frame.output_offset = _output.size();
+		frame.errors_offset = _errors.size();
+		frame.pragmas_offset = _pragmas.size();
+		// A file including itself does not switch back to another source name at its end, which replaying relies on
+		frame.is_cacheable = path != _input_stack.top()._name;
+
+		_include_frames.push_back(std::move(frame));
+	}
+	void preprocessor::end_include_frame()
+	{
+		auto frame = std::move(_include_frames.back());
+		_include_frames.pop_back();
+
+		// Only cache files that were processed without any messages and did not leave a partial line for the including file to finish
+		if (!frame.is_cacheable || _errors.size() != frame.errors_offset || !_current_line.empty())
+		{
+			return;
+		}
+
+		const auto entry = std::make_shared<include_cache::entry>();
+		entry->text = std::move(frame.text);
+		entry->text_hash = std::hash<std::string>()(entry->text);
+		entry->output = _output.substr(frame.output_offset);
+		entry->pragmas.assign(_pragmas.begin() + frame.pragmas_offset, _pragmas.end());
+
+		for (const auto &dependency : frame.dependencies)
+		{
+			entry->dependencies.emplace_back(*dependency.first, dependency.second);
+		}
+		for (const auto name : frame.side_effects)
+		{
+			const auto it = _macros.find(name);
+
+			entry->side_effects.emplace_back(*name, it != _macros.end() ? std::make_shared<const macro>(it->second) : nullptr);
+		}
+
+		const auto file = _filecache.find(frame.path);
+
+		entry->pragma_once = file != _filecache.end() && file->second.empty();
+
+		_include_cache->insert(frame.path, std::move(entry));
+	}
+	bool preprocessor::replay_include(const std::string &path, const std::string &text)
+	{
+		if (path == _input_stack.top()._name)
+		{
+			return false;
+		}
+
+		for (const auto &entry : _include_cache->find(path, text))
+		{
+			const bool is_unaffected = std::all_of(entry->dependencies.begin(), entry->dependencies.end(),
+				[this](const auto &dependency) {
+					const auto it = _macros.find(_strings->find(dependency.first));
+					return is_same_macro(it != _macros.end() ? &it->second : nullptr, dependency.second.get());
+				});
+
+			if (!is_unaffected)
+			{
+				continue;
+			}
+
+			_output += entry->output;
+			_pragmas.insert(_pragmas.end(), entry->pragmas.begin(), entry->pragmas.end());
+
+			for (const auto &side_effect : entry->side_effects)
+			{
+				const auto name = _strings->intern(side_effect.first);
+
+				if (side_effect.second != nullptr)
+				{
+					_macros[name] = *side_effect.second;
+				}
+				else
+				{
+					_macros.erase(name);
+				}
+			}
+
+			if (entry->pragma_once)
+			{
+				_filecache[path].clear();
+			}
+
+			// Switch back to the including file the same way 'consume' does when an included file ends
+			_output_location.line = 1;
+			_output_location.source = _input_stack.top()._name;
+			_output_source = _strings->intern(_output_location.source);
+			_output += "#line 1 \"" + _output_location.source + "\"\n";
+
+			return true;
+		}
+
+		return false;
+	}
+
+	std::vector<std::shared_ptr<const include_cache::entry>> include_cache::find(const std::string &path, const std::string &text) const
+	{
+		const size_t text_hash = std::hash<std::string>()(text);
+		std::vector<std::shared_ptr<const entry>> result;
+
+		const std::lock_guard<std::mutex> lock(_mutex);
+
+		const auto it = _entries.find(path);
+
+		if (it != _entries.end())
+		{
+			for (auto entry = it->second.rbegin(); entry != it->second.rend(); ++entry)
+			{
+				if ((*entry)->text_hash == text_hash && (*entry)->text == text)
+				{
+					result.push_back(*entry);
+				}
+			}
+		}
+
+		return result;
+	}
+	void include_cache::insert(const std::string &path, std::shared_ptr<const entry> entry)
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+
+		auto &entries = _entries[path];
+
+		if (entries.size() >= 8)
+		{
+			entries.erase(entries.begin());
 		}
+
+		entries.push_back(std::move(entry));
+	}
+	void include_cache::clear()
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+
+		_entries.clear();
 	}
 }
@@ -6,14 +6,18 @@
 #pragma once
 
 #include <stack>
+#include <mutex>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include "effect_lexer.hpp"
 #include "filesystem.hpp"
 
 namespace reshadefx
 {
+	class include_cache;
+
 	/// <summary>
 	/// A C-style pre-processor implementation.
 	/// </summary>
@@ -28,6 +32,11 @@ namespace reshadefx
 		};
 
 		void add_include_path(const reshade::filesystem::path &path);
+		/// <summary>
+		/// Set a cache to reuse the output of included files from previous runs, when they are unaffected by the current macro state.
+		/// </summary>
+		/// <param name="cache">The cache to use. It has to outlive this instance and may be shared between preprocessors on different threads.</param>
+		void set_include_cache(include_cache *cache) { _include_cache = cache; }
 		bool add_macro_definition(const std::string &name, const macro &macro);
 		bool add_macro_definition(const std::string &name, const std::string &value = "1");
 
@@ -45,11 +54,20 @@ namespace reshadefx
 			bool value, skipping;
 			if_level *parent;
 		};
+		struct include_frame
+		{
+			std::string path, text;
+			size_t input_level, output_offset, errors_offset, pragmas_offset;
+			bool is_cacheable = true;
+			std::unordered_map<const std::string *, std::shared_ptr<const macro>> dependencies;
+			std::unordered_set<const std::string *> side_effects;
+		};
 		struct input_level
 		{
-			input_level(const std::string &name, const std::string &text, input_level *parent) :
+			input_level(const std::string &name, const std::string &text, input_level *parent, const std::shared_ptr<string_table> &strings) :
 				_name(name),
-				_lexer(new lexer(text, false, false, true, false)),
+				_input(std::make_shared<const std::string>(text)),
+				_lexer(new lexer(_input, false, false, true, false, strings)),
 				_parent(parent)
 			{
 				_next_token.id = tokenid::unknown;
@@ -57,6 +75,7 @@ namespace reshadefx
 			}
 
 			std::string _name;
+			std::shared_ptr<const std::string> _input;
 			std::unique_ptr<lexer> _lexer;
 			token _next_token;
 			size_t _offset;
@@ -95,6 +114,12 @@ namespace reshadefx
 		bool evaluate_expression();
 		bool evaluate_identifier_as_macro();
 
+		void record_macro_read(const std::string *name);
+		void record_macro_write(const std::string *name);
+		void begin_include_frame(const std::string &path, const std::string &text);
+		void end_include_frame();
+		bool replay_include(const std::string &path, const std::string &text);
+
 		void expand_macro(const macro &macro, const std::vector<std::string> &arguments, std::string &out);
 		void create_macro_replacement_list(macro &macro);
 
@@ -102,11 +127,61 @@ namespace reshadefx
 		token _token;
 		std::stack<input_level> _input_stack;
 		location _output_location;
-		std::string _output, _errors, _current_token_raw_data;
+		const std::string *_output_source = nullptr;
+		std::string _output, _errors, _current_line;
+		std::shared_ptr<const std::string> _current_token_input;
+		const char *_current_token_raw_data = nullptr;
 		int _recursion_count = 0;
-		std::unordered_map<std::string, macro> _macros;
+		std::shared_ptr<string_table> _strings = std::make_shared<string_table>();
+		std::unordered_map<const std::string *, macro> _macros;
 		std::vector<std::string> _pragmas;
 		std::vector<reshade::filesystem::path> _include_paths;
 		std::unordered_map<std::string, std::string> _filecache;
+		include_cache *_include_cache = nullptr;
+		std::vector<include_frame> _include_frames;
+	};
+
+	/// <summary>
+	/// A cache of preprocessed include files, which is kept across preprocessor runs.
+	/// </summary>
+	class include_cache
+	{
+	public:
+		/// <summary>
+		/// The recorded result of preprocessing an included file.
+		/// </summary>
+		struct entry
+		{
+			std::string text;
+			size_t text_hash = 0;
+			// Macros that were read before being written by the file, with their value on entry (or nullptr if they were not defined)
+			std::vector<std::pair<std::string, std::shared_ptr<const preprocessor::macro>>> dependencies;
+			// Macros that were defined or undefined by the file, with their value on exit (or nullptr if they were undefined)
+			std::vector<std::pair<std::string, std::shared_ptr<const preprocessor::macro>>> side_effects;
+			std::string output;
+			std::vector<std::string> pragmas;
+			bool pragma_once = false;
+		};
+
+		/// <summary>
+		/// Find all cached results for a file whose text matches.
+		/// </summary>
+		/// <param name="path">The path to the included file.</param>
+		/// <param name="text">The current text of the included file.</param>
+		std::vector<std::shared_ptr<const entry>> find(const std::string &path, const std::string &text) const;
+		/// <summary>
+		/// Add a new result for a file. Only a small number of results are kept per file, the oldest ones are dropped first.
+		/// </summary>
+		/// <param name="path">The path to the included file.</param>
+		/// <param name="entry">The result to add.</param>
+		void insert(const std::string &path, std::shared_ptr<const entry> entry);
+		/// <summary>
+		/// Remove all cached results.
+		/// </summary>
+		void clear();
+
+	private:
+		mutable std::mutex _mutex;
+		std::unordered_map<std::string, std::vector<std::shared_ptr<const entry>>> _entries;
 	};
 }
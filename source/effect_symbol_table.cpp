@@ -483,7 +483,8 @@ namespace reshadefx
 		return rank;
 	}
 
-	symbol_table::symbol_table()
+	symbol_table::symbol_table(std::shared_ptr<string_table> identifiers) :
+		_identifiers(std::move(identifiers))
 	{
 		_current_scope.name = "::";
 		_current_scope.level = 0;
@@ -575,7 +576,7 @@ namespace reshadefx
 				const auto previous_scope_name = _current_scope.name.substr(pos);
 
 				// Insert symbol into this scope
-				insert_sorted(_symbol_stack[previous_scope_name + symbol->name], std::make_pair(scope, symbol));
+				insert_sorted(_symbol_stack[_identifiers->intern(previous_scope_name + symbol->name)], std::make_pair(scope, symbol));
 
 				// Continue walking up the scope chain
 				scope.level = ++scope.namespace_level;
@@ -584,7 +585,7 @@ namespace reshadefx
 		else
 		{
 			// This is a local symbol so it's sufficient to update the symbol stack with just the current scope
-			insert_sorted(_symbol_stack[symbol->name], std::make_pair(_current_scope, symbol));
+			insert_sorted(_symbol_stack[_identifiers->intern(symbol->name)], std::make_pair(_current_scope, symbol));
 		}
 
 		return true;
@@ -595,6 +596,22 @@ namespace reshadefx
 		return find(name, _current_scope, false);
 	}
 	symbol symbol_table::find(const std::string &name, const scope &scope, bool exclusive) const
+	{
+		// Names that were never interned cannot have a symbol associated with them
+		const auto interned_name = _identifiers->find(name);
+
+		if (interned_name == nullptr)
+		{
+			return nullptr;
+		}
+
+		return find(interned_name, scope, exclusive);
+	}
+	symbol symbol_table::find(const std::string *name) const
+	{
+		return find(name, _current_scope, false);
+	}
+	symbol symbol_table::find(const std::string *name, const scope &scope, bool exclusive) const
 	{
 		const auto it = _symbol_stack.find(name);
 
@@ -642,7 +659,7 @@ namespace reshadefx
 		const function_declaration_node *overload = nullptr;
 		auto intrinsic_op = intrinsic_expression_node::none;
 
-		const auto it = _symbol_stack.find(call->callee_name);
+		const auto it = _symbol_stack.find(_identifiers->find(call->callee_name));
 
 		if (it != _symbol_stack.end() && !it->second.empty())
 		{
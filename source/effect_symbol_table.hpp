@@ -8,6 +8,7 @@
 #include <stack>
 #include <unordered_map>
 #include <string>
+#include "effect_lexer.hpp"
 
 namespace reshadefx
 {
@@ -39,7 +40,11 @@ namespace reshadefx
 	class symbol_table
 	{
 	public:
-		symbol_table();
+		/// <summary>
+		/// Construct a new symbol table.
+		/// </summary>
+		/// <param name="identifiers">The table symbol names are interned into. Names from identifier tokens of lexers sharing it can be looked up by pointer.</param>
+		explicit symbol_table(std::shared_ptr<string_table> identifiers = std::make_shared<string_table>());
 
 		void enter_scope(symbol parent = nullptr);
 		void enter_namespace(const std::string &name);
@@ -52,11 +57,14 @@ namespace reshadefx
 		bool insert(symbol symbol, bool global = false);
 		symbol find(const std::string &name) const;
 		symbol find(const std::string &name, const scope &scope, bool exclusive) const;
+		symbol find(const std::string *name) const;
+		symbol find(const std::string *name, const scope &scope, bool exclusive) const;
 		bool resolve_call(nodes::call_expression_node *call, const scope &scope, bool &intrinsic, bool &ambiguous) const;
 
 	private:
 		scope _current_scope;
 		std::stack<symbol> _parent_stack;
-		std::unordered_map<std::string, std::vector<std::pair<scope, symbol>>> _symbol_stack;
+		std::shared_ptr<string_table> _identifiers;
+		std::unordered_map<const std::string *, std::vector<std::pair<scope, symbol>>> _symbol_stack;
 	};
 }
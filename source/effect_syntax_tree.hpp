@@ -6,7 +6,10 @@
 #pragma once
 
 #include "effect_syntax_tree_nodes.hpp"
-#include <list>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
 
 namespace reshadefx
 {
@@ -35,69 +38,84 @@ namespace reshadefx
 	private:
 		class memory_pool
 		{
-			struct page
+			struct destructor
 			{
-				explicit page(size_t size) : cursor(0), memory(size, '\0') { }
-
-				size_t cursor;
-				std::vector<unsigned char> memory;
-			};
-			struct nodeinfo
-			{
-				size_t size;
-				void(*dtor)(void *);
-				unsigned char data[sizeof(node)];
+				void(*function)(void *);
+				void *object;
+				destructor *next;
 			};
 
+			static constexpr size_t page_size = 64 * 1024;
+
 		public:
+			memory_pool() = default;
+			memory_pool(const memory_pool &) = delete;
 			~memory_pool()
 			{
 				clear();
 			}
 
+			memory_pool &operator=(const memory_pool &) = delete;
+
 			template <typename T>
 			T *add()
 			{
-				auto size = sizeof(nodeinfo) - sizeof(node) + sizeof(T);
-				auto page = std::find_if(_pages.begin(), _pages.end(),
-					[size](const struct page &page)
-				{
-					return page.cursor + size < page.memory.size();
-				});
+				static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned node types are not supported");
 
-				if (page == _pages.end())
+				if (std::is_trivially_destructible<T>::value)
 				{
-					_pages.emplace_back(std::max(size_t(4096), size));
-
-					page = std::prev(_pages.end());
+					return new (allocate(sizeof(T), alignof(T))) T();
 				}
 
-				const auto node = new (&page->memory.at(page->cursor)) nodeinfo;
-				const auto node_data = new (&node->data) T();
-				node->size = size;
-				node->dtor = [](void *object) { reinterpret_cast<T *>(object)->~T(); };
-
-				page->cursor += node->size;
+				// Keep track of objects that need to be destroyed, in reverse order of construction
+				const auto dtor = static_cast<destructor *>(allocate(sizeof(destructor), alignof(destructor)));
+				const auto node = new (allocate(sizeof(T), alignof(T))) T();
+				dtor->function = [](void *object) { static_cast<T *>(object)->~T(); };
+				dtor->object = node;
+				dtor->next = _destructors;
+				_destructors = dtor;
 
-				return node_data;
+				return node;
 			}
 			void clear()
 			{
-				for (auto &page : _pages)
+				for (auto dtor = _destructors; dtor != nullptr; dtor = dtor->next)
 				{
-					auto node = reinterpret_cast<nodeinfo *>(&page.memory.front());
-
-					do
-					{
-						node->dtor(node->data);
-						node = reinterpret_cast<nodeinfo *>(reinterpret_cast<unsigned char *>(node) + node->size);
-					}
-					while (node->size > 0 && (page.cursor -= node->size) > 0);
+					dtor->function(dtor->object);
 				}
+
+				_pages.clear();
+				_destructors = nullptr;
+				_cursor = _end = nullptr;
 			}
 
 		private:
-			std::list<page> _pages;
+			void *allocate(size_t size, size_t alignment)
+			{
+				auto address = reinterpret_cast<uintptr_t>(_cursor);
+				address = (address + alignment - 1) & ~(alignment - 1);
+
+				if (_cursor == nullptr || address + size > reinterpret_cast<uintptr_t>(_end))
+				{
+					// Start a new page, which is aligned suitably for any node type already
+					// Pages are zero-initialized, since nodes rely on members their constructor does not touch to be zero
+					const size_t new_page_size = std::max(page_size, size);
+
+					_pages.emplace_back(new unsigned char[new_page_size]());
+					_cursor = _pages.back().get();
+					_end = _cursor + new_page_size;
+
+					address = reinterpret_cast<uintptr_t>(_cursor);
+				}
+
+				_cursor = reinterpret_cast<unsigned char *>(address + size);
+
+				return reinterpret_cast<void *>(address);
+			}
+
+			std::vector<std::unique_ptr<unsigned char[]>> _pages;
+			unsigned char *_cursor = nullptr, *_end = nullptr;
+			destructor *_destructors = nullptr;
 		} _pool;
 	};
 }
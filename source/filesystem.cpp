@@ -100,6 +100,18 @@ namespace reshade::filesystem
 	{
 		return GetFileAttributesW(path.wstring().c_str()) != INVALID_FILE_ATTRIBUTES;
 	}
+	bool create_directory(const path &path)
+	{
+		return CreateDirectoryW(path.wstring().c_str(), nullptr) != FALSE || GetLastError() == ERROR_ALREADY_EXISTS;
+	}
+	bool remove(const path &path)
+	{
+		return DeleteFileW(path.wstring().c_str()) != FALSE;
+	}
+	bool rename(const path &from, const path &to)
+	{
+		return MoveFileExW(from.wstring().c_str(), to.wstring().c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+	}
 	path resolve(const path &filename, const std::vector<path> &paths)
 	{
 		for (const auto &path : paths)
@@ -55,6 +55,9 @@ namespace reshade::filesystem
 	};
 
 	bool exists(const path &path);
+	bool create_directory(const path &path);
+	bool remove(const path &path);
+	bool rename(const path &from, const path &to);
 	path resolve(const path &filename, const std::vector<path> &paths);
 	path absolute(const path &filename, const path &parent_path);
 
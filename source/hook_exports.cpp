@@ -0,0 +1,84 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "hook_exports.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace reshade::hooks
+{
+	namespace
+	{
+		std::vector<const module_export *> sort_by_name(const std::vector<module_export> &exports)
+		{
+			std::vector<const module_export *> sorted;
+			sorted.reserve(exports.size());
+
+			for (const auto &symbol : exports)
+			{
+				if (symbol.name != nullptr && symbol.address != nullptr)
+				{
+					sorted.push_back(&symbol);
+				}
+			}
+
+			const auto compare = [](const module_export *lhs, const module_export *rhs) {
+				return std::strcmp(lhs->name, rhs->name) < 0;
+			};
+
+			// Export name tables are sorted already (so that the loader can search them), so usually there is nothing to do here
+			// Otherwise keep the original order of duplicate names, so that the first one still wins
+			if (!std::is_sorted(sorted.begin(), sorted.end(), compare))
+			{
+				std::stable_sort(sorted.begin(), sorted.end(), compare);
+			}
+
+			return sorted;
+		}
+	}
+
+	std::vector<std::pair<const module_export *, const module_export *>> match_exports(const std::vector<module_export> &target_exports, const std::vector<module_export> &replacement_exports)
+	{
+		const auto sorted_targets = sort_by_name(target_exports);
+		const auto sorted_replacements = sort_by_name(replacement_exports);
+
+		// Remember the match of each target export by its index, so that the result can be returned in the original order
+		std::vector<const module_export *> replacements(target_exports.size(), nullptr);
+
+		for (size_t i = 0, k = 0; i < sorted_targets.size() && k < sorted_replacements.size();)
+		{
+			const int compare = std::strcmp(sorted_targets[i]->name, sorted_replacements[k]->name);
+
+			if (compare < 0)
+			{
+				i++;
+			}
+			else if (compare > 0)
+			{
+				k++;
+			}
+			else
+			{
+				replacements[sorted_targets[i] - target_exports.data()] = sorted_replacements[k];
+
+				// Only advance the target side, in case the next target export has the same name
+				i++;
+			}
+		}
+
+		std::vector<std::pair<const module_export *, const module_export *>> matches;
+		matches.reserve(std::min(target_exports.size(), replacement_exports.size()));
+
+		for (size_t i = 0; i < target_exports.size(); i++)
+		{
+			if (replacements[i] != nullptr)
+			{
+				matches.emplace_back(&target_exports[i], replacements[i]);
+			}
+		}
+
+		return matches;
+	}
+}
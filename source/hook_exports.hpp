@@ -0,0 +1,32 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "hook.hpp"
+#include <vector>
+#include <utility>
+
+namespace reshade::hooks
+{
+	/// <summary>
+	/// A function exported by a module.
+	/// </summary>
+	struct module_export
+	{
+		hook::address address;
+		const char *name;
+		unsigned short ordinal;
+	};
+
+	/// <summary>
+	/// Find the exports of a target module for which the replacement module exports a function with the same name.
+	/// Both lists are sorted by name once and then merged, instead of searching through all replacement exports for every target export.
+	/// </summary>
+	/// <param name="target_exports">The exports of the module to hook. Exports without a name or address are skipped.</param>
+	/// <param name="replacement_exports">The exports of the module providing the hook functions.</param>
+	/// <returns>Pairs of target export and matching replacement export, in the order of the target exports. The pointers reference the elements of the input lists.</returns>
+	std::vector<std::pair<const module_export *, const module_export *>> match_exports(const std::vector<module_export> &target_exports, const std::vector<module_export> &replacement_exports);
+}
@@ -5,8 +5,12 @@
 
 #include "log.hpp"
 #include "hook_manager.hpp"
+#include "hook_exports.hpp"
+#include "hook_table.hpp"
 #include <assert.h>
 #include <mutex>
+#include <atomic>
+#include <memory>
 #include <algorithm>
 #include <tuple>
 #include <vector>
@@ -23,12 +27,6 @@ namespace
 		function_hook,
 		vtable_hook
 	};
-	struct module_export
-	{
-		reshade::hook::address address;
-		const char *name;
-		unsigned short ordinal;
-	};
 
 	inline auto load_module(const reshade::filesystem::path &path)
 	{
@@ -43,7 +41,7 @@ namespace
 	{
 		return GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_PIN, path.wstring().c_str(), &out_handle) && out_handle != nullptr;
 	}
-	std::vector<module_export> get_module_exports(HMODULE handle)
+	std::vector<reshade::hooks::module_export> get_module_exports(HMODULE handle)
 	{
 		const auto imagebase = reinterpret_cast<const BYTE *>(handle);
 		const auto imageheader = reinterpret_cast<const IMAGE_NT_HEADERS *>(imagebase + reinterpret_cast<const IMAGE_DOS_HEADER *>(imagebase)->e_lfanew);
@@ -61,12 +59,12 @@ namespace
 			return { };
 		}
 
-		std::vector<module_export> exports;
+		std::vector<reshade::hooks::module_export> exports;
 		exports.reserve(exportdir->NumberOfNames);
 
 		for (size_t i = 0; i < exports.capacity(); i++)
 		{
-			module_export symbol;
+			reshade::hooks::module_export symbol;
 			symbol.ordinal = reinterpret_cast<const WORD *>(imagebase + exportdir->AddressOfNameOrdinals)[i] + exportbase;
 			symbol.name = reinterpret_cast<const char *>(imagebase + reinterpret_cast<const DWORD *>(imagebase + exportdir->AddressOfNames)[i]);
 			symbol.address = const_cast<void *>(reinterpret_cast<const void *>(imagebase + reinterpret_cast<const DWORD *>(imagebase + exportdir->AddressOfFunctions)[symbol.ordinal - exportbase]));
@@ -79,6 +77,8 @@ namespace
 
 	reshade::filesystem::path s_export_hook_path;
 	std::vector<std::tuple<const char *, reshade::hook, hook_method>> s_hooks; std::mutex s_mutex_hooks;
+	// Searched by every call to "reshade::hooks::call" without a lock, only written while "s_mutex_hooks" is locked
+	reshade::hooks::hook_table s_hook_table;
 	std::vector<reshade::filesystem::path> s_delayed_hook_paths; std::mutex s_mutex_delayed_hook_paths;
 	std::unordered_map<reshade::hook::address, reshade::hook::address *> s_vtable_addresses; std::mutex s_mutex_vtable_addresses;
 
@@ -132,6 +132,8 @@ namespace
 
 		{ const std::lock_guard<std::mutex> lock(s_mutex_hooks);
 			s_hooks.push_back(std::make_tuple(name, hook, method));
+
+			s_hook_table.insert(hook);
 		}
 
 		return true;
@@ -162,27 +164,17 @@ namespace
 		LOG(INFO) << "  +--------------------+---------+----------------------------------------------------+";
 
 		// Analyze export table
-		for (const auto &symbol : target_exports)
+		for (const auto &match : reshade::hooks::match_exports(target_exports, replacement_exports))
 		{
-			if (symbol.name == nullptr || symbol.address == nullptr)
-			{
-				continue;
-			}
-
-			// Find appropriate replacement
-			const auto it = std::find_if(replacement_exports.cbegin(), replacement_exports.cend(),
-				[&symbol](const auto &moduleexport) {
-					return std::strcmp(moduleexport.name, symbol.name) == 0;
-				});
+			const auto &symbol = *match.first;
 
 			// Filter uninteresting functions
-			if (it != replacement_exports.cend() &&
-				std::strcmp(symbol.name, "DXGIReportAdapterConfiguration") != 0 &&
+			if (std::strcmp(symbol.name, "DXGIReportAdapterConfiguration") != 0 &&
 				std::strcmp(symbol.name, "DXGIDumpJournal") != 0)
 			{
 				LOG(INFO) << "  | 0x" << std::setw(16) << symbol.address << " | " << std::setw(7) << symbol.ordinal << " | " << std::setw(50) << symbol.name << " |";
 
-				matches.push_back(std::make_tuple(symbol.name, symbol.address, it->address));
+				matches.push_back(std::make_tuple(symbol.name, symbol.address, match.second->address));
 			}
 		}
 
@@ -267,19 +259,10 @@ namespace
 		return true;
 	}
 
-	reshade::hook find_internal(reshade::hook::address replacement)
-	{ const std::lock_guard<std::mutex> lock(s_mutex_hooks);
-		const auto it = std::find_if(s_hooks.cbegin(), s_hooks.cend(),
-			[replacement](const auto &hook) {
-				return std::get<1>(hook).replacement == replacement;
-			});
-
-		return it != s_hooks.cend() ? std::get<1>(*it) : reshade::hook { };
-	}
 	template <typename T>
 	inline T call_unchecked(T replacement)
 	{
-		return reinterpret_cast<T>(find_internal(reinterpret_cast<reshade::hook::address>(replacement)).call());
+		return reinterpret_cast<T>(s_hook_table.find(reinterpret_cast<reshade::hook::address>(replacement)).call());
 	}
 
 	HMODULE WINAPI HookLoadLibraryA(LPCSTR lpFileName)
@@ -378,7 +361,7 @@ bool reshade::hooks::install(const char *name, hook::address target, hook::addre
 		return false;
 	}
 
-	hook hook = find_internal(replacement);
+	hook hook = s_hook_table.find(replacement);
 
 	if (hook.installed())
 	{
@@ -446,6 +429,8 @@ void reshade::hooks::uninstall()
 	}
 
 	s_hooks.clear();
+
+	s_hook_table.clear();
 }
 void reshade::hooks::register_module(const filesystem::path &target_path)
 {
@@ -490,7 +475,7 @@ void reshade::hooks::register_module(const filesystem::path &target_path)
 
 reshade::hook::address reshade::hooks::call(hook::address replacement)
 {
-	const hook hook = find_internal(replacement);
+	const hook hook = s_hook_table.find(replacement);
 
 	if (hook.valid())
 	{
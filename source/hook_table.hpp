@@ -0,0 +1,143 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "hook.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+
+namespace reshade::hooks
+{
+	/// <summary>
+	/// A lookup table from replacement function to hook, which every call through a hook searches without taking a lock.
+	/// Adding hooks has to be serialized by the caller. Slots are filled in once and published by writing their key last, after which they never change again.
+	/// Once half of the slots are in use, they are copied into a table twice the size, which is then published in place of the current one. Replaced tables stay alive until the table is cleared, since other threads may still be searching them.
+	/// </summary>
+	class hook_table
+	{
+	public:
+		/// <summary>
+		/// Add a hook to the table. If there already is one for the same replacement, that one is kept, so that lookups never see the hook of a replacement change.
+		/// </summary>
+		/// <param name="hook">The hook to add.</param>
+		void insert(const hook &hook)
+		{
+			table *current = _current.load(std::memory_order_relaxed);
+
+			if (current == nullptr || (current->size + 1) * 2 > current->capacity)
+			{
+				auto replacement = std::make_unique<table>(current != nullptr ? current->capacity * 2 : 512);
+
+				if (current != nullptr)
+				{
+					for (size_t i = 0; i < current->capacity; i++)
+					{
+						if (current->slots[i].replacement.load(std::memory_order_relaxed) != nullptr)
+						{
+							insert_into(*replacement, current->slots[i].hook);
+						}
+					}
+				}
+
+				current = replacement.get();
+				_tables.push_back(std::move(replacement));
+			}
+
+			insert_into(*current, hook);
+
+			_current.store(current, std::memory_order_release);
+		}
+
+		/// <summary>
+		/// Find the hook for a replacement function. This may be called from any thread at any time, except while the table is cleared.
+		/// </summary>
+		/// <param name="replacement">The address of the replacement function.</param>
+		/// <returns>The hook that was added first for the replacement, or an invalid hook if there is none.</returns>
+		hook find(hook::address replacement) const
+		{
+			const table *const current = _current.load(std::memory_order_acquire);
+
+			if (current == nullptr)
+			{
+				return hook { };
+			}
+
+			for (size_t i = 0, index = hash(replacement); i < current->capacity; i++, index++)
+			{
+				const auto &slot = current->slots[index & (current->capacity - 1)];
+				const auto slot_replacement = slot.replacement.load(std::memory_order_acquire);
+
+				if (slot_replacement == replacement)
+				{
+					return slot.hook;
+				}
+				if (slot_replacement == nullptr)
+				{
+					break;
+				}
+			}
+
+			return hook { };
+		}
+
+		/// <summary>
+		/// Remove all hooks and free all tables. No other thread may search the table at the same time.
+		/// </summary>
+		void clear()
+		{
+			_current = nullptr;
+			_tables.clear();
+		}
+
+	private:
+		struct slot
+		{
+			std::atomic<reshade::hook::address> replacement = nullptr;
+			reshade::hook hook;
+		};
+		struct table
+		{
+			explicit table(size_t capacity) : capacity(capacity), slots(new slot[capacity]) { }
+
+			const size_t capacity; // Must be a power of two
+			size_t size = 0;
+			std::unique_ptr<slot[]> slots;
+		};
+
+		static size_t hash(hook::address address)
+		{
+			return static_cast<size_t>((reinterpret_cast<uintptr_t>(address) * 0x9E3779B97F4A7C15ull) >> 32);
+		}
+		static void insert_into(table &table, const hook &hook)
+		{
+			for (size_t i = 0, index = hash(hook.replacement); i < table.capacity; i++, index++)
+			{
+				auto &slot = table.slots[index & (table.capacity - 1)];
+				const auto replacement = slot.replacement.load(std::memory_order_relaxed);
+
+				if (replacement == hook.replacement)
+				{
+					return;
+				}
+				if (replacement == nullptr)
+				{
+					slot.hook = hook;
+					slot.replacement.store(hook.replacement, std::memory_order_release);
+					table.size++;
+					return;
+				}
+			}
+
+			assert(false);
+		}
+
+		std::atomic<table *> _current = nullptr;
+		std::vector<std::unique_ptr<table>> _tables;
+	};
+}
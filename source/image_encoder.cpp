@@ -0,0 +1,244 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "image_encoder.hpp"
+#include "png_encoder.hpp"
+#include <atomic>
+#include <algorithm>
+#include <stdio.h>
+#include <stb_image_write.h>
+
+namespace reshade
+{
+	struct image_encoder::image
+	{
+		filesystem::path path;
+		image_format format;
+		unsigned int width, height;
+		uint32_t sequence_number;
+		std::vector<uint8_t> pixels;
+
+		std::unique_ptr<png_encoder> png;
+		std::atomic<size_t> remaining_stripes = 0;
+	};
+
+	image_encoder::~image_encoder()
+	{
+		wait_idle();
+
+		{ const std::lock_guard<std::mutex> lock(_mutex);
+			_is_stopping = true;
+		}
+
+		_task_condition.notify_all();
+
+		for (auto &worker : _workers)
+		{
+			worker.join();
+		}
+	}
+
+	bool image_encoder::submit(const filesystem::path &path, image_format format, unsigned int width, unsigned int height, std::vector<uint8_t> &pixels, uint32_t sequence_number)
+	{
+		if (width == 0 || height == 0)
+		{
+			return false;
+		}
+
+		{ const std::lock_guard<std::mutex> lock(_mutex);
+			if (_pending_images >= _max_pending_images)
+			{
+				return false;
+			}
+
+			_pending_images++;
+
+			// Threads are only created once the first image comes in and are then kept around for later ones
+			if (_workers.empty())
+			{
+				const size_t worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+				for (size_t i = 0; i < worker_count; i++)
+				{
+					_workers.emplace_back([this]() {
+						while (true)
+						{
+							std::function<void()> task;
+
+							{ std::unique_lock<std::mutex> lock(_mutex);
+								_task_condition.wait(lock, [this]() { return _is_stopping || !_tasks.empty(); });
+
+								if (_tasks.empty())
+								{
+									break;
+								}
+
+								task = std::move(_tasks.front());
+								_tasks.pop_front();
+							}
+
+							task();
+						}
+					});
+				}
+			}
+		}
+
+		const auto img = std::make_shared<image>();
+		img->path = path;
+		img->format = format;
+		img->width = width;
+		img->height = height;
+		img->sequence_number = sequence_number;
+		img->pixels = std::move(pixels);
+
+		if (format == image_format::png)
+		{
+			// Split into more stripes than there are workers, so that they stay busy even if some stripes compress faster than others
+			img->png = std::make_unique<png_encoder>(img->pixels.data(), width, height, _workers.size() * 2);
+			img->remaining_stripes = img->png->stripe_count();
+
+			for (size_t i = 0; i < img->png->stripe_count(); i++)
+			{
+				enqueue([this, img, i]() { filter_png_stripe(img, i); });
+			}
+		}
+		else if (format == image_format::raw)
+		{
+			enqueue([this, img]() { append_raw(img); });
+		}
+		else
+		{
+			enqueue([this, img]() { encode_bmp(img); });
+		}
+
+		return true;
+	}
+	void image_encoder::take_finished(std::vector<result> &results)
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+
+		for (auto &finished : _finished)
+		{
+			results.push_back(std::move(finished));
+		}
+
+		_finished.clear();
+	}
+	void image_encoder::wait_idle()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_idle_condition.wait(lock, [this]() { return _pending_images == 0; });
+	}
+
+	size_t image_encoder::pending() const
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+		return _pending_images;
+	}
+
+	void image_encoder::enqueue(std::function<void()> &&task)
+	{
+		{ const std::lock_guard<std::mutex> lock(_mutex);
+			_tasks.push_back(std::move(task));
+		}
+
+		_task_condition.notify_one();
+	}
+
+	void image_encoder::encode_bmp(const std::shared_ptr<image> &img)
+	{
+		FILE *file;
+		bool success = false;
+
+		if (_wfopen_s(&file, img->path.wstring().c_str(), L"wb") == 0)
+		{
+			stbi_write_func *const func =
+				[](void *context, void *data, int size) {
+					fwrite(data, 1, size, static_cast<FILE *>(context));
+				};
+
+			success = stbi_write_bmp_to_func(func, file, img->width, img->height, 4, img->pixels.data()) != 0 && ferror(file) == 0;
+
+			fclose(file);
+		}
+
+		finish(img, success);
+	}
+	void image_encoder::append_raw(const std::shared_ptr<image> &img)
+	{
+		const uint32_t header[4] = { 0x46525352 /* "RSRF" */, img->width, img->height, img->sequence_number };
+
+		FILE *file;
+		bool success = false;
+
+		// Several workers may be appending to the same file
+		{ const std::lock_guard<std::mutex> lock(_append_mutex);
+			if (_wfopen_s(&file, img->path.wstring().c_str(), L"ab") == 0)
+			{
+				success = fwrite(header, 1, sizeof(header), file) == sizeof(header) && fwrite(img->pixels.data(), 1, img->pixels.size(), file) == img->pixels.size();
+
+				fclose(file);
+			}
+		}
+
+		finish(img, success);
+	}
+	void image_encoder::filter_png_stripe(const std::shared_ptr<image> &img, size_t stripe_index)
+	{
+		img->png->filter_stripe(stripe_index);
+
+		// Compression of any stripe may reference the data of the one in front of it, so it can only start once all rows are filtered
+		if (img->remaining_stripes.fetch_sub(1) == 1)
+		{
+			img->remaining_stripes = img->png->stripe_count();
+
+			for (size_t i = 0; i < img->png->stripe_count(); i++)
+			{
+				enqueue([this, img, i]() { compress_png_stripe(img, i); });
+			}
+		}
+	}
+	void image_encoder::compress_png_stripe(const std::shared_ptr<image> &img, size_t stripe_index)
+	{
+		img->png->compress_stripe(stripe_index);
+
+		if (img->remaining_stripes.fetch_sub(1) == 1)
+		{
+			enqueue([this, img]() { write_png(img); });
+		}
+	}
+	void image_encoder::write_png(const std::shared_ptr<image> &img)
+	{
+		FILE *file;
+		bool success = false;
+
+		if (_wfopen_s(&file, img->path.wstring().c_str(), L"wb") == 0)
+		{
+			success = img->png->write(file);
+
+			fclose(file);
+		}
+
+		finish(img, success);
+	}
+	void image_encoder::finish(const std::shared_ptr<image> &img, bool success)
+	{
+		result result;
+		result.path = std::move(img->path);
+		result.success = success;
+		result.pixels = std::move(img->pixels);
+
+		// Release the intermediate buffers now rather than whenever the last task holding on to the image is destroyed
+		img->png.reset();
+
+		{ const std::lock_guard<std::mutex> lock(_mutex);
+			_finished.push_back(std::move(result));
+			_pending_images--;
+		}
+
+		_idle_condition.notify_all();
+	}
+}
@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "filesystem.hpp"
+#include <mutex>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+#include <stdint.h>
+
+namespace reshade
+{
+	/// <summary>
+	/// Encodes images and writes them to disk on a pool of background threads, so that the thread submitting them only pays for getting the pixels into memory.
+	/// </summary>
+	class image_encoder
+	{
+	public:
+		enum class image_format
+		{
+			bmp,
+			png,
+			/// <summary>
+			/// Append the uncompressed pixels to the file. Each image is preceded by a 16 byte header holding the magic value "RSRF", its width, height and sequence number (all little-endian 32-bit integers).
+			/// </summary>
+			raw
+		};
+
+		struct result
+		{
+			filesystem::path path;
+			bool success = false;
+			std::vector<uint8_t> pixels; // The memory of the submitted image, handed back so that it can be reused
+		};
+
+		explicit image_encoder(size_t max_pending_images = 4) : _max_pending_images(max_pending_images) { }
+		~image_encoder();
+
+		/// <summary>
+		/// Queue an image to be encoded and written to a file.
+		/// </summary>
+		/// <param name="path">The path to the file to write.</param>
+		/// <param name="format">The file format to encode the image in.</param>
+		/// <param name="width">The width of the image.</param>
+		/// <param name="height">The height of the image.</param>
+		/// <param name="pixels">The tightly packed RGBA pixels of the image. These are moved out of the vector if the image was queued.</param>
+		/// <param name="sequence_number">A number stored along with raw images, so that they can be put back in order (images are not necessarily appended in the order they were submitted).</param>
+		/// <returns><c>true</c> if the image was queued, <c>false</c> if the image is empty or too many images are still waiting to be encoded.</returns>
+		bool submit(const filesystem::path &path, image_format format, unsigned int width, unsigned int height, std::vector<uint8_t> &pixels, uint32_t sequence_number = 0);
+		/// <summary>
+		/// Move the results of all images that finished encoding since the last call into a list.
+		/// </summary>
+		/// <param name="results">The list to append the results to.</param>
+		void take_finished(std::vector<result> &results);
+		/// <summary>
+		/// Block until all queued images have been written.
+		/// </summary>
+		void wait_idle();
+
+		/// <summary>
+		/// Returns the number of images that were queued but have not finished encoding yet.
+		/// </summary>
+		size_t pending() const;
+		/// <summary>
+		/// Returns the maximum number of images that can be queued at the same time.
+		/// </summary>
+		size_t max_pending() const { return _max_pending_images; }
+
+	private:
+		struct image;
+
+		void enqueue(std::function<void()> &&task);
+		void encode_bmp(const std::shared_ptr<image> &image);
+		void append_raw(const std::shared_ptr<image> &image);
+		void filter_png_stripe(const std::shared_ptr<image> &image, size_t stripe_index);
+		void compress_png_stripe(const std::shared_ptr<image> &image, size_t stripe_index);
+		void write_png(const std::shared_ptr<image> &image);
+		void finish(const std::shared_ptr<image> &image, bool success);
+
+		size_t _max_pending_images;
+		size_t _pending_images = 0;
+		std::vector<std::thread> _workers;
+		std::deque<std::function<void()>> _tasks;
+		std::deque<result> _finished;
+		mutable std::mutex _mutex;
+		std::mutex _append_mutex;
+		std::condition_variable _task_condition, _idle_condition;
+		bool _is_stopping = false;
+	};
+}
@@ -4,20 +4,225 @@
  */
 
 #include "log.hpp"
+#include <atomic>
+#include <fstream>
 #include <Windows.h>
 
 namespace reshade::log
 {
-	std::ofstream stream;
+	namespace
+	{
+		const size_t queue_capacity = 1024; // Must be a power of two
+		const DWORD writer_idle_timeout = 100; // Milliseconds the writer thread sleeps before checking for messages again (in case a wake up was missed)
+		const DWORD shutdown_timeout = 250; // Milliseconds to wait for the writer thread to finish its current batch during shutdown
+
+		struct record
+		{
+			std::atomic<size_t> sequence;
+			std::string text;
+		};
+
+		// Bounded multi-producer queue: every slot carries a sequence number telling whether it is free to write (equal to the position) or ready to read (position + 1)
+		record s_queue[queue_capacity];
+		std::atomic<size_t> s_enqueue_position = 0;
+		std::atomic<size_t> s_dequeue_position = 0;
+
+		std::ofstream s_stream;
+		HANDLE s_write_mutex = nullptr; // Held while reading from the queue and writing to the file, which the writer thread and threads writing directly both do
+		HANDLE s_writer_thread = nullptr;
+		HANDLE s_writer_wake_event = nullptr;
+		std::atomic<bool> s_is_writer_running = false;
+		std::atomic<bool> s_is_writer_started = false;
+		std::atomic<bool> s_is_writer_waiting = false;
+		std::atomic<bool> s_is_writer_stopping = false;
+		std::atomic<bool> s_is_writer_stopped = false;
+		std::atomic<int> s_minimum_severity = 0;
+		std::atomic<unsigned int> s_active_producers = 0;
+
+		struct write_lock
+		{
+			// A mutex object rather than "std::mutex", because waiting on it also succeeds when the writer thread was terminated while holding it (which happens on process exit)
+			write_lock() { WaitForSingleObject(s_write_mutex, INFINITE); }
+			~write_lock() { ReleaseMutex(s_write_mutex); }
+		};
+
+		int severity(level level)
+		{
+			switch (level)
+			{
+				default:
+				case level::info:
+					return 0;
+				case level::warning:
+					return 1;
+				case level::error:
+					return 2;
+			}
+		}
+
+		bool enqueue(std::string &text)
+		{
+			size_t position = s_enqueue_position.load(std::memory_order_relaxed);
+
+			while (true)
+			{
+				auto &slot = s_queue[position & (queue_capacity - 1)];
+				const auto difference = static_cast<ptrdiff_t>(slot.sequence.load(std::memory_order_acquire) - position);
+
+				if (difference == 0)
+				{
+					// The slot is free, so try to claim it before another thread does
+					if (s_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						slot.text = std::move(text);
+						slot.sequence.store(position + 1, std::memory_order_release);
+						break;
+					}
+				}
+				else if (difference < 0)
+				{
+					// The queue is full, so let the caller write the message directly instead of waiting for the writer thread, which may not get to run (e.g. while the loader lock is held)
+					return false;
+				}
+				else
+				{
+					position = s_enqueue_position.load(std::memory_order_relaxed);
+				}
+			}
+
+			// Pairs with the fence in the writer thread, so that either it sees the new message or this sees it waiting
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			if (s_is_writer_waiting.load(std::memory_order_relaxed))
+			{
+				SetEvent(s_writer_wake_event);
+			}
+
+			return true;
+		}
+		bool is_queue_empty()
+		{
+			const size_t position = s_dequeue_position.load(std::memory_order_relaxed);
+
+			return s_queue[position & (queue_capacity - 1)].sequence.load(std::memory_order_acquire) != position + 1;
+		}
+		bool write_queued_messages()
+		{
+			std::string batch, text;
+
+			// Only one thread may read from the queue at a time, so callers have to hold the write lock
+			// Batches are limited to one pass over the queue, so that a constant stream of messages still gets written out regularly
+			size_t position = s_dequeue_position.load(std::memory_order_relaxed);
+
+			for (const size_t end = position + queue_capacity; position != end; position++)
+			{
+				auto &slot = s_queue[position & (queue_capacity - 1)];
+
+				if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+				{
+					break;
+				}
+
+				text = std::move(slot.text);
+				slot.text.clear();
+				slot.sequence.store(position + queue_capacity, std::memory_order_release);
+
+				batch += text;
+			}
+
+			s_dequeue_position.store(position, std::memory_order_relaxed);
+
+			if (batch.empty())
+			{
+				return false;
+			}
+
+			// Write everything that was collected at once, instead of flushing the file after every line
+			s_stream.write(batch.data(), batch.size());
+			s_stream.flush();
+
+			return true;
+		}
+
+		void write_directly(const std::string &text)
+		{
+			const write_lock lock;
+
+			// Write out everything queued so far first, so that messages of this thread stay in order
+			// Another thread may have claimed a slot and not filled it yet, so wait for that, but only for a bounded time in case it was terminated
+			const size_t end = s_enqueue_position.load();
+			const DWORD start_time = GetTickCount();
+
+			while (static_cast<ptrdiff_t>(end - s_dequeue_position.load(std::memory_order_relaxed)) > 0 && GetTickCount() - start_time < shutdown_timeout)
+			{
+				if (!write_queued_messages())
+				{
+					SwitchToThread();
+				}
+			}
+
+			s_stream << text;
+			s_stream.flush();
+		}
+
+		DWORD WINAPI writer_main(LPVOID)
+		{
+			// Threads created in "DllMain" only start once the loader lock is released, everything logged until then is written directly
+			s_is_writer_started = true;
+
+			while (!s_is_writer_stopping.load())
+			{
+				bool has_written = false;
+
+				{ const write_lock lock;
+					has_written = write_queued_messages();
+				}
+
+				if (has_written)
+				{
+					continue;
+				}
+
+				s_is_writer_waiting.store(true, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				// Check again after announcing the wait, since a message queued in between would otherwise only be written after the timeout
+				if (is_queue_empty() && !s_is_writer_stopping.load())
+				{
+					WaitForSingleObject(s_writer_wake_event, writer_idle_timeout);
+				}
 
-	message::message(level level)
+				s_is_writer_waiting.store(false, std::memory_order_relaxed);
+			}
+
+			s_is_writer_stopped = true;
+
+			return 0;
+		}
+	}
+
+	thread_local line_stream t_stream;
+	thread_local bool t_is_stream_in_use = false;
+
+	message::message(level level) :
+		_nested_stream(t_is_stream_in_use ? std::make_unique<line_stream>() : nullptr),
+		_stream(_nested_stream != nullptr ? *_nested_stream : t_stream)
 	{
+		if (_nested_stream == nullptr)
+		{
+			t_is_stream_in_use = true;
+		}
+
+		// Undo any formatting changes a previous message left behind
+		_stream.buffer.text.clear();
+		_stream.flags(std::ios_base::dec | std::ios_base::skipws | std::ios_base::showbase);
+
 		SYSTEMTIME time;
 		GetLocalTime(&time);
 
 		const char level_names[][6] = { "INFO ", "ERROR", "WARN " };
 
-		stream << std::right << std::setfill('0')
+		_stream << std::right << std::setfill('0')
 			<< std::setw(4) << time.wYear << '-'
 			<< std::setw(2) << time.wMonth << '-'
 			<< std::setw(2) << time.wDay << 'T'
@@ -30,22 +235,100 @@ namespace reshade::log
 	}
 	message::~message()
 	{
-		stream << std::endl;
+		_stream.buffer.text.push_back('\n');
+
+		// Announce this thread before checking whether the writer thread runs, so that "close" can wait for it to finish queuing the message
+		s_active_producers.fetch_add(1);
+		const bool is_queued = s_is_writer_running.load() && s_is_writer_started.load() && enqueue(_stream.buffer.text);
+		s_active_producers.fetch_sub(1);
+
+		if (!is_queued && s_stream.is_open())
+		{
+			write_directly(_stream.buffer.text);
+		}
+
+		if (_nested_stream == nullptr)
+		{
+			t_is_stream_in_use = false;
+		}
 	}
 
 	bool open(const filesystem::path &path)
 	{
-		stream.open(path.wstring(), std::ios::out | std::ios::trunc);
+		s_stream.open(path.wstring(), std::ios::out | std::ios::trunc);
 
-		if (!stream.is_open())
+		if (!s_stream.is_open())
 		{
 			return false;
 		}
 
-		stream.setf(std::ios_base::showbase);
+		for (size_t i = 0; i < queue_capacity; i++)
+		{
+			s_queue[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		s_enqueue_position = 0;
+		s_dequeue_position = 0;
+		s_is_writer_started = false;
+		s_is_writer_stopping = false;
+		s_is_writer_stopped = false;
+
+		if (s_write_mutex == nullptr)
+		{
+			s_write_mutex = CreateMutexW(nullptr, FALSE, nullptr);
+		}
+
+		// Use the Windows API rather than "std::thread", whose constructor waits for the new thread to start, which would dead lock when called from "DllMain"
+		s_writer_wake_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+		s_writer_thread = CreateThread(nullptr, 0, &writer_main, nullptr, 0, nullptr);
 
-		stream.flush();
+		s_is_writer_running = s_write_mutex != nullptr && s_writer_wake_event != nullptr && s_writer_thread != nullptr;
 
 		return true;
 	}
+	void close()
+	{
+		if (!s_is_writer_running.exchange(false))
+		{
+			return;
+		}
+
+		// Give the writer thread and threads that are queuing a message right now a bounded amount of time to finish.
+		// On process exit the system already terminated all of them, so the writer thread handle is signaled and the wait for producers times out.
+		const DWORD start_time = GetTickCount();
+
+		while (s_active_producers.load() != 0 && GetTickCount() - start_time < shutdown_timeout)
+		{
+			SwitchToThread();
+		}
+
+		s_is_writer_stopping = true;
+		SetEvent(s_writer_wake_event);
+
+		while (!s_is_writer_stopped.load() && WaitForSingleObject(s_writer_thread, 0) == WAIT_TIMEOUT && GetTickCount() - start_time < shutdown_timeout)
+		{
+			Sleep(1);
+		}
+
+		// Write out whatever is left, the lock keeps this from interfering with a writer thread that is still busy
+		{ const write_lock lock;
+			while (write_queued_messages())
+				continue;
+		}
+
+		// The mutex is kept, since messages logged from now on are written directly under it
+		CloseHandle(s_writer_thread);
+		CloseHandle(s_writer_wake_event);
+		s_writer_thread = nullptr;
+		s_writer_wake_event = nullptr;
+	}
+
+	void set_level(level level)
+	{
+		s_minimum_severity = severity(level);
+	}
+	bool is_enabled(level level)
+	{
+		return severity(level) >= s_minimum_severity.load(std::memory_order_relaxed);
+	}
 }
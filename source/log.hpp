@@ -5,15 +5,18 @@
 
 #pragma once
 
-#include <fstream>
+#include <memory>
+#include <ostream>
 #include <iomanip>
 #include "string_codecvt.hpp"
 #include "filesystem.hpp"
 
 #define LOG(LEVEL) LOG_##LEVEL()
-#define LOG_INFO() reshade::log::message(reshade::log::level::info)
-#define LOG_ERROR() reshade::log::message(reshade::log::level::error)
-#define LOG_WARNING() reshade::log::message(reshade::log::level::warning)
+// Messages below the configured level are skipped without evaluating their arguments
+#define LOG_MESSAGE(LEVEL) !reshade::log::is_enabled(LEVEL) ? (void)0 : reshade::log::voidify() & reshade::log::message(LEVEL)
+#define LOG_INFO() LOG_MESSAGE(reshade::log::level::info)
+#define LOG_ERROR() LOG_MESSAGE(reshade::log::level::error)
+#define LOG_WARNING() LOG_MESSAGE(reshade::log::level::warning)
 
 namespace reshade::log
 {
@@ -24,7 +27,31 @@ namespace reshade::log
 		warning,
 	};
 
-	extern std::ofstream stream;
+	/// <summary>
+	/// A stream that formats a line of text into a string.
+	/// </summary>
+	struct line_stream : public std::ostream
+	{
+		line_stream() : std::ostream(&buffer) { }
+
+		struct string_buffer : public std::streambuf
+		{
+			std::string text;
+
+		private:
+			int_type overflow(int_type c) override
+			{
+				if (c != traits_type::eof())
+					text.push_back(traits_type::to_char_type(c));
+				return traits_type::not_eof(c);
+			}
+			std::streamsize xsputn(const char *s, std::streamsize n) override
+			{
+				text.append(s, static_cast<size_t>(n));
+				return n;
+			}
+		} buffer;
+	};
 
 	struct message
 	{
@@ -34,13 +61,13 @@ namespace reshade::log
 		template <typename T>
 		inline message &operator<<(const T &value)
 		{
-			stream << value;
+			_stream << value;
 
 			return *this;
 		}
 		inline message &operator<<(const char *message)
 		{
-			stream << message;
+			_stream << message;
 
 			return *this;
 		}
@@ -53,11 +80,35 @@ namespace reshade::log
 		{
 			return operator<<(utf16_to_utf8(message));
 		}
+
+	private:
+		// Lines are built up here and only handed to the writer thread once complete, so that they never interleave
+		// This is a stream reused by all messages of the current thread, unless one is logged while formatting another, which then gets its own
+		std::unique_ptr<line_stream> _nested_stream;
+		line_stream &_stream;
+	};
+	struct voidify
+	{
+		void operator&(const message &) { }
 	};
 
 	/// <summary>
-	/// Open a log file for writing.
+	/// Open a log file for writing and start the background thread writing queued messages to it.
 	/// </summary>
 	/// <param name="path">The path to the log file.</param>
 	bool open(const filesystem::path &path);
+	/// <summary>
+	/// Write all queued messages to the log file and stop the background thread. Messages logged afterwards are written immediately.
+	/// </summary>
+	void close();
+
+	/// <summary>
+	/// Set the least severe level of messages that are still logged (in order of severity: info, warning, error).
+	/// </summary>
+	/// <param name="level">The minimum level.</param>
+	void set_level(level level);
+	/// <summary>
+	/// Returns whether messages of the specified level are logged.
+	/// </summary>
+	bool is_enabled(level level);
 }
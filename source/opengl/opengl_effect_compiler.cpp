@@ -3,6 +3,8 @@
  * License: https://github.com/crosire/reshade#license
  */
 
+#include "log.hpp"
+#include "profiler.hpp"
 #include "opengl_runtime.hpp"
 #include "opengl_effect_compiler.hpp"
 #include <assert.h>
@@ -362,12 +364,6 @@ namespace reshade::opengl
 
 		return code;
 	}
-	static inline uintptr_t align(uintptr_t address, size_t alignment)
-	{
-		if (address % alignment != 0)
-			address += alignment - address % alignment;
-		return address;
-	}
 
 	opengl_effect_compiler::opengl_effect_compiler(opengl_runtime *runtime, const syntax_tree &ast, std::string &errors) :
 		_runtime(runtime),
@@ -380,15 +376,52 @@ namespace reshade::opengl
 
 	bool opengl_effect_compiler::run()
 	{
+		const profiler::zone profile_zone("generate_code");
+
 		_uniform_storage_offset = _runtime->get_uniform_value_storage().size();
 
+		// Lay out all uniforms up front, so that the storage is only resized once and the packer is free to reorder them
+		for (auto uniform : _ast.variables)
+		{
+			if (!uniform->type.is_texture() && !uniform->type.is_sampler() && uniform->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				// Matrices are declared as "matRxC", which GLSL stores as R columns of C components each
+				if (uniform->type.cols > 1)
+				{
+					_uniform_layout.add(uniform->type.cols, uniform->type.rows, std::max(0, uniform->type.array_length));
+				}
+				else
+				{
+					_uniform_layout.add(uniform->type.rows, 1, std::max(0, uniform->type.array_length));
+				}
+			}
+		}
+
+		_uniform_layout.pack();
+		_uniform_declarations.resize(_uniform_layout.order().size());
+
+		_uniform_buffer_size = _uniform_layout.size();
+		_runtime->get_uniform_value_storage().resize(_uniform_storage_offset + _uniform_buffer_size);
+
+		if (_uniform_buffer_size != 0)
+		{
+			LOG(INFO) << "> Packed uniforms into " << _uniform_buffer_size << " bytes, " << _uniform_layout.padding() << " of which are padding.";
+		}
+
+		// Remember where each global declaration starts, so that shaders can pick only those they need later on
 		for (auto node : _ast.structs)
 		{
+			_global_declarations.push_back({ node, static_cast<size_t>(_global_code.tellp()) });
+
 			visit(_global_code, node);
 		}
 
+		size_t uniform_index = 0;
+
 		for (auto uniform : _ast.variables)
 		{
+			_global_declarations.push_back({ uniform, static_cast<size_t>(_global_code.tellp()) });
+
 			if (uniform->type.is_texture())
 			{
 				visit_texture(uniform);
@@ -399,7 +432,7 @@ namespace reshade::opengl
 			}
 			else if (uniform->type.has_qualifier(type_node::qualifier_uniform))
 			{
-				visit_uniform(uniform);
+				visit_uniform(uniform, uniform_index++);
 			}
 			else
 			{
@@ -409,6 +442,12 @@ namespace reshade::opengl
 			}
 		}
 
+		// There is no way to specify explicit offsets in std140 blocks, so declare uniforms in the order the layout placed them
+		for (size_t index : _uniform_layout.order())
+		{
+			_global_uniforms << _uniform_declarations[index];
+		}
+
 		for (auto function : _ast.functions)
 		{
 			std::stringstream function_code;
@@ -441,6 +480,17 @@ namespace reshade::opengl
 			_runtime->_effect_ubos.emplace_back(ubo, _uniform_buffer_size);
 		}
 
+		// Shaders were kept around so that later passes could link them again, the programs no longer need them
+		for (const auto &shader : _shaders)
+		{
+			glDeleteShader(shader.second);
+		}
+
+		if (_shaders.reused_count() != 0)
+		{
+			LOG(INFO) << "> Reused " << _shaders.reused_count() << " shaders across passes instead of compiling them again.";
+		}
+
 		return _success;
 	}
 
@@ -2140,25 +2190,29 @@ namespace reshade::opengl
 
 		_runtime->_effect_samplers.push_back(std::move(sampler));
 	}
-	void opengl_effect_compiler::visit_uniform(const variable_declaration_node *node)
+	void opengl_effect_compiler::visit_uniform(const variable_declaration_node *node, size_t index)
 	{
-		visit(_global_uniforms, node->type, true, false);
+		std::stringstream declaration;
 
-		_global_uniforms << ' ' << escape_name(node->unique_name);
+		visit(declaration, node->type, true, false);
+
+		declaration << ' ' << escape_name(node->unique_name);
 
 		if (node->type.is_array())
 		{
-			_global_uniforms << '[';
+			declaration << '[';
 
 			if (node->type.array_length > 0)
 			{
-				_global_uniforms << node->type.array_length;
+				declaration << node->type.array_length;
 			}
 
-			_global_uniforms << ']';
+			declaration << ']';
 		}
 
-		_global_uniforms << ";\n";
+		declaration << ";\n";
+
+		_uniform_declarations[index] = declaration.str();
 
 		uniform obj;
 		obj.name = node->name;
@@ -2170,33 +2224,12 @@ namespace reshade::opengl
 		obj.storage_size = obj.rows * obj.columns * std::max(1u, obj.elements) * 4;
 		obj.annotations = node->annotation_list;
 
-		// GLSL specification on std140 layout:
-		// 1. If the member is a scalar consuming N basic machine units, the base alignment is N.
-		// 2. If the member is a two- or four-component vector with components consuming N basic machine units, the base alignment is 2N or 4N, respectively.
-		// 3. If the member is a three-component vector with components consuming N basic machine units, the base alignment is 4N.
-		size_t alignment = obj.storage_size;
-		if (obj.rows == 3)
-		{
-			alignment = alignment * 4 / 3;
-		}
-		_uniform_buffer_size = align(_uniform_buffer_size, alignment);
-		obj.storage_offset = _uniform_storage_offset + _uniform_buffer_size;
-		_uniform_buffer_size += obj.storage_size;
-
-		auto &uniform_storage = _runtime->get_uniform_value_storage();
-
-		if (_uniform_storage_offset + _uniform_buffer_size >= static_cast<ptrdiff_t>(uniform_storage.size()))
-		{
-			uniform_storage.resize(uniform_storage.size() + 128);
-		}
+		obj.storage_offset = _uniform_storage_offset + _uniform_layout.offset(index);
 
+		// The storage was already resized and zero-initialized in 'run', so only explicit initializers need to be copied
 		if (node->initializer_expression != nullptr && node->initializer_expression->id == nodeid::literal_expression)
 		{
-			std::memcpy(uniform_storage.data() + obj.storage_offset, &static_cast<const literal_expression_node *>(node->initializer_expression)->value_float, obj.storage_size);
-		}
-		else
-		{
-			std::memset(uniform_storage.data() + obj.storage_offset, 0, obj.storage_size);
+			std::memcpy(_runtime->get_uniform_value_storage().data() + obj.storage_offset, &static_cast<const literal_expression_node *>(node->initializer_expression)->value_float, obj.storage_size);
 		}
 
 		_runtime->add_uniform(std::move(obj));
@@ -2320,10 +2353,14 @@ namespace reshade::opengl
 		{
 			if (shader_functions[i] != nullptr)
 			{
-				shaders[i] = glCreateShader(shader_types[i]);
-
 				visit_pass_shader(shader_functions[i], shader_types[i], shaders[i]);
 
+				if (shaders[i] == 0)
+				{
+					glDeleteProgram(pass.program);
+					return;
+				}
+
 				glAttachShader(pass.program, shaders[i]);
 			}
 		}
@@ -2333,7 +2370,6 @@ namespace reshade::opengl
 		for (unsigned int i = 0; i < 2; i++)
 		{
 			glDetachShader(pass.program, shaders[i]);
-			glDeleteShader(shaders[i]);
 		}
 
 		GLint status = GL_FALSE;
@@ -2386,7 +2422,13 @@ namespace reshade::opengl
 			source << "#define discard\n";
 		}
 
-		source << _global_code.str();
+		// Only include the global declarations this entry point actually uses, so that the compiler does not have to parse and strip all the others
+		const std::string global_code = _global_code.str();
+		const std::string used_global_code = extract_dependencies(node, global_code, _global_declarations);
+
+		LOG(INFO) << "> Shader '" << node->name << "' uses " << used_global_code.size() << " of " << global_code.size() << " bytes of global code.";
+
+		source << used_global_code;
 
 		for (auto dependency : _functions.at(node).dependencies)
 		{
@@ -2605,9 +2647,20 @@ namespace reshade::opengl
 		const GLchar *src = source_str.c_str();
 		const GLsizei len = static_cast<GLsizei>(source_str.size());
 
-		glShaderSource(shader, 1, &src, &len);
-		glCompileShader(shader);
-		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		const uint64_t shader_key = shader_cache::key(std::string(), source_str, node->unique_name, std::to_string(shadertype), 0);
+
+		if (_shaders.find(shader_key, shader))
+		{
+			return;
+		}
+
+		shader = glCreateShader(shadertype);
+
+		{ const profiler::zone profile_zone("compile_shader", node->unique_name);
+			glShaderSource(shader, 1, &src, &len);
+			glCompileShader(shader);
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		}
 
 		if (status == GL_FALSE)
 		{
@@ -2617,9 +2670,15 @@ namespace reshade::opengl
 			std::string log(logsize, '\0');
 			glGetShaderInfoLog(shader, logsize, nullptr, &log.front());
 
+			glDeleteShader(shader);
+			shader = 0;
+
 			_errors += log;
 			error(node->location, "internal shader compilation failed");
+			return;
 		}
+
+		_shaders.insert(shader_key, shader);
 	}
 	void opengl_effect_compiler::visit_shader_param(std::stringstream &output, type_node type, unsigned int qualifier, const std::string &name, const std::string &semantic, unsigned int shadertype)
 	{
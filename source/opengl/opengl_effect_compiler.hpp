@@ -6,6 +6,9 @@
 #pragma once
 
 #include "effect_syntax_tree.hpp"
+#include "effect_dependencies.hpp"
+#include "uniform_layout.hpp"
+#include "shader_reuse_table.hpp"
 #include <sstream>
 
 namespace reshade::opengl
@@ -59,7 +62,7 @@ namespace reshade::opengl
 
 		void visit_texture(const reshadefx::nodes::variable_declaration_node *node);
 		void visit_sampler(const reshadefx::nodes::variable_declaration_node *node);
-		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node);
+		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node, size_t index);
 		void visit_technique(const reshadefx::nodes::technique_declaration_node *node);
 		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, opengl_pass_data &pass);
 		void visit_pass_shader(const reshadefx::nodes::function_declaration_node *node, unsigned int shadertype, unsigned int &shader);
@@ -76,8 +79,12 @@ namespace reshade::opengl
 		const reshadefx::syntax_tree &_ast;
 		std::string &_errors;
 		std::stringstream _global_code, _global_uniforms;
+		std::vector<reshadefx::global_declaration> _global_declarations;
 		const reshadefx::nodes::function_declaration_node *_current_function;
 		std::unordered_map<const reshadefx::nodes::function_declaration_node *, function> _functions;
 		GLintptr _uniform_storage_offset = 0, _uniform_buffer_size = 0;
+		uniform_layout _uniform_layout { uniform_layout::packing_rules::std140 };
+		std::vector<std::string> _uniform_declarations;
+		shader_reuse_table<GLuint> _shaders;
 	};
 }
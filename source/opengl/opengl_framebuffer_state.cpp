@@ -0,0 +1,117 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "opengl_framebuffer_state.hpp"
+
+namespace reshade::opengl
+{
+	void framebuffer_state::reset()
+	{
+		_is_draw_fbo_known = false;
+		_is_read_fbo_known = false;
+		_is_draw_depth_known = false;
+		_draw_fbo = _read_fbo = _draw_depth_id = 0;
+		_depth_attachments.clear();
+	}
+
+	void framebuffer_state::bind(GLenum target, GLuint fbo)
+	{
+		switch (target)
+		{
+			case GL_FRAMEBUFFER:
+				_draw_fbo = _read_fbo = fbo;
+				_is_draw_fbo_known = _is_read_fbo_known = true;
+				break;
+			case GL_DRAW_FRAMEBUFFER:
+				_draw_fbo = fbo;
+				_is_draw_fbo_known = true;
+				break;
+			case GL_READ_FRAMEBUFFER:
+				_read_fbo = fbo;
+				_is_read_fbo_known = true;
+				return;
+			default:
+				return;
+		}
+
+		update_draw_depth_attachment();
+	}
+	void framebuffer_state::attach(GLuint fbo, GLenum attachment, GLuint id)
+	{
+		if (fbo == 0 || (attachment != GL_DEPTH_ATTACHMENT && attachment != GL_DEPTH_STENCIL_ATTACHMENT))
+		{
+			return;
+		}
+
+		_depth_attachments[fbo] = id;
+
+		if (_is_draw_fbo_known && fbo == _draw_fbo)
+		{
+			update_draw_depth_attachment();
+		}
+	}
+	void framebuffer_state::remove(GLsizei count, const GLuint *fbos)
+	{
+		for (GLsizei i = 0; i < count; ++i)
+		{
+			const GLuint fbo = fbos[i];
+
+			if (fbo == 0)
+			{
+				continue;
+			}
+
+			_depth_attachments.erase(fbo);
+
+			if (_is_draw_fbo_known && fbo == _draw_fbo)
+			{
+				_draw_fbo = 0;
+			}
+			if (_is_read_fbo_known && fbo == _read_fbo)
+			{
+				_read_fbo = 0;
+			}
+		}
+
+		update_draw_depth_attachment();
+	}
+
+	bool framebuffer_state::find_binding(GLenum target, GLuint &fbo) const
+	{
+		switch (target)
+		{
+			case GL_FRAMEBUFFER:
+			case GL_DRAW_FRAMEBUFFER:
+				fbo = _draw_fbo;
+				return _is_draw_fbo_known;
+			case GL_READ_FRAMEBUFFER:
+				fbo = _read_fbo;
+				return _is_read_fbo_known;
+			default:
+				return false;
+		}
+	}
+
+	void framebuffer_state::update_draw_depth_attachment()
+	{
+		_draw_depth_id = 0;
+
+		// The default frame buffer has no attachments to look up, it always uses the default depth buffer
+		if (!_is_draw_fbo_known || _draw_fbo == 0)
+		{
+			_is_draw_depth_known = _is_draw_fbo_known;
+			return;
+		}
+
+		const auto it = _depth_attachments.find(_draw_fbo);
+
+		_is_draw_depth_known = it != _depth_attachments.end();
+
+		if (_is_draw_depth_known)
+		{
+			_draw_depth_id = it->second;
+		}
+	}
+}
@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <GL/gl3w.h>
+#include <unordered_map>
+
+namespace reshade::opengl
+{
+	/// <summary>
+	/// A copy of the frame buffer bindings and depth attachments of a context, which the hooks keep up to date so that draw calls do not have to query them from the driver.
+	/// This only does bookkeeping and never calls into OpenGL itself. Anything it was not told about yet is reported as unknown, so that the caller can query it once and pass it in.
+	/// </summary>
+	class framebuffer_state
+	{
+	public:
+		/// <summary>
+		/// Build the identifier of a depth attachment, which is the object name with the highest bit set for render buffers.
+		/// </summary>
+		/// <param name="objecttarget">The type of the attached object (<c>GL_RENDERBUFFER</c> or a texture target).</param>
+		/// <param name="object">The name of the attached object, or zero if nothing is attached.</param>
+		static GLuint make_attachment_id(GLenum objecttarget, GLuint object)
+		{
+			return object == 0 ? 0 : object | (objecttarget == GL_RENDERBUFFER ? 0x80000000 : 0);
+		}
+
+		/// <summary>
+		/// Forget all bindings and attachments, e.g. because a different context was made current.
+		/// </summary>
+		void reset();
+
+		/// <summary>
+		/// Update the frame buffer bound to the specified target.
+		/// </summary>
+		/// <param name="target">The target passed to <c>glBindFramebuffer</c>.</param>
+		/// <param name="fbo">The name of the frame buffer, or zero for the default one.</param>
+		void bind(GLenum target, GLuint fbo);
+		/// <summary>
+		/// Update the depth attachment of a frame buffer.
+		/// </summary>
+		/// <param name="fbo">The name of the frame buffer (which does not have to be bound).</param>
+		/// <param name="attachment">The attachment point. Everything but <c>GL_DEPTH_ATTACHMENT</c> and <c>GL_DEPTH_STENCIL_ATTACHMENT</c> is ignored.</param>
+		/// <param name="id">The identifier of the attached object as returned by <see cref="make_attachment_id"/>, or zero if it was detached.</param>
+		void attach(GLuint fbo, GLenum attachment, GLuint id);
+		/// <summary>
+		/// Forget about deleted frame buffers. Those that were bound revert to the default frame buffer, like they do in OpenGL.
+		/// </summary>
+		void remove(GLsizei count, const GLuint *fbos);
+
+		/// <summary>
+		/// Get the frame buffer bound to the specified target.
+		/// </summary>
+		/// <returns><c>true</c> if the binding is known, <c>false</c> otherwise.</returns>
+		bool find_binding(GLenum target, GLuint &fbo) const;
+		/// <summary>
+		/// Get the frame buffer bound for drawing and its depth attachment. This does not look anything up, so it is cheap enough to call on every draw call.
+		/// </summary>
+		/// <param name="fbo">Set to the name of the bound frame buffer.</param>
+		/// <param name="id">Set to the identifier of its depth attachment, or zero if there is none (or it is the default frame buffer).</param>
+		/// <returns><c>true</c> if both are known, <c>false</c> otherwise.</returns>
+		bool find_draw_depth_attachment(GLuint &fbo, GLuint &id) const
+		{
+			fbo = _draw_fbo;
+			id = _draw_depth_id;
+
+			return _is_draw_depth_known;
+		}
+
+	private:
+		void update_draw_depth_attachment();
+
+		bool _is_draw_fbo_known = false, _is_read_fbo_known = false, _is_draw_depth_known = false;
+		GLuint _draw_fbo = 0, _read_fbo = 0, _draw_depth_id = 0;
+		std::unordered_map<GLuint, GLuint> _depth_attachments;
+	};
+}
@@ -7,8 +7,10 @@
 #include "opengl_runtime.hpp"
 #include "opengl_effect_compiler.hpp"
 #include "input.hpp"
+#include "texel_conversion.hpp"
 #include <imgui.h>
 #include <assert.h>
+#include <algorithm>
 
 namespace reshade::opengl
 {
@@ -500,24 +502,37 @@ namespace reshade::opengl
 		_vertices += vertices;
 		_drawcalls += 1;
 
-		GLint fbo = 0, object = 0, objecttarget = GL_NONE;
-		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &fbo);
+		GLuint fbo = 0, id = 0;
 
-		if (fbo != 0)
+		if (!_framebuffer_state.find_draw_depth_attachment(fbo, id))
 		{
-			glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &objecttarget);
+			// Query what the hooks have not seen yet (like frame buffers that were set up before the runtime was created) once and remember it
+			GLint binding = 0, object = 0, objecttarget = GL_NONE;
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &binding);
 
-			if (objecttarget == GL_NONE)
-			{
-				return;
-			}
-			else
+			fbo = binding;
+			_framebuffer_state.bind(GL_DRAW_FRAMEBUFFER, fbo);
+
+			if (fbo != 0)
 			{
-				glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &object);
+				glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &objecttarget);
+
+				if (objecttarget != GL_NONE)
+				{
+					glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &object);
+				}
+
+				id = framebuffer_state::make_attachment_id(objecttarget, object);
+				_framebuffer_state.attach(fbo, GL_DEPTH_ATTACHMENT, id);
 			}
 		}
 
-		const auto it = _depth_source_table.find(object | (objecttarget == GL_RENDERBUFFER ? 0x80000000 : 0));
+		if (fbo != 0 && id == 0)
+		{
+			return;
+		}
+
+		const auto it = _depth_source_table.find(id);
 
 		if (it != _depth_source_table.end())
 		{
@@ -527,25 +542,44 @@ namespace reshade::opengl
 	}
 	void opengl_runtime::on_fbo_attachment(GLenum target, GLenum attachment, GLenum objecttarget, GLuint object, GLint level)
 	{
-		if (object == 0 || (attachment != GL_DEPTH_ATTACHMENT && attachment != GL_DEPTH_STENCIL_ATTACHMENT))
+		if (attachment != GL_DEPTH_ATTACHMENT && attachment != GL_DEPTH_STENCIL_ATTACHMENT)
 		{
 			return;
 		}
 
 		// Get current frame buffer
-		GLint fbo = 0;
-		glGetIntegerv(target_to_binding(target), &fbo);
+		GLuint fbo = 0;
+
+		if (!_framebuffer_state.find_binding(target, fbo))
+		{
+			GLint binding = 0;
+			glGetIntegerv(target_to_binding(target), &binding);
+
+			fbo = binding;
+		}
+
+		on_named_fbo_attachment(fbo, attachment, objecttarget, object, level);
+	}
+	void opengl_runtime::on_named_fbo_attachment(GLuint fbo, GLenum attachment, GLenum objecttarget, GLuint object, GLint level)
+	{
+		if (attachment != GL_DEPTH_ATTACHMENT && attachment != GL_DEPTH_STENCIL_ATTACHMENT)
+		{
+			return;
+		}
 
 		assert(fbo != 0);
 
-		if (static_cast<GLuint>(fbo) == _default_backbuffer_fbo || static_cast<GLuint>(fbo) == _depth_source_fbo || static_cast<GLuint>(fbo) == _blit_fbo)
+		if (fbo == _default_backbuffer_fbo || fbo == _depth_source_fbo || fbo == _blit_fbo)
 		{
 			return;
 		}
 
-		const GLuint id = object | (objecttarget == GL_RENDERBUFFER ? 0x80000000 : 0);
-		
-		if (_depth_source_table.find(id) != _depth_source_table.end())
+		const GLuint id = framebuffer_state::make_attachment_id(objecttarget, object);
+
+		// Detaching has to be tracked too, so that draw calls to this frame buffer stop counting towards the previous attachment
+		_framebuffer_state.attach(fbo, attachment, id);
+
+		if (object == 0 || _depth_source_table.find(id) != _depth_source_table.end())
 		{
 			return;
 		}
@@ -587,6 +621,19 @@ namespace reshade::opengl
 
 		_depth_source_table.emplace(id, info);
 	}
+	void opengl_runtime::on_bind_framebuffer(GLenum target, GLuint fbo)
+	{
+		_framebuffer_state.bind(target, fbo);
+	}
+	void opengl_runtime::on_delete_framebuffers(GLsizei count, const GLuint *fbos)
+	{
+		_framebuffer_state.remove(count, fbos);
+	}
+	void opengl_runtime::on_switch_context()
+	{
+		// Frame buffers are not shared between contexts, so everything known about the previous one is useless now
+		_framebuffer_state.reset();
+	}
 
 	void opengl_runtime::capture_frame(uint8_t *buffer) const
 	{
@@ -598,21 +645,15 @@ namespace reshade::opengl
 		// Flip image
 		const unsigned int pitch = _width * 4;
 
-		for (unsigned int y = 0; y * 2 < _height; ++y)
+		for (unsigned int y = 0; y * 2 + 1 < _height; ++y)
 		{
-			const unsigned int i1 = y * pitch;
-			const unsigned int i2 = (_height - 1 - y) * pitch;
+			const auto line1 = buffer + y * pitch;
+			const auto line2 = buffer + (_height - 1 - y) * pitch;
 
-			for (unsigned int x = 0; x < pitch; x += 4)
-			{
-				buffer[i1 + x + 3] = 0xFF;
-				buffer[i2 + x + 3] = 0xFF;
-
-				std::swap(buffer[i1 + x + 0], buffer[i2 + x + 0]);
-				std::swap(buffer[i1 + x + 1], buffer[i2 + x + 1]);
-				std::swap(buffer[i1 + x + 2], buffer[i2 + x + 2]);
-			}
+			std::swap_ranges(line1, line1 + pitch, line2);
 		}
+
+		texel_conversion::fill_alpha(buffer, buffer, _width * _height);
 	}
 	bool opengl_runtime::load_effect(const reshadefx::syntax_tree &ast, std::string &errors)
 	{
@@ -640,23 +681,17 @@ namespace reshade::opengl
 		glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
 
 		// Flip image data vertically
-		unsigned int stride = texture.width * 4;
-		std::vector<uint8_t> data_flipped(data, data + stride * texture.height);
-		const auto temp = static_cast<uint8_t *>(alloca(stride));
+		const unsigned int stride = texture.width * 4;
+		_texture_upload_buffer.resize(stride * texture.height);
 
-		for (unsigned int y = 0; 2 * y < texture.height; y++)
+		for (unsigned int y = 0; y < texture.height; y++)
 		{
-			const auto line1 = data_flipped.data() + stride * (y);
-			const auto line2 = data_flipped.data() + stride * (texture.height - 1 - y);
-
-			std::memcpy(temp, line1, stride);
-			std::memcpy(line1, line2, stride);
-			std::memcpy(line2, temp, stride);
+			std::memcpy(_texture_upload_buffer.data() + stride * y, data + stride * (texture.height - 1 - y), stride);
 		}
 
 		// Bind and update texture
 		glBindTexture(GL_TEXTURE_2D, texture_impl->id[0]);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture.width, texture.height, GL_RGBA, GL_UNSIGNED_BYTE, data_flipped.data());
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture.width, texture.height, GL_RGBA, GL_UNSIGNED_BYTE, _texture_upload_buffer.data());
 
 		if (texture.levels > 1)
 		{
@@ -723,8 +758,19 @@ namespace reshade::opengl
 		// Setup shader constants
 		if (technique.uniform_storage_index >= 0)
 		{
-			glBindBufferBase(GL_UNIFORM_BUFFER, 0, _effect_ubos[technique.uniform_storage_index].first);
-			glBufferSubData(GL_UNIFORM_BUFFER, 0, _effect_ubos[technique.uniform_storage_index].second, get_uniform_value_storage().data() + technique.uniform_storage_offset);
+			const auto &ubo = _effect_ubos[technique.uniform_storage_index];
+
+			glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo.first);
+
+			// Techniques of the same effect share a uniform buffer, so only upload it if any of its values changed since the last upload
+			if (is_uniform_storage_dirty(technique.uniform_storage_offset, ubo.second))
+			{
+				glBufferSubData(GL_UNIFORM_BUFFER, 0, ubo.second, get_uniform_value_storage().data() + technique.uniform_storage_offset);
+
+				clear_uniform_storage_dirty(technique.uniform_storage_offset, ubo.second);
+
+				_uniform_bytes_uploaded += ubo.second;
+			}
 		}
 
 		for (const auto &pass_object : technique.passes)
@@ -7,6 +7,7 @@
 
 #include "runtime.hpp"
 #include "opengl_stateblock.hpp"
+#include "opengl_framebuffer_state.hpp"
 
 namespace reshade::opengl
 {
@@ -73,6 +74,10 @@ namespace reshade::opengl
 		void on_present();
 		void on_draw_call(unsigned int vertices);
 		void on_fbo_attachment(GLenum target, GLenum attachment, GLenum objecttarget, GLuint object, GLint level);
+		void on_named_fbo_attachment(GLuint fbo, GLenum attachment, GLenum objecttarget, GLuint object, GLint level);
+		void on_bind_framebuffer(GLenum target, GLuint fbo);
+		void on_delete_framebuffers(GLsizei count, const GLuint *fbos);
+		void on_switch_context();
 
 		void capture_frame(uint8_t *buffer) const override;
 		bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) override;
@@ -109,6 +114,7 @@ namespace reshade::opengl
 		void create_depth_texture(GLuint width, GLuint height, GLenum format);
 
 		opengl_stateblock _stateblock;
+		framebuffer_state _framebuffer_state;
 		std::unordered_map<GLuint, depth_source_info> _depth_source_table;
 
 		GLuint _imgui_shader_program = 0, _imgui_VertHandle = 0, _imgui_FragHandle = 0;
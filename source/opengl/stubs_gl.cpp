@@ -54,6 +54,33 @@ HOOK_EXPORT void WINAPI glBegin(GLenum mode)
 	trampoline(mode);
 }
 
+extern "C"  void WINAPI glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	static const auto trampoline = reshade::hooks::call(&glBindFramebuffer);
+
+	trampoline(target, framebuffer);
+
+	const auto it = g_opengl_runtimes.find(wglGetCurrentDC());
+
+	if (it != g_opengl_runtimes.end())
+	{
+		it->second->on_bind_framebuffer(target, framebuffer);
+	}
+}
+extern "C"  void WINAPI glBindFramebufferEXT(GLenum target, GLuint framebuffer)
+{
+	static const auto trampoline = reshade::hooks::call(&glBindFramebufferEXT);
+
+	trampoline(target, framebuffer);
+
+	const auto it = g_opengl_runtimes.find(wglGetCurrentDC());
+
+	if (it != g_opengl_runtimes.end())
+	{
+		it->second->on_bind_framebuffer(target, framebuffer);
+	}
+}
+
 HOOK_EXPORT void WINAPI glBindTexture(GLenum target, GLuint texture)
 {
 	static const auto trampoline = reshade::hooks::call(&glBindTexture);
@@ -385,6 +412,33 @@ HOOK_EXPORT void WINAPI glCullFace(GLenum mode)
 	trampoline(mode);
 }
 
+extern "C"  void WINAPI glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers)
+{
+	static const auto trampoline = reshade::hooks::call(&glDeleteFramebuffers);
+
+	trampoline(n, framebuffers);
+
+	const auto it = g_opengl_runtimes.find(wglGetCurrentDC());
+
+	if (it != g_opengl_runtimes.end())
+	{
+		it->second->on_delete_framebuffers(n, framebuffers);
+	}
+}
+extern "C"  void WINAPI glDeleteFramebuffersEXT(GLsizei n, const GLuint *framebuffers)
+{
+	static const auto trampoline = reshade::hooks::call(&glDeleteFramebuffersEXT);
+
+	trampoline(n, framebuffers);
+
+	const auto it = g_opengl_runtimes.find(wglGetCurrentDC());
+
+	if (it != g_opengl_runtimes.end())
+	{
+		it->second->on_delete_framebuffers(n, framebuffers);
+	}
+}
+
 HOOK_EXPORT void WINAPI glDeleteLists(GLuint list, GLsizei range)
 {
 	static const auto trampoline = reshade::hooks::call(&glDeleteLists);
@@ -1614,6 +1668,46 @@ extern "C"  void WINAPI glMultiDrawElementsIndirect(GLenum mode, GLenum type, co
 	trampoline(mode, type, indirect, drawcount, stride);
 }
 
+extern "C"  void WINAPI glNamedFramebufferRenderbuffer(GLuint framebuffer, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+{
+	static const auto trampoline = reshade::hooks::call(&glNamedFramebufferRenderbuffer);
+
+	trampoline(framebuffer, attachment, renderbuffertarget, renderbuffer);
+
+	const auto it = g_opengl_runtimes.find(wglGetCurrentDC());
+
+	if (it != g_opengl_runtimes.end())
+	{
+		it->second->on_named_fbo_attachment(framebuffer, attachment, renderbuffertarget, renderbuffer, 0);
+	}
+}
+extern "C"  void WINAPI glNamedFramebufferTexture(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level)
+{
+	static const auto trampoline = reshade::hooks::call(&glNamedFramebufferTexture);
+
+	trampoline(framebuffer, attachment, texture, level);
+
+	const auto it = g_opengl_runtimes.find(wglGetCurrentDC());
+
+	if (it != g_opengl_runtimes.end())
+	{
+		it->second->on_named_fbo_attachment(framebuffer, attachment, GL_TEXTURE, texture, level);
+	}
+}
+extern "C"  void WINAPI glNamedFramebufferTextureLayer(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level, GLint layer)
+{
+	static const auto trampoline = reshade::hooks::call(&glNamedFramebufferTextureLayer);
+
+	trampoline(framebuffer, attachment, texture, level, layer);
+
+	const auto it = g_opengl_runtimes.find(wglGetCurrentDC());
+
+	if (it != g_opengl_runtimes.end())
+	{
+		it->second->on_named_fbo_attachment(framebuffer, attachment, GL_TEXTURE, texture, level);
+	}
+}
+
 HOOK_EXPORT void WINAPI glNewList(GLuint list, GLenum mode)
 {
 	static const auto trampoline = reshade::hooks::call(&glNewList);
@@ -607,6 +607,7 @@ HOOK_EXPORT BOOL  WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 	if (it != g_opengl_runtimes.end())
 	{
 		it->second->_reference_count++;
+		it->second->on_switch_context();
 
 		LOG(INFO) << "> Switched to existing runtime " << it->second << ".";
 	}
@@ -635,6 +636,7 @@ HOOK_EXPORT BOOL  WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 		gl3wInit();
 
 		// Fix up gl3w to use the original OpenGL functions and not the hooked ones
+		gl3wProcs.gl.BindFramebuffer = reshade::hooks::call(&glBindFramebuffer);
 		gl3wProcs.gl.BindTexture = reshade::hooks::call(&glBindTexture);
 		gl3wProcs.gl.BlendFunc = reshade::hooks::call(&glBlendFunc);
 		gl3wProcs.gl.Clear = reshade::hooks::call(&glClear);
@@ -647,6 +649,7 @@ HOOK_EXPORT BOOL  WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 		gl3wProcs.gl.CopyTexSubImage1D = reshade::hooks::call(&glCopyTexSubImage1D);
 		gl3wProcs.gl.CopyTexSubImage2D = reshade::hooks::call(&glCopyTexSubImage2D);
 		gl3wProcs.gl.CullFace = reshade::hooks::call(&glCullFace);
+		gl3wProcs.gl.DeleteFramebuffers = reshade::hooks::call(&glDeleteFramebuffers);
 		gl3wProcs.gl.DeleteTextures = reshade::hooks::call(&glDeleteTextures);
 		gl3wProcs.gl.DepthFunc = reshade::hooks::call(&glDepthFunc);
 		gl3wProcs.gl.DepthMask = reshade::hooks::call(&glDepthMask);
@@ -699,6 +702,9 @@ HOOK_EXPORT BOOL  WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 		gl3wProcs.gl.MultiDrawElements = reshade::hooks::call(&glMultiDrawElements);
 		gl3wProcs.gl.MultiDrawElementsBaseVertex = reshade::hooks::call(&glMultiDrawElementsBaseVertex);
 		gl3wProcs.gl.MultiDrawElementsIndirect = reshade::hooks::call(&glMultiDrawElementsIndirect);
+		gl3wProcs.gl.NamedFramebufferRenderbuffer = reshade::hooks::call(&glNamedFramebufferRenderbuffer);
+		gl3wProcs.gl.NamedFramebufferTexture = reshade::hooks::call(&glNamedFramebufferTexture);
+		gl3wProcs.gl.NamedFramebufferTextureLayer = reshade::hooks::call(&glNamedFramebufferTextureLayer);
 		gl3wProcs.gl.PixelStoref = reshade::hooks::call(&glPixelStoref);
 		gl3wProcs.gl.PixelStorei = reshade::hooks::call(&glPixelStorei);
 		gl3wProcs.gl.PointSize = reshade::hooks::call(&glPointSize);
@@ -1100,6 +1106,10 @@ HOOK_EXPORT PROC  WINAPI wglGetProcAddress(LPCSTR lpszProc)
 	else if (static bool s_hooks_not_installed = true; s_hooks_not_installed)
 	{
 		// Install all OpenGL hooks in a single batch job
+		reshade::hooks::install("glBindFramebuffer", reinterpret_cast<reshade::hook::address>(trampoline("glBindFramebuffer")), reinterpret_cast<reshade::hook::address>(&glBindFramebuffer), true);
+		reshade::hooks::install("glBindFramebufferEXT", reinterpret_cast<reshade::hook::address>(trampoline("glBindFramebufferEXT")), reinterpret_cast<reshade::hook::address>(&glBindFramebufferEXT), true);
+		reshade::hooks::install("glDeleteFramebuffers", reinterpret_cast<reshade::hook::address>(trampoline("glDeleteFramebuffers")), reinterpret_cast<reshade::hook::address>(&glDeleteFramebuffers), true);
+		reshade::hooks::install("glDeleteFramebuffersEXT", reinterpret_cast<reshade::hook::address>(trampoline("glDeleteFramebuffersEXT")), reinterpret_cast<reshade::hook::address>(&glDeleteFramebuffersEXT), true);
 		reshade::hooks::install("glDrawArraysIndirect", reinterpret_cast<reshade::hook::address>(trampoline("glDrawArraysIndirect")), reinterpret_cast<reshade::hook::address>(&glDrawArraysIndirect), true);
 		reshade::hooks::install("glDrawArraysInstanced", reinterpret_cast<reshade::hook::address>(trampoline("glDrawArraysInstanced")), reinterpret_cast<reshade::hook::address>(&glDrawArraysInstanced), true);
 		reshade::hooks::install("glDrawArraysInstancedARB", reinterpret_cast<reshade::hook::address>(trampoline("glDrawArraysInstancedARB")), reinterpret_cast<reshade::hook::address>(&glDrawArraysInstancedARB), true);
@@ -1134,6 +1144,9 @@ HOOK_EXPORT PROC  WINAPI wglGetProcAddress(LPCSTR lpszProc)
 		reshade::hooks::install("glMultiDrawElements", reinterpret_cast<reshade::hook::address>(trampoline("glMultiDrawElements")), reinterpret_cast<reshade::hook::address>(&glMultiDrawElements), true);
 		reshade::hooks::install("glMultiDrawElementsBaseVertex", reinterpret_cast<reshade::hook::address>(trampoline("glMultiDrawElementsBaseVertex")), reinterpret_cast<reshade::hook::address>(&glMultiDrawElementsBaseVertex), true);
 		reshade::hooks::install("glMultiDrawElementsIndirect", reinterpret_cast<reshade::hook::address>(trampoline("glMultiDrawElementsIndirect")), reinterpret_cast<reshade::hook::address>(&glMultiDrawElementsIndirect), true);
+		reshade::hooks::install("glNamedFramebufferRenderbuffer", reinterpret_cast<reshade::hook::address>(trampoline("glNamedFramebufferRenderbuffer")), reinterpret_cast<reshade::hook::address>(&glNamedFramebufferRenderbuffer), true);
+		reshade::hooks::install("glNamedFramebufferTexture", reinterpret_cast<reshade::hook::address>(trampoline("glNamedFramebufferTexture")), reinterpret_cast<reshade::hook::address>(&glNamedFramebufferTexture), true);
+		reshade::hooks::install("glNamedFramebufferTextureLayer", reinterpret_cast<reshade::hook::address>(trampoline("glNamedFramebufferTextureLayer")), reinterpret_cast<reshade::hook::address>(&glNamedFramebufferTextureLayer), true);
 		reshade::hooks::install("glTexImage3D", reinterpret_cast<reshade::hook::address>(trampoline("glTexImage3D")), reinterpret_cast<reshade::hook::address>(&glTexImage3D), true);
 
 		reshade::hooks::install("wglChoosePixelFormatARB", reinterpret_cast<reshade::hook::address>(trampoline("wglChoosePixelFormatARB")), reinterpret_cast<reshade::hook::address>(&wglChoosePixelFormatARB), true);
@@ -0,0 +1,533 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "png_encoder.hpp"
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace reshade
+{
+	namespace
+	{
+		const size_t min_rows_per_stripe = 16;
+		const size_t window_size = 32768;
+		const unsigned int hash_bits = 15;
+		const unsigned int max_chain_length = 16;
+		const size_t lazy_match_length = 16; // Only look for a better match at the next position if the current one is shorter than this
+		const size_t nice_match_length = 128; // Stop searching once a match at least this long was found
+
+		struct checksum_tables
+		{
+			checksum_tables()
+			{
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					uint32_t c = i;
+
+					for (int k = 0; k < 8; k++)
+					{
+						c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+					}
+
+					crc[i] = c;
+				}
+			}
+
+			uint32_t crc[256];
+		};
+		struct deflate_tables
+		{
+			deflate_tables()
+			{
+				const unsigned int length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+				const unsigned int distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+
+				for (unsigned int code = 0; code < 29; code++)
+				{
+					const unsigned int last = code == 27 ? 257 : code == 28 ? 258 : length_base[code + 1] - 1;
+
+					for (unsigned int length = length_base[code]; length <= last; length++)
+					{
+						length_code[length] = static_cast<uint8_t>(code);
+					}
+				}
+				for (unsigned int code = 0; code < 30; code++)
+				{
+					const unsigned int last = code == 29 ? 32768 : distance_base[code + 1] - 1;
+
+					for (unsigned int distance = distance_base[code]; distance <= last; distance++)
+					{
+						// Small distances are looked up directly, larger ones in steps of 128 (all codes above 256 cover multiples of that)
+						if (distance <= 256)
+						{
+							distance_code[distance - 1] = static_cast<uint8_t>(code);
+						}
+						else
+						{
+							distance_code[256 + ((distance - 1) >> 7)] = static_cast<uint8_t>(code);
+						}
+					}
+				}
+
+				// Huffman codes are stored most significant bit first, but the bit stream is filled starting with the least significant bit
+				const auto reverse = [](unsigned int code, unsigned int length) {
+					unsigned int result = 0;
+					for (unsigned int i = 0; i < length; i++, code >>= 1)
+						result = (result << 1) | (code & 1);
+					return result;
+				};
+
+				for (unsigned int symbol = 0; symbol < 288; symbol++)
+				{
+					if (symbol < 144)
+						literal_length[symbol] = 8, literal_code[symbol] = reverse(0x30 + symbol, 8);
+					else if (symbol < 256)
+						literal_length[symbol] = 9, literal_code[symbol] = reverse(0x190 + symbol - 144, 9);
+					else if (symbol < 280)
+						literal_length[symbol] = 7, literal_code[symbol] = reverse(symbol - 256, 7);
+					else
+						literal_length[symbol] = 8, literal_code[symbol] = reverse(0xC0 + symbol - 280, 8);
+				}
+				for (unsigned int code = 0; code < 30; code++)
+				{
+					distance_huffman_code[code] = reverse(code, 5);
+					distance_extra_bits[code] = code < 4 ? 0 : (code - 2) / 2;
+					distance_base_value[code] = distance_base[code];
+				}
+				for (unsigned int code = 0; code < 29; code++)
+				{
+					length_extra_bits[code] = code < 8 || code == 28 ? 0 : (code - 4) / 4;
+					length_base_value[code] = length_base[code];
+				}
+			}
+
+			uint8_t length_code[259];
+			uint8_t distance_code[512];
+			uint16_t literal_code[288];
+			uint8_t literal_length[288];
+			uint16_t distance_huffman_code[30];
+			uint8_t distance_extra_bits[30], length_extra_bits[29];
+			uint16_t distance_base_value[30], length_base_value[29];
+		};
+
+		const checksum_tables s_checksum_tables;
+		const deflate_tables s_deflate_tables;
+
+		uint32_t crc32(uint32_t crc, const uint8_t *data, size_t size)
+		{
+			crc = ~crc;
+
+			for (size_t i = 0; i < size; i++)
+			{
+				crc = s_checksum_tables.crc[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+			}
+
+			return ~crc;
+		}
+		uint32_t adler32(const uint8_t *data, size_t size)
+		{
+			uint32_t a = 1, b = 0;
+
+			while (size != 0)
+			{
+				// 5552 is the largest number of bytes that can be summed up before "b" could overflow
+				const size_t block_size = std::min<size_t>(size, 5552);
+
+				for (size_t i = 0; i < block_size; i++)
+				{
+					a += data[i];
+					b += a;
+				}
+
+				a %= 65521;
+				b %= 65521;
+				data += block_size;
+				size -= block_size;
+			}
+
+			return (b << 16) | a;
+		}
+		uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t size2)
+		{
+			// Same as "adler32" over both inputs in sequence, derived from how each byte of the second input contributes to the sums
+			const uint32_t base = 65521;
+			const uint32_t remainder = static_cast<uint32_t>(size2 % base);
+
+			uint32_t a = (adler1 & 0xFFFF) + (adler2 & 0xFFFF) + base - 1;
+			uint32_t b = static_cast<uint32_t>((static_cast<uint64_t>(remainder) * (adler1 & 0xFFFF)) % base) + (adler1 >> 16) + (adler2 >> 16) + base - remainder;
+
+			return ((b % base) << 16) | (a % base);
+		}
+
+		class bit_writer
+		{
+		public:
+			explicit bit_writer(std::vector<uint8_t> &output) : _output(output) { }
+
+			void put(uint32_t value, unsigned int count)
+			{
+				_bits |= static_cast<uint64_t>(value) << _count;
+				_count += count;
+
+				while (_count >= 8)
+				{
+					_output.push_back(static_cast<uint8_t>(_bits));
+					_bits >>= 8;
+					_count -= 8;
+				}
+			}
+			void align()
+			{
+				if (_count != 0)
+				{
+					put(0, 8 - _count);
+				}
+			}
+
+		private:
+			std::vector<uint8_t> &_output;
+			uint64_t _bits = 0;
+			unsigned int _count = 0;
+		};
+
+		void put_literal(bit_writer &writer, unsigned int symbol)
+		{
+			writer.put(s_deflate_tables.literal_code[symbol], s_deflate_tables.literal_length[symbol]);
+		}
+		void put_match(bit_writer &writer, size_t length, size_t distance)
+		{
+			const unsigned int length_code = s_deflate_tables.length_code[length];
+			put_literal(writer, 257 + length_code);
+			writer.put(static_cast<uint32_t>(length - s_deflate_tables.length_base_value[length_code]), s_deflate_tables.length_extra_bits[length_code]);
+
+			const unsigned int distance_code = s_deflate_tables.distance_code[distance <= 256 ? distance - 1 : 256 + ((distance - 1) >> 7)];
+			writer.put(s_deflate_tables.distance_huffman_code[distance_code], 5);
+			writer.put(static_cast<uint32_t>(distance - s_deflate_tables.distance_base_value[distance_code]), s_deflate_tables.distance_extra_bits[distance_code]);
+		}
+
+		inline unsigned int count_trailing_zeros(uint64_t value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+#ifdef _WIN64
+			_BitScanForward64(&index, value);
+#else
+			// There is no 64-bit bit scan in 32-bit builds, so scan the low half first and fall back to the high half
+			if (!_BitScanForward(&index, static_cast<uint32_t>(value)))
+			{
+				_BitScanForward(&index, static_cast<uint32_t>(value >> 32));
+				index += 32;
+			}
+#endif
+			return index;
+#else
+			return __builtin_ctzll(value);
+#endif
+		}
+
+		/// <summary>
+		/// Compress a range of data into a single deflate block with fixed Huffman codes. Matches may reach back into the bytes in front of the range, which the decoder already knows from previous blocks.
+		/// </summary>
+		void deflate(std::vector<uint8_t> &output, const uint8_t *data, size_t dictionary_size, size_t size, bool is_final_block)
+		{
+			const size_t end = dictionary_size + size;
+			std::vector<int32_t> head(size_t(1) << hash_bits, -1), prev(window_size, -1);
+
+			const auto hash = [data](size_t i) {
+				return ((data[i] << 16 | data[i + 1] << 8 | data[i + 2]) * 2654435761u) >> (32 - hash_bits);
+			};
+			const auto insert = [&](size_t i) {
+				if (i + 3 <= end)
+				{
+					const uint32_t h = hash(i);
+					prev[i & (window_size - 1)] = head[h];
+					head[h] = static_cast<int32_t>(i);
+				}
+			};
+			const auto find_match = [&](size_t i, size_t &distance) -> size_t {
+				if (i + 3 > end)
+				{
+					return 0;
+				}
+
+				const size_t max_length = std::min<size_t>(258, end - i);
+				size_t best_length = 0;
+
+				int32_t candidate = head[hash(i)];
+
+				for (unsigned int chain = max_chain_length; candidate >= 0 && chain != 0 && i - static_cast<size_t>(candidate) <= window_size; chain--)
+				{
+					if (data[candidate + best_length] == data[i + best_length])
+					{
+						size_t length = 0;
+
+						// Compare eight bytes at a time, the first differing bit then tells how many of them still matched
+						for (uint64_t a, b; length + 8 <= max_length; length += 8)
+						{
+							memcpy(&a, data + candidate + length, 8);
+							memcpy(&b, data + i + length, 8);
+
+							if (a != b)
+							{
+								length += count_trailing_zeros(a ^ b) / 8;
+								break;
+							}
+						}
+
+						if (length + 8 > max_length)
+						{
+							while (length < max_length && data[candidate + length] == data[i + length])
+								length++;
+						}
+
+						if (length > best_length)
+						{
+							best_length = length;
+							distance = i - candidate;
+
+							if (length >= nice_match_length || length == max_length)
+							{
+								break;
+							}
+						}
+					}
+
+					// Slots of the previous position table are reused every window, so stop as soon as the chain stops going backwards
+					const int32_t next = prev[candidate & (window_size - 1)];
+
+					if (next >= candidate)
+					{
+						break;
+					}
+
+					candidate = next;
+				}
+
+				return best_length >= 3 ? best_length : 0;
+			};
+
+			for (size_t i = dictionary_size > window_size ? dictionary_size - window_size : 0; i < dictionary_size; i++)
+			{
+				insert(i);
+			}
+
+			bit_writer writer(output);
+			writer.put(is_final_block ? 1 : 0, 1);
+			writer.put(1, 2); // Fixed Huffman codes
+
+			size_t length = 0, distance = 0;
+			bool has_match = false;
+
+			for (size_t i = dictionary_size; i < end;)
+			{
+				if (!has_match)
+				{
+					length = find_match(i, distance);
+				}
+
+				has_match = false;
+				insert(i);
+
+				// Emit a literal instead if the match starting at the next byte is longer
+				if (length != 0 && length < lazy_match_length)
+				{
+					size_t next_distance = 0;
+					const size_t next_length = find_match(i + 1, next_distance);
+
+					if (next_length > length)
+					{
+						put_literal(writer, data[i++]);
+						length = next_length;
+						distance = next_distance;
+						has_match = true;
+						continue;
+					}
+				}
+
+				if (length == 0)
+				{
+					put_literal(writer, data[i++]);
+				}
+				else
+				{
+					put_match(writer, length, distance);
+
+					for (size_t k = 1; k < length; k++)
+					{
+						insert(i + k);
+					}
+
+					i += length;
+				}
+			}
+
+			put_literal(writer, 256); // End of block
+
+			if (is_final_block)
+			{
+				writer.align();
+			}
+			else
+			{
+				// Follow with an empty stored block, which aligns the stream to a byte boundary so that the next block can simply be appended
+				writer.put(0, 3);
+				writer.align();
+				writer.put(0x0000, 16);
+				writer.put(0xFFFF, 16);
+			}
+		}
+
+		inline uint8_t paeth(int a, int b, int c)
+		{
+			const int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+			return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+		}
+
+		void write_u32(uint8_t *data, uint32_t value)
+		{
+			data[0] = static_cast<uint8_t>(value >> 24);
+			data[1] = static_cast<uint8_t>(value >> 16);
+			data[2] = static_cast<uint8_t>(value >> 8);
+			data[3] = static_cast<uint8_t>(value);
+		}
+		bool write_chunk(FILE *file, const char type[4], const uint8_t *data, size_t size, uint32_t crc)
+		{
+			uint8_t header[8], footer[4];
+			write_u32(header, static_cast<uint32_t>(size));
+			memcpy(header + 4, type, 4);
+			write_u32(footer, crc);
+
+			return fwrite(header, 1, 8, file) == 8 && fwrite(data, 1, size, file) == size && fwrite(footer, 1, 4, file) == 4;
+		}
+		bool write_chunk(FILE *file, const char type[4], const uint8_t *data, size_t size)
+		{
+			return write_chunk(file, type, data, size, crc32(crc32(0, reinterpret_cast<const uint8_t *>(type), 4), data, size));
+		}
+	}
+
+	png_encoder::png_encoder(const uint8_t *pixels, unsigned int width, unsigned int height, size_t max_stripes) : _pixels(pixels), _width(width), _height(height)
+	{
+		const size_t stripe_count = std::max<size_t>(1, std::min<size_t>(max_stripes, height / min_rows_per_stripe));
+		const size_t rows_per_stripe = (height + stripe_count - 1) / stripe_count;
+
+		for (size_t first_row = 0; first_row < height; first_row += rows_per_stripe)
+		{
+			stripe stripe;
+			stripe.first_row = first_row;
+			stripe.row_count = std::min<size_t>(rows_per_stripe, height - first_row);
+			stripe.dictionary_size = std::min(first_row * (1 + width * 4), window_size);
+			_stripes.push_back(std::move(stripe));
+		}
+	}
+
+	void png_encoder::filter_stripe(size_t index)
+	{
+		auto &stripe = _stripes[index];
+		const size_t pitch = _width * 4;
+		std::vector<uint8_t> candidates[5];
+
+		stripe.filtered.resize(stripe.dictionary_size + stripe.row_count * (1 + pitch));
+
+		for (auto &candidate : candidates)
+		{
+			candidate.resize(pitch);
+		}
+
+		for (size_t y = stripe.first_row; y < stripe.first_row + stripe.row_count; y++)
+		{
+			const uint8_t *const row = _pixels + y * pitch;
+			// The row above the image is treated as all zero, which is what decoders assume too
+			const uint8_t *const prev_row = y != 0 ? row - pitch : nullptr;
+
+			// Try every filter type and keep the one whose output has the smallest sum of absolute values, which tends to compress best
+			size_t sums[5] = { };
+
+			for (size_t x = 0; x < pitch; x++)
+			{
+				const int a = x >= 4 ? row[x - 4] : 0;
+				const int b = prev_row != nullptr ? prev_row[x] : 0;
+				const int c = x >= 4 && prev_row != nullptr ? prev_row[x - 4] : 0;
+
+				candidates[0][x] = row[x];
+				candidates[1][x] = static_cast<uint8_t>(row[x] - a);
+				candidates[2][x] = static_cast<uint8_t>(row[x] - b);
+				candidates[3][x] = static_cast<uint8_t>(row[x] - ((a + b) >> 1));
+				candidates[4][x] = static_cast<uint8_t>(row[x] - paeth(a, b, c));
+
+				for (size_t filter = 0; filter < 5; filter++)
+				{
+					sums[filter] += std::abs(static_cast<int8_t>(candidates[filter][x]));
+				}
+			}
+
+			const size_t best_filter = std::min_element(sums, sums + 5) - sums;
+
+			uint8_t *const filtered_row = stripe.filtered.data() + stripe.dictionary_size + (y - stripe.first_row) * (1 + pitch);
+			filtered_row[0] = static_cast<uint8_t>(best_filter);
+			memcpy(filtered_row + 1, candidates[best_filter].data(), pitch);
+		}
+	}
+	void png_encoder::compress_stripe(size_t index)
+	{
+		auto &stripe = _stripes[index];
+		const size_t size = stripe.row_count * (1 + _width * 4);
+
+		// Fill the dictionary with the end of the previous stripes (the rows of short stripes may not be enough on their own)
+		for (size_t remaining = stripe.dictionary_size, k = index; remaining != 0;)
+		{
+			const auto &source = _stripes[--k];
+			const size_t source_size = source.filtered.size() - source.dictionary_size;
+			const size_t copy_size = std::min(remaining, source_size);
+
+			remaining -= copy_size;
+			memcpy(stripe.filtered.data() + remaining, source.filtered.data() + source.filtered.size() - copy_size, copy_size);
+		}
+
+		if (index == 0)
+		{
+			// Zlib stream header (deflate with a 32 KB window and no preset dictionary)
+			stripe.compressed.push_back(0x78);
+			stripe.compressed.push_back(0x01);
+		}
+
+		deflate(stripe.compressed, stripe.filtered.data(), stripe.dictionary_size, size, index == _stripes.size() - 1);
+
+		stripe.crc = crc32(crc32(0, reinterpret_cast<const uint8_t *>("IDAT"), 4), stripe.compressed.data(), stripe.compressed.size());
+		stripe.adler = adler32(stripe.filtered.data() + stripe.dictionary_size, size);
+	}
+	bool png_encoder::write(FILE *file) const
+	{
+		const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+		uint8_t header[13];
+		write_u32(header + 0, _width);
+		write_u32(header + 4, _height);
+		header[8] = 8; // Bit depth
+		header[9] = 6; // Color type (RGBA)
+		header[10] = 0; // Compression method
+		header[11] = 0; // Filter method
+		header[12] = 0; // Interlace method
+
+		bool success = fwrite(signature, 1, sizeof(signature), file) == sizeof(signature) && write_chunk(file, "IHDR", header, sizeof(header));
+
+		// Every stripe goes into its own chunk, decoders join the contents of all of them into a single zlib stream
+		uint32_t adler = 1;
+
+		for (const auto &stripe : _stripes)
+		{
+			success = success && write_chunk(file, "IDAT", stripe.compressed.data(), stripe.compressed.size(), stripe.crc);
+			adler = adler32_combine(adler, stripe.adler, stripe.row_count * (1 + _width * 4));
+		}
+
+		uint8_t trailer[4];
+		write_u32(trailer, adler);
+
+		return success && write_chunk(file, "IDAT", trailer, sizeof(trailer)) && write_chunk(file, "IEND", nullptr, 0);
+	}
+}
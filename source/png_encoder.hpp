@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+namespace reshade
+{
+	/// <summary>
+	/// Encodes an image as PNG file, split into horizontal stripes that can be filtered and compressed on different threads.
+	/// All stripes have to be filtered before any of them is compressed, since the compressor looks for matches in the end of the stripes in front of it.
+	/// </summary>
+	class png_encoder
+	{
+	public:
+		/// <summary>
+		/// Split an image into stripes.
+		/// </summary>
+		/// <param name="pixels">The tightly packed RGBA pixels of the image. These have to stay alive until all stripes are filtered.</param>
+		/// <param name="width">The width of the image.</param>
+		/// <param name="height">The height of the image.</param>
+		/// <param name="max_stripes">The number of stripes to split the image into. Images that are too short for each of them to get a few rows get fewer.</param>
+		png_encoder(const uint8_t *pixels, unsigned int width, unsigned int height, size_t max_stripes);
+
+		/// <summary>
+		/// Returns the number of stripes the image was split into.
+		/// </summary>
+		size_t stripe_count() const { return _stripes.size(); }
+
+		/// <summary>
+		/// Apply the PNG row filters to the rows of a stripe.
+		/// </summary>
+		/// <param name="index">The index of the stripe.</param>
+		void filter_stripe(size_t index);
+		/// <summary>
+		/// Compress the filtered rows of a stripe into a part of the zlib stream.
+		/// </summary>
+		/// <param name="index">The index of the stripe.</param>
+		void compress_stripe(size_t index);
+		/// <summary>
+		/// Write the PNG file once all stripes are compressed.
+		/// </summary>
+		/// <param name="file">The file to write to.</param>
+		/// <returns>A boolean value indicating whether everything was written.</returns>
+		bool write(FILE *file) const;
+
+	private:
+		struct stripe
+		{
+			size_t first_row, row_count;
+			size_t dictionary_size; // Number of bytes in front of the filtered rows that hold the end of the previous stripes
+			std::vector<uint8_t> filtered; // Every row is prefixed with its filter type
+			std::vector<uint8_t> compressed;
+			uint32_t crc = 0, adler = 0;
+		};
+
+		const uint8_t *_pixels;
+		unsigned int _width, _height;
+		std::vector<stripe> _stripes;
+	};
+}
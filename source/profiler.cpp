@@ -0,0 +1,215 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "profiler.hpp"
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <Windows.h>
+
+namespace reshade::profiler
+{
+	namespace
+	{
+		const size_t buffer_capacity = 16384; // Zones kept per thread, which is a couple of seconds worth of frames
+
+		struct event
+		{
+			const char *name;
+			char detail[32];
+			unsigned long thread_id;
+			std::chrono::high_resolution_clock::time_point begin, end;
+		};
+		struct thread_buffer
+		{
+			// Only ever contended while exporting, so locking this costs next to nothing the rest of the time
+			std::mutex mutex;
+			std::vector<event> events;
+			size_t next_index = 0;
+		};
+
+		std::atomic<bool> s_is_enabled = false;
+		std::mutex s_buffers_mutex;
+		std::vector<std::unique_ptr<thread_buffer>> s_buffers;
+		std::vector<thread_buffer *> s_free_buffers;
+
+		// Threads hand their buffer back when they exit, so that short-lived worker threads (like the ones loading effects) do not add a new one every time
+		// The recorded zones stay in it, which is why every zone carries its own thread identifier
+		struct thread_buffer_owner
+		{
+			~thread_buffer_owner()
+			{
+				if (buffer != nullptr)
+				{
+					const std::lock_guard<std::mutex> lock(s_buffers_mutex);
+					s_free_buffers.push_back(buffer);
+				}
+			}
+
+			thread_buffer *buffer = nullptr;
+		};
+
+		thread_local thread_buffer_owner t_owner;
+
+		thread_buffer *current_thread_buffer()
+		{
+			if (t_owner.buffer == nullptr)
+			{
+				const std::lock_guard<std::mutex> lock(s_buffers_mutex);
+
+				if (!s_free_buffers.empty())
+				{
+					t_owner.buffer = s_free_buffers.back();
+					s_free_buffers.pop_back();
+				}
+				else
+				{
+					s_buffers.push_back(std::make_unique<thread_buffer>());
+					t_owner.buffer = s_buffers.back().get();
+					t_owner.buffer->events.reserve(buffer_capacity);
+				}
+			}
+
+			return t_owner.buffer;
+		}
+
+		void write_escaped(std::ofstream &file, const char *string)
+		{
+			for (; *string != '\0'; ++string)
+			{
+				const char c = *string;
+
+				if (c == '\"' || c == '\\')
+				{
+					file << '\\' << c;
+				}
+				else if (static_cast<unsigned char>(c) < 0x20)
+				{
+					file << ' ';
+				}
+				else
+				{
+					file << c;
+				}
+			}
+		}
+	}
+
+	zone::zone(const char *name, const std::string *detail) :
+		_name(s_is_enabled.load(std::memory_order_relaxed) ? name : nullptr),
+		_detail(detail)
+	{
+		if (_name != nullptr)
+		{
+			_begin = std::chrono::high_resolution_clock::now();
+		}
+	}
+	zone::~zone()
+	{
+		if (_name == nullptr)
+		{
+			return;
+		}
+
+		event e;
+		e.name = _name;
+		e.detail[0] = '\0';
+		e.thread_id = GetCurrentThreadId();
+		e.begin = _begin;
+		e.end = std::chrono::high_resolution_clock::now();
+
+		if (_detail != nullptr)
+		{
+			const size_t length = _detail->copy(e.detail, sizeof(e.detail) - 1);
+			e.detail[length] = '\0';
+		}
+
+		const auto buffer = current_thread_buffer();
+
+		const std::lock_guard<std::mutex> lock(buffer->mutex);
+
+		// Overwrite the oldest zone once the buffer is full
+		if (buffer->events.size() < buffer_capacity)
+		{
+			buffer->events.push_back(e);
+		}
+		else
+		{
+			buffer->events[buffer->next_index] = e;
+		}
+
+		buffer->next_index = (buffer->next_index + 1) % buffer_capacity;
+	}
+
+	void set_enabled(bool enabled)
+	{
+		s_is_enabled = enabled;
+	}
+	bool is_enabled()
+	{
+		return s_is_enabled.load(std::memory_order_relaxed);
+	}
+
+	void clear()
+	{
+		const std::lock_guard<std::mutex> lock(s_buffers_mutex);
+
+		for (const auto &buffer : s_buffers)
+		{
+			const std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+			buffer->events.clear();
+			buffer->next_index = 0;
+		}
+	}
+	bool export_chrome_trace(const filesystem::path &path)
+	{
+		std::vector<event> events;
+
+		// Copy everything out first, so that threads recording zones are not held up by writing the file
+		{ const std::lock_guard<std::mutex> lock(s_buffers_mutex);
+			for (const auto &buffer : s_buffers)
+			{
+				const std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+				events.insert(events.end(), buffer->events.begin(), buffer->events.end());
+			}
+		}
+
+		std::sort(events.begin(), events.end(), [](const event &lhs, const event &rhs) { return lhs.begin < rhs.begin; });
+
+		std::ofstream file(path.wstring(), std::ios::out | std::ios::trunc);
+
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		const unsigned long process_id = GetCurrentProcessId();
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		file << std::fixed;
+		file.precision(3);
+
+		for (size_t i = 0; i < events.size(); i++)
+		{
+			const auto &e = events[i];
+
+			// Zones about a specific object are named after it and grouped by the zone name instead
+			file << (i != 0 ? ",\n" : "\n") << "{\"name\":\"";
+			write_escaped(file, e.detail[0] != '\0' ? e.detail : e.name);
+			file << "\",\"cat\":\"";
+			write_escaped(file, e.name);
+			file << "\",\"ph\":\"X\",\"pid\":" << process_id << ",\"tid\":" << e.thread_id
+				<< ",\"ts\":" << std::chrono::duration<double, std::micro>(e.begin - events.front().begin).count()
+				<< ",\"dur\":" << std::chrono::duration<double, std::micro>(e.end - e.begin).count() << '}';
+		}
+
+		file << "\n]}\n";
+
+		return !file.fail();
+	}
+}
@@ -0,0 +1,63 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "filesystem.hpp"
+#include <chrono>
+#include <string>
+
+namespace reshade::profiler
+{
+	/// <summary>
+	/// Measures the CPU time spent in a scope and records it for the current thread while profiling is enabled. Zones nest, so a zone opened while another one is still open shows up as its child.
+	/// </summary>
+	class zone
+	{
+	public:
+		/// <summary>
+		/// Open a zone.
+		/// </summary>
+		/// <param name="name">The name of the zone. This has to be a string literal, since only the pointer is stored.</param>
+		explicit zone(const char *name) : zone(name, nullptr) { }
+		/// <summary>
+		/// Open a zone for a specific object.
+		/// </summary>
+		/// <param name="name">The name of the zone. This has to be a string literal, since only the pointer is stored.</param>
+		/// <param name="detail">The name of the object the zone is about (like a technique name). It is copied when the zone is closed, so only has to outlive the zone.</param>
+		zone(const char *name, const std::string &detail) : zone(name, &detail) { }
+		~zone();
+
+		zone(const zone &) = delete;
+		zone &operator=(const zone &) = delete;
+
+	private:
+		zone(const char *name, const std::string *detail);
+
+		const char *_name;
+		const std::string *_detail;
+		std::chrono::high_resolution_clock::time_point _begin;
+	};
+
+	/// <summary>
+	/// Start or stop recording zones. Each thread keeps the most recent zones it closed, older ones are overwritten.
+	/// </summary>
+	void set_enabled(bool enabled);
+	/// <summary>
+	/// Returns whether zones are currently recorded.
+	/// </summary>
+	bool is_enabled();
+
+	/// <summary>
+	/// Discard all recorded zones.
+	/// </summary>
+	void clear();
+	/// <summary>
+	/// Write all recorded zones to a JSON file in the Chrome trace event format, which can be opened in "chrome://tracing" or similar viewers.
+	/// </summary>
+	/// <param name="path">The path to the file to write.</param>
+	/// <returns><c>true</c> if the file was written, <c>false</c> otherwise.</returns>
+	bool export_chrome_trace(const filesystem::path &path);
+}
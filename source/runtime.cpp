@@ -10,11 +10,14 @@
 #include "effect_preprocessor.hpp"
 #include "input.hpp"
 #include "ini_file.hpp"
+#include "profiler.hpp"
+#include "shader_cache_directory.hpp"
+#include "texture_cache_directory.hpp"
+#include <fstream>
 #include <algorithm>
 #include <unordered_set>
 #include <stb_image.h>
 #include <stb_image_dds.h>
-#include <stb_image_write.h>
 #include <stb_image_resize.h>
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include <imgui.h>
@@ -22,7 +25,7 @@
 
 namespace reshade
 {
-	filesystem::path runtime::s_reshade_dll_path, runtime::s_target_executable_path;
+	filesystem::path runtime::s_reshade_dll_path, runtime::s_target_executable_path, runtime::s_configuration_path;
 
 	runtime::runtime(uint32_t renderer) :
 		_renderer_id(renderer),
@@ -39,18 +42,18 @@ namespace reshade
 			"RESHADE_DEPTH_INPUT_IS_LOGARITHMIC=0" }),
 		_menu_key_data(),
 		_screenshot_key_data(),
+		_burst_key_data(),
 		_effects_key_data(),
 		_screenshot_path(s_target_executable_path.parent_path()),
+		_effect_cache_path(s_reshade_dll_path.parent_path() / "ReShade-Cache"),
+		_include_cache(std::make_unique<reshadefx::include_cache>()),
 		_variable_editor_height(300)
 	{
 		_menu_key_data[0] = 0x71; // VK_F2
 		_menu_key_data[2] = true; // VK_SHIFT
 		_screenshot_key_data[0] = 0x2C; // VK_SNAPSHOT
 
-		_configuration_path = s_reshade_dll_path;
-		_configuration_path.replace_extension(".ini");
-		if (!filesystem::exists(_configuration_path))
-			_configuration_path = s_reshade_dll_path.parent_path() / "ReShade.ini";
+		_configuration_path = s_configuration_path;
 
 		ImGui::SetCurrentContext(_imgui_context);
 
@@ -96,6 +99,9 @@ namespace reshade
 	}
 	runtime::~runtime()
 	{
+		stop_effect_workers();
+		stop_texture_workers();
+
 		ImGui::SetCurrentContext(_imgui_context);
 
 		ImGui::Shutdown();
@@ -129,6 +135,10 @@ namespace reshade
 
 		_imgui_font_atlas_texture.reset();
 
+		// Frames of a different size cannot go into the same sequence, so the rest of a running burst capture is lost
+		_burst_frames_dropped += _burst_frames_remaining;
+		_burst_frames_remaining = 0;
+
 		LOG(INFO) << "Destroyed runtime environment on runtime " << this << ".";
 
 		_width = _height = 0;
@@ -136,10 +146,17 @@ namespace reshade
 	}
 	void runtime::on_reset_effect()
 	{
+		stop_effect_workers();
+		stop_texture_workers();
+
+		_reload_remaining_effects = 0;
+
 		_textures.clear();
 		_uniforms.clear();
 		_techniques.clear();
 		_uniform_data_storage.clear();
+		_uniform_updates.clear();
+		_uniform_storage_dirty.clear();
 		_errors.clear();
 
 		_texture_count = 0;
@@ -148,6 +165,8 @@ namespace reshade
 	}
 	void runtime::on_present()
 	{
+		const profiler::zone profile_zone("on_present");
+
 		// Get current time and date
 		time_t t = std::time(nullptr); tm tm;
 		localtime_s(&tm, &t);
@@ -170,228 +189,115 @@ namespace reshade
 			save_screenshot();
 		}
 
-		// Draw overlay
-		draw_overlay();
-
-		// Reset input status
-		_input->next_frame();
-
-		// Update and compile next effect queued for reloading
-		if (_reload_remaining_effects != 0 && _framecount > 1)
-		{
-			load_effect(_effect_files[_effect_files.size() - _reload_remaining_effects]);
-
-			_last_reload_time = std::chrono::high_resolution_clock::now();
-			_reload_remaining_effects--;
-
-			if (_reload_remaining_effects == 0)
-			{
-				load_textures();
-
-				load_current_preset();
-
-				if (_effect_filter_buffer[0] != '\0' && strcmp(_effect_filter_buffer, "Search") != 0)
-				{
-					filter_techniques(_effect_filter_buffer);
-				}
-			}
-		}
-	}
-	void runtime::on_present_effect()
-	{
-		if (_input->is_key_pressed(_effects_key_data[0], _effects_key_data[1] != 0, _effects_key_data[2] != 0, false))
+		// Start recording a sequence of frames if associated shortcut is down (the first one is captured right away)
+		if (!_burst_key_setting_active && !_is_burst_capturing && _burst_key_data[0] != 0 &&
+			_input->is_key_pressed(_burst_key_data[0], _burst_key_data[1] != 0, _burst_key_data[2] != 0, false))
 		{
-			_effects_enabled = !_effects_enabled;
+			start_burst_capture();
 		}
 
-		if (!_effects_enabled)
+		if (_burst_frames_remaining != 0)
 		{
-			return;
+			capture_burst_frame();
 		}
 
-		// Update all uniform variables
-		for (auto &variable : _uniforms)
-		{
-			const auto it = variable.annotations.find("source");
-
-			if (it == variable.annotations.end())
-			{
-				continue;
-			}
+		collect_burst_frames();
 
-			const auto source = it->second.as<std::string>();
+		// Report screenshots the background threads finished writing
+		_image_encoder.take_finished(_finished_images);
 
-			if (source == "frametime")
+		for (auto &result : _finished_images)
+		{
+			if (result.success)
 			{
-				const float value = _last_frame_duration.count() * 1e-6f;
-				set_uniform_value(variable, &value, 1);
+				LOG(INFO) << "Saved screenshot to " << result.path << ".";
 			}
-			else if (source == "framecount")
+			else
 			{
-				switch (variable.basetype)
-				{
-					case uniform_datatype::boolean:
-					{
-						const bool even = (_framecount % 2) == 0;
-						set_uniform_value(variable, &even, 1);
-						break;
-					}
-					case uniform_datatype::signed_integer:
-					case uniform_datatype::unsigned_integer:
-					{
-						const unsigned int framecount = static_cast<unsigned int>(_framecount % UINT_MAX);
-						set_uniform_value(variable, &framecount, 1);
-						break;
-					}
-					case uniform_datatype::floating_point:
-					{
-						const float framecount = static_cast<float>(_framecount % 16777216);
-						set_uniform_value(variable, &framecount, 1);
-						break;
-					}
-				}
+				LOG(ERROR) << "Failed to write screenshot to " << result.path << "!";
 			}
-			else if (source == "pingpong")
-			{
-				float value[2] = { 0, 0 };
-				get_uniform_value(variable, value, 2);
 
-				const float min = variable.annotations["min"].as<float>(), max = variable.annotations["max"].as<float>();
-				const float step_min = variable.annotations["step"].as<float>(0), step_max = variable.annotations["step"].as<float>(1);
-				float increment = step_max == 0 ? step_min : (step_min + std::fmodf(static_cast<float>(std::rand()), step_max - step_min + 1));
-				const float smoothing = variable.annotations["smoothing"].as<float>();
+			_screenshot_buffer = std::move(result.pixels);
+		}
 
-				if (value[1] >= 0)
-				{
-					increment = std::max(increment - std::max(0.0f, smoothing - (max - value[0])), 0.05f);
-					increment *= _last_frame_duration.count() * 1e-9f;
+		_finished_images.clear();
 
-					if ((value[0] += increment) >= max)
-					{
-						value[0] = max;
-						value[1] = -1;
-					}
-				}
-				else
-				{
-					increment = std::max(increment - std::max(0.0f, smoothing - (value[0] - min)), 0.05f);
-					increment *= _last_frame_duration.count() * 1e-9f;
+		// Draw overlay
+		draw_overlay();
 
-					if ((value[0] -= increment) <= min)
-					{
-						value[0] = min;
-						value[1] = +1;
-					}
-				}
+		// Reset input status
+		_input->next_frame();
 
-				set_uniform_value(variable, value, 2);
-			}
-			else if (source == "date")
-			{
-				set_uniform_value(variable, _date, 4);
-			}
-			else if (source == "timer")
-			{
-				const unsigned long long timer = std::chrono::duration_cast<std::chrono::nanoseconds>(_last_present_time - _start_time).count();
+		// Create effects whose source code was already parsed by the worker threads, in the order they were queued
+		if (_reload_remaining_effects != 0 && _framecount > 1)
+		{
+			const auto time_started = std::chrono::high_resolution_clock::now();
 
-				switch (variable.basetype)
-				{
-					case uniform_datatype::boolean:
-					{
-						const bool even = (timer % 2) == 0;
-						set_uniform_value(variable, &even, 1);
-						break;
-					}
-					case uniform_datatype::signed_integer:
-					case uniform_datatype::unsigned_integer:
-					{
-						const unsigned int timer_int = static_cast<unsigned int>(timer % UINT_MAX);
-						set_uniform_value(variable, &timer_int, 1);
-						break;
-					}
-					case uniform_datatype::floating_point:
-					{
-						const float timer_float = std::fmod(static_cast<float>(timer * 1e-6f), 16777216.0f);
-						set_uniform_value(variable, &timer_float, 1);
-						break;
-					}
-				}
-			}
-			else if (source == "key")
+			while (_reload_remaining_effects != 0)
 			{
-				const int key = variable.annotations["keycode"].as<int>();
+				const size_t index = _effect_files.size() - _reload_remaining_effects;
+				auto &task = _effect_load_tasks[index];
 
-				if (key > 7 && key < 256)
+				if (!task.ready.load(std::memory_order_acquire))
 				{
-					const std::string mode = variable.annotations["mode"].as<std::string>();
+					break;
+				}
 
-					if (mode == "toggle" || variable.annotations["toggle"].as<bool>())
-					{
-						bool current = false;
-						get_uniform_value(variable, &current, 1);
+				load_effect(_effect_files[index], task);
 
-						if (_input->is_key_pressed(key))
-						{
-							current = !current;
+				task.ast.reset();
 
-							set_uniform_value(variable, &current, 1);
-						}
-					}
-					else if (mode == "press")
-					{
-						const bool state = _input->is_key_pressed(key);
-
-						set_uniform_value(variable, &state, 1);
-					}
-					else
-					{
-						const bool state = _input->is_key_down(key);
+				_last_reload_time = std::chrono::high_resolution_clock::now();
+				_reload_remaining_effects--;
 
-						set_uniform_value(variable, &state, 1);
-					}
+				// Spread the remaining work over multiple frames to keep the application responsive
+				if (_last_reload_time - time_started > std::chrono::milliseconds(50))
+				{
+					break;
 				}
 			}
-			else if (source == "mousepoint")
-			{
-				const float values[2] = { static_cast<float>(_input->mouse_position_x()), static_cast<float>(_input->mouse_position_y()) };
 
-				set_uniform_value(variable, values, 2);
-			}
-			else if (source == "mousebutton")
+			if (_reload_remaining_effects == 0)
 			{
-				const int index = variable.annotations["keycode"].as<int>();
+				stop_effect_workers();
 
-				if (index >= 0 && index < 5)
-				{
-					if (variable.annotations["toggle"].as<bool>())
-					{
-						bool current = false;
-						get_uniform_value(variable, &current, 1);
+				_shader_cache.flush();
 
-						if (_input->is_mouse_button_pressed(index))
-						{
-							current = !current;
+				load_textures();
 
-							set_uniform_value(variable, &current, 1);
-						}
-					}
-					else
-					{
-						const bool state = _input->is_mouse_button_down(index);
+				load_current_preset();
 
-						set_uniform_value(variable, &state, 1);
-					}
+				if (_effect_filter_buffer[0] != '\0' && strcmp(_effect_filter_buffer, "Search") != 0)
+				{
+					filter_techniques(_effect_filter_buffer);
 				}
 			}
-			else if (source == "random")
-			{
-				const int min = variable.annotations["min"].as<int>(), max = variable.annotations["max"].as<int>();
-				const int value = min + (std::rand() % (max - min + 1));
+		}
 
-				set_uniform_value(variable, &value, 1);
-			}
+		// Upload image data the texture workers finished decoding since the last frame
+		if (_remaining_texture_load_tasks != 0)
+		{
+			upload_textures();
+		}
+	}
+	void runtime::on_present_effect()
+	{
+		// Reset here rather than in on_present, which runs after the uploads of this frame and draws the overlay that shows them
+		_uniform_bytes_uploaded = 0;
+
+		if (_input->is_key_pressed(_effects_key_data[0], _effects_key_data[1] != 0, _effects_key_data[2] != 0, false))
+		{
+			_effects_enabled = !_effects_enabled;
+		}
+
+		if (!_effects_enabled)
+		{
+			return;
 		}
 
+		// Update all uniform variables that have a source, everything about them was already looked up when their effect was loaded
+		update_uniforms();
+
 		// Render all enabled techniques
 		for (auto &technique : _techniques)
 		{
@@ -422,7 +328,9 @@ namespace reshade
 
 			const auto time_technique_started = std::chrono::high_resolution_clock::now();
 
-			render_technique(technique);
+			{ const profiler::zone profile_zone("render_technique", technique.name);
+				render_technique(technique);
+			}
 
 			const auto time_technique_finished = std::chrono::high_resolution_clock::now();
 
@@ -482,13 +390,28 @@ namespace reshade
 		}
 
 		_reload_remaining_effects = _effect_files.size();
+
+		start_effect_workers();
 	}
-	void runtime::load_effect(const filesystem::path &path)
+	void runtime::start_effect_workers()
 	{
-		LOG(INFO) << "Compiling " << path << " ...";
-
-		reshadefx::preprocessor pp;
-		pp.add_include_path(path.parent_path());
+		assert(_effect_workers.empty());
+
+		// Capture everything the workers read, since the settings can be changed while they are running
+		_effect_load_settings.include_paths.clear();
+		_effect_load_settings.macros = {
+			{ "__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION) },
+			{ "__RESHADE_PERFORMANCE_MODE__", _performance_mode ? "1" : "0" },
+			{ "__VENDOR__", std::to_string(_vendor_id) },
+			{ "__DEVICE__", std::to_string(_device_id) },
+			{ "__RENDERER__", std::to_string(_renderer_id) },
+			{ "__APPLICATION__", std::to_string(std::hash<std::string>()(s_target_executable_path.filename_without_extension().string())) },
+			{ "BUFFER_WIDTH", std::to_string(_width) },
+			{ "BUFFER_HEIGHT", std::to_string(_height) },
+			{ "BUFFER_RCP_WIDTH", std::to_string(1.0f / static_cast<float>(_width)) },
+			{ "BUFFER_RCP_HEIGHT", std::to_string(1.0f / static_cast<float>(_height)) },
+		};
+		_effect_load_settings.preset_path.clear();
 
 		for (const auto &include_path : _effect_search_paths)
 		{
@@ -497,20 +420,9 @@ namespace reshade
 				continue;
 			}
 
-			pp.add_include_path(include_path);
+			_effect_load_settings.include_paths.push_back(include_path);
 		}
 
-		pp.add_macro_definition("__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
-		pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", _performance_mode ? "1" : "0");
-		pp.add_macro_definition("__VENDOR__", std::to_string(_vendor_id));
-		pp.add_macro_definition("__DEVICE__", std::to_string(_device_id));
-		pp.add_macro_definition("__RENDERER__", std::to_string(_renderer_id));
-		pp.add_macro_definition("__APPLICATION__", std::to_string(std::hash<std::string>()(s_target_executable_path.filename_without_extension().string())));
-		pp.add_macro_definition("BUFFER_WIDTH", std::to_string(_width));
-		pp.add_macro_definition("BUFFER_HEIGHT", std::to_string(_height));
-		pp.add_macro_definition("BUFFER_RCP_WIDTH", std::to_string(1.0f / static_cast<float>(_width)));
-		pp.add_macro_definition("BUFFER_RCP_HEIGHT", std::to_string(1.0f / static_cast<float>(_height)));
-
 		for (const auto &definition : _preprocessor_definitions)
 		{
 			if (definition.empty())
@@ -522,34 +434,125 @@ namespace reshade
 
 			if (equals_index != std::string::npos)
 			{
-				pp.add_macro_definition(definition.substr(0, equals_index), definition.substr(equals_index + 1));
+				_effect_load_settings.macros.emplace_back(definition.substr(0, equals_index), definition.substr(equals_index + 1));
 			}
 			else
 			{
-				pp.add_macro_definition(definition);
+				_effect_load_settings.macros.emplace_back(definition, "1");
 			}
 		}
 
-		if (!pp.run(path))
+		if (_performance_mode && _current_preset >= 0)
 		{
-			LOG(ERROR) << "Failed to preprocess " << path << ":\n" << pp.errors();
-			_errors += path.string() + ":\n" + pp.errors();
-			return;
+			_effect_load_settings.preset_path = _preset_files[_current_preset];
 		}
 
-		reshadefx::syntax_tree ast;
-		reshadefx::parser parser(ast);
+		_effect_load_tasks = std::vector<effect_load_task>(_effect_files.size());
+		_next_effect_load_task = 0;
+
+		const size_t worker_count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 2u) - 1, _effect_files.size());
 
-		if (!parser.run(pp.current_output()))
+		for (size_t i = 0; i < worker_count; i++)
 		{
-			LOG(ERROR) << "Failed to compile " << path << ":\n" << parser.errors();
-			_errors += path.string() + ":\n" + parser.errors();
-			return;
+			_effect_workers.emplace_back([this]() {
+				// Each worker grabs the next unclaimed file, so that a few large effects do not hold up the rest
+				for (size_t index; (index = _next_effect_load_task.fetch_add(1)) < _effect_load_tasks.size();)
+				{
+					auto &task = _effect_load_tasks[index];
+					task.ast = std::make_unique<reshadefx::syntax_tree>();
+					task.success = parse_effect(_effect_files[index], *task.ast, task.errors);
+					task.ready.store(true, std::memory_order_release);
+				}
+			});
 		}
+	}
+	void runtime::stop_effect_workers()
+	{
+		// Prevent workers from claiming any further files and wait for those in progress to finish
+		_next_effect_load_task = _effect_load_tasks.size();
 
-		if (_performance_mode && _current_preset >= 0)
+		for (auto &worker : _effect_workers)
 		{
-			ini_file preset(_preset_files[_current_preset]);
+			worker.join();
+		}
+
+		_effect_workers.clear();
+		_effect_load_tasks.clear();
+	}
+
+	bool runtime::parse_effect(const filesystem::path &path, reshadefx::syntax_tree &ast, std::string &errors) const
+	{
+		// The file name is only needed to label the profiler zones
+		const std::string filename = profiler::is_enabled() ? path.filename().string() : std::string();
+		const profiler::zone profile_zone("parse_effect", filename);
+
+		const effect_load_settings &settings = _effect_load_settings;
+
+		std::vector<filesystem::path> include_paths = { path.parent_path() };
+		include_paths.insert(include_paths.end(), settings.include_paths.begin(), settings.include_paths.end());
+		const auto &macros = settings.macros;
+
+		// Everything besides the files themselves that can change the preprocessed output
+		std::string environment = VERSION_STRING_FILE "\n";
+
+		for (const auto &include_path : include_paths)
+		{
+			environment += include_path.string() + '\n';
+		}
+		for (const auto &macro : macros)
+		{
+			environment += macro.first + '=' + macro.second + '\n';
+		}
+
+		std::string source_code;
+
+		if (!_effect_cache.load(path, environment, source_code))
+		{
+			reshadefx::preprocessor pp;
+			// Shared headers are usually included by many effects with the same macro state, so reuse their output
+			pp.set_include_cache(_include_cache.get());
+
+			for (const auto &include_path : include_paths)
+			{
+				pp.add_include_path(include_path);
+			}
+			for (const auto &macro : macros)
+			{
+				pp.add_macro_definition(macro.first, macro.second);
+			}
+
+			std::vector<filesystem::path> included_files;
+
+			{ const profiler::zone preprocess_profile_zone("preprocess", filename);
+				if (!pp.run(path, included_files))
+				{
+					errors = pp.errors();
+					return false;
+				}
+			}
+
+			source_code = pp.current_output();
+
+			// Only cache clean results, so that warnings are not lost on the next load
+			if (pp.errors().empty())
+			{
+				_effect_cache.save(path, environment, included_files, source_code);
+			}
+		}
+
+		reshadefx::parser parser(ast);
+
+		{ const profiler::zone parse_profile_zone("parse", filename);
+			if (!parser.run(source_code))
+			{
+				errors = parser.errors();
+				return false;
+			}
+		}
+
+		if (!settings.preset_path.empty())
+		{
+			const ini_file preset(settings.preset_path);
 
 			for (auto variable : ast.variables)
 			{
@@ -582,9 +585,27 @@ namespace reshade
 			}
 		}
 
-		std::string errors = parser.errors();
+		errors = parser.errors();
+
+		return true;
+	}
+	void runtime::load_effect(const filesystem::path &path, effect_load_task &task)
+	{
+		const std::string filename = profiler::is_enabled() ? path.filename().string() : std::string();
+		const profiler::zone profile_zone("load_effect", filename);
 
-		if (!load_effect(ast, errors))
+		LOG(INFO) << "Compiling " << path << " ...";
+
+		if (!task.success)
+		{
+			LOG(ERROR) << "Failed to compile " << path << ":\n" << task.errors;
+			_errors += path.string() + ":\n" + task.errors;
+			return;
+		}
+
+		std::string &errors = task.errors;
+
+		if (!load_effect(*task.ast, errors))
 		{
 			LOG(ERROR) << "Failed to compile " << path << ":\n" << errors;
 			_errors += path.string() + ":\n" + errors;
@@ -608,6 +629,8 @@ namespace reshade
 			auto &variable = _uniforms[i];
 			variable.effect_filename = path.filename().string();
 			variable.hidden = variable.annotations["hidden"].as<bool>();
+
+			add_uniform_update(i);
 		}
 		for (size_t i = _texture_count, max = _texture_count = _textures.size(); i < max; i++)
 		{
@@ -627,12 +650,40 @@ namespace reshade
 			technique.toggle_key_data[3] = technique.annotations["togglealt"].as<bool>() ? 1 : 0;
 		}
 	}
+	void runtime::add_uniform_update(size_t index)
+	{
+		uniform_update update;
+
+		if (resolve_uniform_update(_uniforms[index], index, update))
+		{
+			_uniform_updates.push_back(update);
+		}
+	}
+	void runtime::update_uniforms()
+	{
+		const profiler::zone profile_zone("update_uniforms");
+
+		uniform_update_state frame;
+		frame.frame_duration = _last_frame_duration;
+		frame.elapsed_time = _last_present_time - _start_time;
+		frame.framecount = _framecount;
+		frame.date = _date;
+		frame.input = _input.get();
+
+		apply_uniform_updates(*this, _uniforms, _uniform_updates, frame);
+	}
 	void runtime::load_textures()
 	{
+		const profiler::zone profile_zone("load_textures");
+
 		LOG(INFO) << "Loading image files for textures ...";
 
-		for (auto &texture : _textures)
+		assert(_texture_workers.empty() && _texture_load_tasks.empty());
+
+		for (size_t index = 0; index < _textures.size(); index++)
 		{
+			const auto &texture = _textures[index];
+
 			if (texture.impl_reference != texture_reference::none)
 			{
 				continue;
@@ -655,51 +706,202 @@ namespace reshade
 				continue;
 			}
 
-			FILE *file;
-			unsigned char *filedata = nullptr;
-			int width = 0, height = 0, channels = 0;
-			bool success = false;
+			texture_load_task task;
+			task.texture_index = index;
+			task.path = path;
+			task.width = texture.width;
+			task.height = texture.height;
 
-			if (_wfopen_s(&file, path.wstring().c_str(), L"rb") == 0)
-			{
-				if (stbi_dds_test_file(file))
-				{
-					filedata = stbi_dds_load_from_file(file, &width, &height, &channels, STBI_rgb_alpha);
-				}
-				else
-				{
-					filedata = stbi_load_from_file(file, &width, &height, &channels, STBI_rgb_alpha);
-				}
+			_texture_load_tasks.push_back(std::move(task));
+		}
 
-				fclose(file);
-			}
+		start_texture_workers();
+	}
+	void runtime::start_texture_workers()
+	{
+		assert(_texture_workers.empty());
 
-			if (filedata != nullptr)
-			{
-				if (texture.width != static_cast<unsigned int>(width) ||
-					texture.height != static_cast<unsigned int>(height))
+		_next_texture_load_task = 0;
+		_remaining_texture_load_tasks = _texture_load_tasks.size();
+		_texture_load_memory = 0;
+		_is_texture_loading_cancelled = false;
+		_texture_cache.reset_statistics();
+
+		const size_t worker_count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 2u) - 1, _texture_load_tasks.size());
+
+		for (size_t i = 0; i < worker_count; i++)
+		{
+			_texture_workers.emplace_back([this]() {
+				for (size_t index; (index = _next_texture_load_task.fetch_add(1)) < _texture_load_tasks.size();)
 				{
-					LOG(INFO) << "> Resizing image data for texture '" << texture.name << "' from " << width << "x" << height << " to " << texture.width << "x" << texture.height << " ...";
+					auto &task = _texture_load_tasks[index];
+					const size_t size = task.width * task.height * 4;
+					const std::string filename = profiler::is_enabled() ? task.path.filename().string() : std::string();
+
+					{ std::unique_lock<std::mutex> lock(_texture_load_mutex);
+						// Wait for the render thread to upload earlier images if the ones waiting in memory would exceed the budget (but always let at least one through)
+						_texture_load_condition.wait(lock, [this, size]() { return _is_texture_loading_cancelled || _texture_load_memory == 0 || _texture_load_memory + size <= _texture_load_memory_limit; });
+
+						if (_is_texture_loading_cancelled)
+						{
+							break;
+						}
 
-					std::vector<uint8_t> resized(texture.width * texture.height * 4);
-					stbir_resize_uint8(filedata, width, height, 0, resized.data(), texture.width, texture.height, 0, 4);
-					success = update_texture(texture, resized.data());
+						_texture_load_memory += size;
+					}
+
+					// Only covers the work on the image itself, not waiting for memory
+					const profiler::zone profile_zone("load_image", filename);
+
+					std::vector<uint8_t> filedata;
+
+					{ std::ifstream file(task.path.wstring(), std::ios::in | std::ios::binary | std::ios::ate);
+						if (file.is_open())
+						{
+							filedata.resize(static_cast<size_t>(file.tellg()));
+
+							if (!file.seekg(0).read(reinterpret_cast<char *>(filedata.data()), filedata.size()))
+							{
+								filedata.clear();
+							}
+						}
+					}
+
+					// Images are keyed by their file contents, so editing a source file automatically invalidates its cache entry
+					const uint64_t cache_key = texture_cache::key(filedata, task.width, task.height);
+
+					if (!filedata.empty() && _texture_cache.load(cache_key, task.width, task.height, task.data, task.source_width, task.source_height))
+					{
+						task.success = true;
+					}
+					else if (!filedata.empty())
+					{
+						unsigned char *pixels = nullptr;
+						int width = 0, height = 0, channels = 0;
+
+						if (stbi_dds_test_memory(filedata.data(), static_cast<int>(filedata.size())))
+						{
+							pixels = stbi_dds_load_from_memory(filedata.data(), static_cast<int>(filedata.size()), &width, &height, &channels, STBI_rgb_alpha);
+						}
+						else
+						{
+							pixels = stbi_load_from_memory(filedata.data(), static_cast<int>(filedata.size()), &width, &height, &channels, STBI_rgb_alpha);
+						}
+
+						if (pixels != nullptr)
+						{
+							task.data.resize(size);
+
+							if (task.width != static_cast<unsigned int>(width) ||
+								task.height != static_cast<unsigned int>(height))
+							{
+								stbir_resize_uint8(pixels, width, height, 0, task.data.data(), task.width, task.height, 0, 4);
+							}
+							else
+							{
+								std::memcpy(task.data.data(), pixels, size);
+							}
+
+							stbi_image_free(pixels);
+
+							_texture_cache.save(cache_key, task.width, task.height, width, height, task.data);
+
+							task.source_width = width;
+							task.source_height = height;
+							task.success = true;
+						}
+					}
+
+					{ const std::lock_guard<std::mutex> lock(_texture_load_mutex);
+						_finished_texture_load_tasks.push_back(index);
+					}
 				}
-				else
+			});
+		}
+	}
+	void runtime::stop_texture_workers()
+	{
+		// Wake up workers waiting for memory, prevent them from claiming any further files and wait for those in progress to finish
+		{ const std::lock_guard<std::mutex> lock(_texture_load_mutex);
+			_is_texture_loading_cancelled = true;
+		}
+
+		_next_texture_load_task = _texture_load_tasks.size();
+		_texture_load_condition.notify_all();
+
+		for (auto &worker : _texture_workers)
+		{
+			worker.join();
+		}
+
+		_texture_workers.clear();
+		_texture_load_tasks.clear();
+		_finished_texture_load_tasks.clear();
+		_remaining_texture_load_tasks = 0;
+		_texture_load_memory = 0;
+	}
+	void runtime::upload_textures()
+	{
+		const profiler::zone profile_zone("upload_textures");
+
+		const auto time_started = std::chrono::high_resolution_clock::now();
+
+		while (_remaining_texture_load_tasks != 0)
+		{
+			size_t index;
+
+			{ const std::lock_guard<std::mutex> lock(_texture_load_mutex);
+				if (_finished_texture_load_tasks.empty())
 				{
-					success = update_texture(texture, filedata);
+					break;
 				}
 
-				stbi_image_free(filedata);
+				index = _finished_texture_load_tasks.front();
+				_finished_texture_load_tasks.pop_front();
 			}
 
-			if (!success)
+			auto &task = _texture_load_tasks[index];
+			auto &texture = _textures[task.texture_index];
+
+			// The log is not thread-safe, so the workers leave reporting to this thread
+			if (task.success && (task.source_width != task.width || task.source_height != task.height))
+			{
+				LOG(INFO) << "> Resized image data for texture '" << texture.name << "' from " << task.source_width << "x" << task.source_height << " to " << task.width << "x" << task.height << ".";
+			}
+
+			if (!task.success || !update_texture(texture, task.data.data()))
 			{
 				_errors += "Unable to load source for texture '" + texture.name + "'!";
 
-				LOG(ERROR) << "> Source " << path << " for texture '" << texture.name << "' could not be loaded! Make sure it is of a compatible file format.";
-				continue;
+				LOG(ERROR) << "> Source " << task.path << " for texture '" << texture.name << "' could not be loaded! Make sure it is of a compatible file format.";
 			}
+
+			// Return the memory of this image to the budget, so that waiting workers can continue decoding
+			task.data.clear();
+			task.data.shrink_to_fit();
+
+			{ const std::lock_guard<std::mutex> lock(_texture_load_mutex);
+				_texture_load_memory -= task.width * task.height * 4;
+			}
+
+			_texture_load_condition.notify_all();
+
+			_remaining_texture_load_tasks--;
+
+			// Spread uploads over multiple frames to keep the application responsive
+			if (std::chrono::high_resolution_clock::now() - time_started > std::chrono::milliseconds(8))
+			{
+				break;
+			}
+		}
+
+		if (_remaining_texture_load_tasks == 0)
+		{
+			LOG(INFO) << "Finished loading image files for textures (" << _texture_cache.hits() << " cache hits, " << _texture_cache.misses() << " cache misses).";
+
+			stop_texture_workers();
+
+			_texture_cache.flush();
 		}
 	}
 
@@ -709,6 +911,7 @@ namespace reshade
 
 		config.get("INPUT", "KeyMenu", _menu_key_data);
 		config.get("INPUT", "KeyScreenshot", _screenshot_key_data);
+		config.get("INPUT", "KeyBurstCapture", _burst_key_data);
 		config.get("INPUT", "KeyEffects", _effects_key_data);
 		config.get("INPUT", "InputProcessing", _input_processing_mode);
 
@@ -721,10 +924,15 @@ namespace reshade
 		config.get("GENERAL", "TutorialProgress", _tutorial_index);
 		config.get("GENERAL", "ScreenshotPath", _screenshot_path);
 		config.get("GENERAL", "ScreenshotFormat", _screenshot_format);
+		config.get("GENERAL", "BurstCaptureFormat", _burst_format);
+		config.get("GENERAL", "BurstCaptureFrameCount", _burst_frame_count);
 		config.get("GENERAL", "ShowClock", _show_clock);
 		config.get("GENERAL", "ShowFPS", _show_framerate);
 		config.get("GENERAL", "FontGlobalScale", _imgui_context->IO.FontGlobalScale);
 		config.get("GENERAL", "NoReloadOnInit", _no_reload_on_init);
+		config.get("GENERAL", "EffectCachePath", _effect_cache_path);
+		config.get("GENERAL", "ShaderCacheSize", _shader_cache_size);
+		config.get("GENERAL", "TextureCacheSize", _texture_cache_size);
 
 		config.get("STYLE", "Alpha", _imgui_context->Style.Alpha);
 		config.get("STYLE", "ColBackground", _imgui_col_background);
@@ -806,6 +1014,18 @@ namespace reshade
 		to_absolute(_preset_files);
 		to_absolute(_effect_search_paths);
 		to_absolute(_texture_search_paths);
+
+		if (!_effect_cache_path.empty())
+		{
+			_effect_cache_path = filesystem::absolute(_effect_cache_path, parent_path);
+		}
+
+		_effect_cache.set_directory(_effect_cache_path);
+		// The size limit is given in megabytes and has to be known before existing entries are picked up
+		_shader_cache.set_size_limit(static_cast<size_t>(_shader_cache_size) * 1024 * 1024);
+		_shader_cache.set_storage(_effect_cache_path.empty() ? nullptr : std::make_unique<shader_cache_directory>(_effect_cache_path));
+		_texture_cache.set_size_limit(static_cast<size_t>(_texture_cache_size) * 1024 * 1024);
+		_texture_cache.set_storage(_effect_cache_path.empty() ? nullptr : std::make_unique<texture_cache_directory>(_effect_cache_path));
 	}
 	void runtime::save_configuration() const
 	{
@@ -813,6 +1033,7 @@ namespace reshade
 
 		config.set("INPUT", "KeyMenu", _menu_key_data);
 		config.set("INPUT", "KeyScreenshot", _screenshot_key_data);
+		config.set("INPUT", "KeyBurstCapture", _burst_key_data);
 		config.set("INPUT", "KeyEffects", _effects_key_data);
 		config.set("INPUT", "InputProcessing", _input_processing_mode);
 
@@ -825,10 +1046,15 @@ namespace reshade
 		config.set("GENERAL", "TutorialProgress", _tutorial_index);
 		config.set("GENERAL", "ScreenshotPath", _screenshot_path);
 		config.set("GENERAL", "ScreenshotFormat", _screenshot_format);
+		config.set("GENERAL", "BurstCaptureFormat", _burst_format);
+		config.set("GENERAL", "BurstCaptureFrameCount", _burst_frame_count);
 		config.set("GENERAL", "ShowClock", _show_clock);
 		config.set("GENERAL", "ShowFPS", _show_framerate);
 		config.set("GENERAL", "FontGlobalScale", _imgui_context->IO.FontGlobalScale);
 		config.set("GENERAL", "NoReloadOnInit", _no_reload_on_init);
+		config.set("GENERAL", "EffectCachePath", _effect_cache_path);
+		config.set("GENERAL", "ShaderCacheSize", _shader_cache_size);
+		config.set("GENERAL", "TextureCacheSize", _texture_cache_size);
 
 		config.set("STYLE", "Alpha", _imgui_context->Style.Alpha);
 		config.set("STYLE", "ColBackground", _imgui_col_background);
@@ -978,10 +1204,11 @@ namespace reshade
 		}
 	}
 
-	void runtime::save_screenshot() const
+	void runtime::save_screenshot()
 	{
-		std::vector<uint8_t> data(_width * _height * 4);
-		capture_frame(data.data());
+		// Only the read back happens here, encoding and writing the file is left to the background threads
+		_screenshot_buffer.resize(_width * _height * 4);
+		capture_frame(_screenshot_buffer.data());
 
 		const int hour = _date[3] / 3600;
 		const int minute = (_date[3] - hour * 3600) / 60;
@@ -991,34 +1218,112 @@ namespace reshade
 		ImFormatString(filename, sizeof(filename), " %.4d-%.2d-%.2d %.2d-%.2d-%.2d%s", _date[0], _date[1], _date[2], hour, minute, second, _screenshot_format == 0 ? ".bmp" : ".png");
 		const auto path = _screenshot_path / (s_target_executable_path.filename_without_extension() + filename);
 
-		LOG(INFO) << "Saving screenshot to " << path << " ...";
+		if (_image_encoder.submit(path, _screenshot_format == 0 ? image_encoder::image_format::bmp : image_encoder::image_format::png, _width, _height, _screenshot_buffer))
+		{
+			LOG(INFO) << "Saving screenshot to " << path << " ...";
+		}
+		else
+		{
+			LOG(WARNING) << "Skipped screenshot because too many previous ones are still being written.";
+		}
+	}
+	void runtime::start_burst_capture()
+	{
+		const int hour = _date[3] / 3600;
+		const int minute = (_date[3] - hour * 3600) / 60;
+		const int second = _date[3] - hour * 3600 - minute * 60;
+
+		char filename[21];
+		ImFormatString(filename, sizeof(filename), " %.4d-%.2d-%.2d %.2d-%.2d-%.2d", _date[0], _date[1], _date[2], hour, minute, second);
+		_burst_path = _screenshot_path / (s_target_executable_path.filename_without_extension() + filename);
+
+		_is_burst_capturing = true;
+		_burst_frames_remaining = std::max(_burst_frame_count, 1);
+		_burst_frames_captured = _burst_frames_dropped = _burst_frames_failed = 0;
+
+		// All memory is allocated up front, frames are then captured into whichever buffer the encoder is done with
+		_burst_buffer_count = std::min<size_t>(_burst_encoder.max_pending(), _burst_frames_remaining);
+		_burst_buffers.resize(_burst_buffer_count);
+
+		for (auto &buffer : _burst_buffers)
+		{
+			buffer.resize(_width * _height * 4);
+		}
+
+		LOG(INFO) << "Starting burst capture of " << _burst_frames_remaining << " frames to " << _burst_path << (_burst_format == 0 ? " ..." : ".raw ...");
+	}
+	void runtime::capture_burst_frame()
+	{
+		const unsigned int frame_index = _burst_frames_captured + _burst_frames_dropped;
+
+		_burst_frames_remaining--;
+
+		// Skip the frame if every buffer is still waiting to be written, rather than stalling the application until one is available
+		if (_burst_buffers.empty())
+		{
+			_burst_frames_dropped++;
+			return;
+		}
+
+		auto &buffer = _burst_buffers.back();
+		capture_frame(buffer.data());
 
-		FILE *file;
-		bool success = false;
+		image_encoder::image_format format = image_encoder::image_format::raw;
+		filesystem::path path = _burst_path + ".raw";
 
-		if (_wfopen_s(&file, path.wstring().c_str(), L"wb") == 0)
+		if (_burst_format == 0)
 		{
-			stbi_write_func *const func =
-				[](void *context, void *data, int size) {
-					fwrite(data, 1, size, static_cast<FILE *>(context));
-				};
+			// Frames are numbered by the time they were presented, so that gaps in the sequence show where frames were dropped
+			char suffix[16];
+			ImFormatString(suffix, sizeof(suffix), " %.5u%s", frame_index, _screenshot_format == 0 ? ".bmp" : ".png");
 
-			switch (_screenshot_format)
+			format = _screenshot_format == 0 ? image_encoder::image_format::bmp : image_encoder::image_format::png;
+			path = _burst_path + suffix;
+		}
+
+		if (_burst_encoder.submit(path, format, _width, _height, buffer, frame_index))
+		{
+			_burst_buffers.pop_back();
+			_burst_frames_captured++;
+		}
+		else
+		{
+			_burst_frames_dropped++;
+		}
+	}
+	void runtime::collect_burst_frames()
+	{
+		_burst_encoder.take_finished(_finished_images);
+
+		for (auto &result : _finished_images)
+		{
+			if (!result.success)
 			{
-				case 0:
-					success = stbi_write_bmp_to_func(func, file, _width, _height, 4, data.data()) != 0;
-					break;
-				case 1:
-					success = stbi_write_png_to_func(func, file, _width, _height, 4, data.data(), 0) != 0;
-					break;
+				_burst_frames_failed++;
 			}
 
-			fclose(file);
+			_burst_buffers.push_back(std::move(result.pixels));
 		}
 
-		if (!success)
+		_finished_images.clear();
+
+		if (!_is_burst_capturing || _burst_frames_remaining != 0 || _burst_buffers.size() != _burst_buffer_count)
+		{
+			return;
+		}
+
+		_is_burst_capturing = false;
+		_burst_buffers.clear();
+		_burst_buffers.shrink_to_fit();
+
+		if (_burst_frames_dropped == 0 && _burst_frames_failed == 0)
+		{
+			LOG(INFO) << "Finished burst capture with all " << _burst_frames_captured << " frames written.";
+		}
+		else
 		{
-			LOG(ERROR) << "Failed to write screenshot to " << path << "!";
+			LOG(WARNING) << "Finished burst capture with " << (_burst_frames_captured - _burst_frames_failed) << " frames written, "
+				<< _burst_frames_dropped << " dropped and " << _burst_frames_failed << " failed to write.";
 		}
 	}
 
@@ -1052,8 +1357,34 @@ namespace reshade
 		return result;
 	}
 
+	void runtime::save_profile_trace()
+	{
+		const int hour = _date[3] / 3600;
+		const int minute = (_date[3] - hour * 3600) / 60;
+		const int second = _date[3] - hour * 3600 - minute * 60;
+
+		char filename[32];
+		ImFormatString(filename, sizeof(filename), " trace %.4d-%.2d-%.2d %.2d-%.2d-%.2d.json", _date[0], _date[1], _date[2], hour, minute, second);
+		const auto path = _screenshot_path / (s_target_executable_path.filename_without_extension() + filename);
+
+		if (profiler::export_chrome_trace(path))
+		{
+			LOG(INFO) << "Saved CPU profile trace to " << path << ".";
+
+			_profile_trace_status = "Saved to " + path.string();
+		}
+		else
+		{
+			LOG(ERROR) << "Failed to write CPU profile trace to " << path << "!";
+
+			_profile_trace_status = "Failed to write " + path.string();
+		}
+	}
+
 	void runtime::draw_overlay()
 	{
+		const profiler::zone profile_zone("draw_overlay");
+
 		const bool show_splash = std::chrono::duration_cast<std::chrono::seconds>(_last_present_time - _last_reload_time).count() < 5;
 
 		if (!_overlay_key_setting_active &&
@@ -1727,6 +2058,44 @@ namespace reshade
 			{
 				save_configuration();
 			}
+
+			assert(_burst_key_data[0] < 256);
+
+			copy_key_shortcut_to_edit_buffer(_burst_key_data);
+
+			ImGui::InputText("Burst Capture Key", edit_buffer, sizeof(edit_buffer), ImGuiInputTextFlags_ReadOnly);
+
+			_burst_key_setting_active = false;
+
+			if (ImGui::IsItemActive())
+			{
+				_burst_key_setting_active = true;
+
+				const unsigned int last_key_pressed = _input->last_key_pressed();
+
+				if (last_key_pressed != 0 && (last_key_pressed < 0x10 || last_key_pressed > 0x11))
+				{
+					_burst_key_data[0] = last_key_pressed;
+					_burst_key_data[1] = _input->is_key_down(0x11);
+					_burst_key_data[2] = _input->is_key_down(0x10);
+
+					save_configuration();
+				}
+			}
+			else if (ImGui::IsItemHovered())
+			{
+				ImGui::SetTooltip("Click in the field and press any key to change the shortcut to that key.\nPressing it records the following frames into the screenshot path.");
+			}
+
+			if (ImGui::DragInt("Burst Frame Count", &_burst_frame_count, 1.0f, 1, 100000))
+			{
+				save_configuration();
+			}
+
+			if (ImGui::Combo("Burst Format", &_burst_format, "Numbered Screenshots\0Raw Container (*.raw)\0"))
+			{
+				save_configuration();
+			}
 		}
 
 		if (ImGui::CollapsingHeader("User Interface", ImGuiTreeNodeFlags_DefaultOpen))
@@ -1780,9 +2149,12 @@ namespace reshade
 			ImGui::TextUnformatted("FPS:");
 			ImGui::TextUnformatted("Post-Processing:");
 			ImGui::TextUnformatted("Draw Calls:");
+			ImGui::TextUnformatted("Uniform Uploads:");
 			ImGui::Text("Frame %llu:", _framecount + 1);
 			ImGui::TextUnformatted("Timer:");
 			ImGui::TextUnformatted("Network:");
+			if (_burst_frames_captured + _burst_frames_dropped != 0)
+				ImGui::TextUnformatted("Burst Capture:");
 			ImGui::EndGroup();
 
 			ImGui::SameLine(ImGui::GetWindowWidth() * 0.333f);
@@ -1794,9 +2166,12 @@ namespace reshade
 			ImGui::Text("%.2f", ImGui::GetIO().Framerate);
 			ImGui::Text("%f ms (CPU)", (post_processing_time_cpu * 1e-6f));
 			ImGui::Text("%u (%u vertices)", _drawcalls, _vertices);
+			ImGui::Text("%u B", static_cast<unsigned int>(_uniform_bytes_uploaded));
 			ImGui::Text("%f ms", _last_frame_duration.count() * 1e-6f);
 			ImGui::Text("%f ms", std::fmod(std::chrono::duration_cast<std::chrono::nanoseconds>(_last_present_time - _start_time).count() * 1e-6f, 16777216.0f));
 			ImGui::Text("%u B", g_network_traffic);
+			if (_burst_frames_captured + _burst_frames_dropped != 0)
+				ImGui::Text("%u captured, %u dropped, %u failed (%u remaining)", _burst_frames_captured, _burst_frames_dropped, _burst_frames_failed, _burst_frames_remaining);
 			ImGui::EndGroup();
 
 			ImGui::SameLine(ImGui::GetWindowWidth() * 0.666f);
@@ -1910,6 +2285,36 @@ namespace reshade
 
 			ImGui::EndGroup();
 		}
+
+		if (ImGui::CollapsingHeader("Profiler"))
+		{
+			bool profiler_enabled = profiler::is_enabled();
+
+			if (ImGui::Checkbox("Record CPU zones", &profiler_enabled))
+			{
+				profiler::set_enabled(profiler_enabled);
+			}
+
+			ImGui::SameLine();
+
+			if (ImGui::Button("Export Chrome Trace"))
+			{
+				save_profile_trace();
+			}
+
+			ImGui::SameLine();
+
+			if (ImGui::Button("Clear"))
+			{
+				profiler::clear();
+				_profile_trace_status.clear();
+			}
+
+			if (!_profile_trace_status.empty())
+			{
+				ImGui::TextUnformatted(_profile_trace_status.c_str());
+			}
+		}
 	}
 	void runtime::draw_overlay_menu_about()
 	{
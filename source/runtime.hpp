@@ -6,8 +6,18 @@
 #pragma once
 
 #include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <condition_variable>
 #include "filesystem.hpp"
 #include "runtime_objects.hpp"
+#include "effect_cache.hpp"
+#include "shader_cache.hpp"
+#include "texture_cache.hpp"
+#include "image_encoder.hpp"
+#include "uniform_updates.hpp"
 
 #pragma region Forward Declarations
 struct ImDrawData;
@@ -21,6 +31,7 @@ namespace reshade
 namespace reshadefx
 {
 	class syntax_tree;
+	class include_cache;
 }
 
 extern volatile long g_network_traffic;
@@ -39,6 +50,10 @@ namespace reshade
 		/// File path to the current executable.
 		/// </summary>
 		static filesystem::path s_target_executable_path;
+		/// <summary>
+		/// File path to the configuration file.
+		/// </summary>
+		static filesystem::path s_configuration_path;
 
 		/// <summary>
 		/// Construct a new runtime instance.
@@ -96,6 +111,10 @@ namespace reshade
 		/// </summary>
 		inline std::vector<unsigned char> &get_uniform_value_storage() { return _uniform_data_storage; }
 		/// <summary>
+		/// Return a reference to the cache of compiled shader bytecode.
+		/// </summary>
+		inline shader_cache &get_shader_cache() { return _shader_cache; }
+		/// <summary>
 		/// Get the value of a uniform variable.
 		/// </summary>
 		/// <param name="variable">The variable to retrieve the value from.</param>
@@ -117,6 +136,18 @@ namespace reshade
 		void set_uniform_value(uniform &variable, const int *values, size_t count);
 		void set_uniform_value(uniform &variable, const unsigned int *values, size_t count);
 		void set_uniform_value(uniform &variable, const float *values, size_t count);
+		/// <summary>
+		/// Check whether any bytes in the specified range of the uniform storage were modified since it was last uploaded. Ranges that were never uploaded are considered modified.
+		/// </summary>
+		/// <param name="offset">The offset into the uniform storage in bytes.</param>
+		/// <param name="size">The size of the range in bytes.</param>
+		bool is_uniform_storage_dirty(size_t offset, size_t size) const;
+		/// <summary>
+		/// Mark the specified range of the uniform storage as uploaded.
+		/// </summary>
+		/// <param name="offset">The offset into the uniform storage in bytes.</param>
+		/// <param name="size">The size of the range in bytes.</param>
+		void clear_uniform_storage_dirty(size_t offset, size_t size);
 
 		bool _show_menu = false;
 
@@ -144,10 +175,13 @@ namespace reshade
 		void on_present_effect();
 
 		/// <summary>
-		/// Compile effect from the specified source file and initialize textures, constants and techniques.
+		/// Preprocess and parse the specified effect source file. This is safe to call from worker threads.
+		/// It only reads the settings captured by <see cref="start_effect_workers"/>, so changes made in the settings while a reload is in progress apply to the next one.
 		/// </summary>
 		/// <param name="path">The path to an effect source code file.</param>
-		void load_effect(const filesystem::path &path);
+		/// <param name="ast">The abstract syntax tree to fill with the parsed effect.</param>
+		/// <param name="errors">A reference to a buffer to store errors which occur during parsing.</param>
+		bool parse_effect(const filesystem::path &path, reshadefx::syntax_tree &ast, std::string &errors) const;
 		/// <summary>
 		/// Compile effect from the specified abstract syntax tree and initialize textures, constants and techniques.
 		/// </summary>
@@ -157,7 +191,7 @@ namespace reshade
 		virtual bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) = 0;
 
 		/// <summary>
-		/// Loads image files and updates all textures with image data.
+		/// Start loading image files for all textures with a source in the background. The image data is uploaded over the next frames.
 		/// </summary>
 		void load_textures();
 		/// <summary>
@@ -182,6 +216,7 @@ namespace reshade
 		unsigned int _vendor_id = 0, _device_id = 0;
 		uint64_t _framecount = 0;
 		unsigned int _drawcalls = 0, _vertices = 0;
+		size_t _uniform_bytes_uploaded = 0; // Counted by the runtime implementations wherever they copy uniform data to the GPU
 		std::shared_ptr<input> _input;
 		ImGuiContext *_imgui_context = nullptr;
 		std::unique_ptr<ImFontAtlas> _imgui_font_atlas;
@@ -189,16 +224,53 @@ namespace reshade
 		std::vector<texture> _textures;
 		std::vector<uniform> _uniforms;
 		std::vector<technique> _techniques;
+		std::vector<uint8_t> _texture_upload_buffer; // Reused across texture updates to avoid an allocation for every converted image
 
 	private:
+		struct effect_load_settings
+		{
+			std::vector<filesystem::path> include_paths;
+			std::vector<std::pair<std::string, std::string>> macros;
+			filesystem::path preset_path;
+		};
+		struct effect_load_task
+		{
+			std::unique_ptr<reshadefx::syntax_tree> ast;
+			std::string errors;
+			bool success = false;
+			std::atomic<bool> ready = false;
+		};
+		struct texture_load_task
+		{
+			size_t texture_index;
+			filesystem::path path;
+			unsigned int width, height;
+			unsigned int source_width = 0, source_height = 0;
+			std::vector<uint8_t> data;
+			bool success = false;
+		};
+
 		void reload();
+		void start_effect_workers();
+		void stop_effect_workers();
+		void load_effect(const filesystem::path &path, effect_load_task &task);
+		void start_texture_workers();
+		void stop_texture_workers();
+		void upload_textures();
+		void add_uniform_update(size_t index);
+		void update_uniforms();
+		void mark_uniform_storage_dirty(size_t offset, size_t size);
 		void load_configuration();
 		void save_configuration() const;
 		void load_preset(const filesystem::path &path);
 		void load_current_preset();
 		void save_preset(const filesystem::path &path) const;
 		void save_current_preset() const;
-		void save_screenshot() const;
+		void save_screenshot();
+		void start_burst_capture();
+		void capture_burst_frame();
+		void collect_burst_frames();
+		void save_profile_trace();
 
 		void draw_overlay();
 		void draw_overlay_menu();
@@ -222,19 +294,41 @@ namespace reshade
 		std::chrono::high_resolution_clock::time_point _last_present_time;
 		std::chrono::high_resolution_clock::duration _last_frame_duration;
 		std::vector<unsigned char> _uniform_data_storage;
+		std::vector<uniform_update> _uniform_updates;
+		std::vector<bool> _uniform_storage_dirty; // One flag per 16 byte block (a constant register)
 		int _date[4] = { };
 		std::string _errors;
 		std::vector<std::string> _preprocessor_definitions;
 		int _menu_index = 0;
 		int _screenshot_format = 0;
+		int _burst_format = 0;
+		int _burst_frame_count = 60;
 		int _current_preset = -1;
 		int _selected_technique = -1;
 		int _input_processing_mode = 2;
 		unsigned int _menu_key_data[3];
 		unsigned int _screenshot_key_data[3];
+		unsigned int _burst_key_data[3];
 		unsigned int _effects_key_data[3];
 		filesystem::path _configuration_path;
 		filesystem::path _screenshot_path;
+		filesystem::path _effect_cache_path;
+		effect_cache _effect_cache;
+		shader_cache _shader_cache;
+		unsigned int _shader_cache_size = 256;
+		texture_cache _texture_cache;
+		unsigned int _texture_cache_size = 1024;
+		image_encoder _image_encoder;
+		std::vector<uint8_t> _screenshot_buffer; // Memory of the last written screenshot, kept to capture the next one into
+		std::vector<image_encoder::result> _finished_images;
+		image_encoder _burst_encoder;
+		filesystem::path _burst_path; // Path and file name of the current burst capture, without frame number and extension
+		std::vector<std::vector<uint8_t>> _burst_buffers; // Preallocated frame buffers that are not currently being written by the encoder
+		size_t _burst_buffer_count = 0;
+		unsigned int _burst_frames_remaining = 0, _burst_frames_captured = 0, _burst_frames_dropped = 0, _burst_frames_failed = 0;
+		bool _is_burst_capturing = false;
+		std::string _profile_trace_status; // Result of the last trace export, shown on the statistics page
+		std::unique_ptr<reshadefx::include_cache> _include_cache;
 		bool _show_error_log = false;
 		bool _show_clock = false;
 		bool _show_framerate = false;
@@ -244,6 +338,7 @@ namespace reshade
 		bool _performance_mode = false;
 		bool _overlay_key_setting_active = false;
 		bool _screenshot_key_setting_active = false;
+		bool _burst_key_setting_active = false;
 		bool _toggle_key_setting_active = false;
 		float _imgui_col_background[3] = { 0.275f, 0.275f, 0.275f };
 		float _imgui_col_item_background[3] = { 0.447f, 0.447f, 0.447f };
@@ -255,6 +350,19 @@ namespace reshade
 		unsigned int _effects_expanded_state = 2;
 		char _effect_filter_buffer[64] = { };
 		size_t _reload_remaining_effects = 0;
+		std::vector<std::thread> _effect_workers;
+		effect_load_settings _effect_load_settings;
+		std::vector<effect_load_task> _effect_load_tasks;
+		std::atomic<size_t> _next_effect_load_task = 0;
+		std::vector<std::thread> _texture_workers;
+		std::vector<texture_load_task> _texture_load_tasks;
+		std::atomic<size_t> _next_texture_load_task = 0;
+		std::mutex _texture_load_mutex;
+		std::condition_variable _texture_load_condition;
+		std::deque<size_t> _finished_texture_load_tasks;
+		size_t _remaining_texture_load_tasks = 0;
+		size_t _texture_load_memory = 0, _texture_load_memory_limit = 256 * 1024 * 1024;
+		bool _is_texture_loading_cancelled = false;
 		size_t _texture_count = 0;
 		size_t _uniform_count = 0;
 		size_t _technique_count = 0;
@@ -134,7 +134,12 @@ namespace reshade
 
 		assert(variable.storage_offset + size <= _uniform_data_storage.size());
 
-		std::memcpy(&_uniform_data_storage[variable.storage_offset], data, size);
+		if (std::memcmp(&_uniform_data_storage[variable.storage_offset], data, size) != 0)
+		{
+			std::memcpy(&_uniform_data_storage[variable.storage_offset], data, size);
+
+			mark_uniform_storage_dirty(variable.storage_offset, size);
+		}
 	}
 	void runtime::set_uniform_value(uniform &variable, const bool *values, size_t count)
 	{
@@ -242,4 +247,47 @@ namespace reshade
 			}
 		}
 	}
+
+	bool runtime::is_uniform_storage_dirty(size_t offset, size_t size) const
+	{
+		const size_t last = (offset + size + 15) / 16;
+
+		if (last > _uniform_storage_dirty.size())
+		{
+			return true;
+		}
+
+		for (size_t i = offset / 16; i < last; ++i)
+		{
+			if (_uniform_storage_dirty[i])
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+	void runtime::mark_uniform_storage_dirty(size_t offset, size_t size)
+	{
+		const size_t last = (offset + size + 15) / 16;
+
+		if (last > _uniform_storage_dirty.size())
+		{
+			_uniform_storage_dirty.resize(last, true);
+		}
+
+		std::fill(_uniform_storage_dirty.begin() + offset / 16, _uniform_storage_dirty.begin() + last, true);
+	}
+	void runtime::clear_uniform_storage_dirty(size_t offset, size_t size)
+	{
+		const size_t last = (offset + size + 15) / 16;
+
+		if (last > _uniform_storage_dirty.size())
+		{
+			// Blocks that were never uploaded before are dirty by definition
+			_uniform_storage_dirty.resize(last, true);
+		}
+
+		std::fill(_uniform_storage_dirty.begin() + offset / 16, _uniform_storage_dirty.begin() + last, false);
+	}
 }
@@ -0,0 +1,184 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "shader_cache.hpp"
+#include "effect_cache.hpp"
+#include <cstring>
+
+namespace reshade
+{
+	namespace
+	{
+		const uint32_t cache_magic = 0x43535352; // "RSSC"
+		const uint32_t cache_version = 2;
+
+		template <typename T>
+		inline void write(std::string &stream, const T &value)
+		{
+			stream.append(reinterpret_cast<const char *>(&value), sizeof(T));
+		}
+		inline void write(std::string &stream, const std::string &value)
+		{
+			write(stream, static_cast<uint64_t>(value.size()));
+			stream.append(value);
+		}
+		template <typename T>
+		inline bool read(const std::string &stream, size_t &offset, T &value)
+		{
+			if (stream.size() - offset < sizeof(T))
+			{
+				return false;
+			}
+
+			std::memcpy(&value, stream.data() + offset, sizeof(T));
+			offset += sizeof(T);
+
+			return true;
+		}
+		inline bool read(const std::string &stream, size_t &offset, std::string &value)
+		{
+			uint64_t size = 0;
+
+			if (!read(stream, offset, size) || size > stream.size() - offset)
+			{
+				return false;
+			}
+
+			value.assign(stream, offset, static_cast<size_t>(size));
+			offset += static_cast<size_t>(size);
+
+			return true;
+		}
+	}
+
+	uint64_t shader_cache::key(const std::string &compiler_version, const std::string &source, const std::string &entry_point, const std::string &profile, unsigned int flags)
+	{
+		uint64_t hash = effect_cache::hash(&flags, sizeof(flags));
+		hash = effect_cache::hash(compiler_version + '\0' + profile + '\0' + entry_point + '\0', hash);
+		hash = effect_cache::hash(source, hash);
+
+		return hash;
+	}
+
+	void shader_cache::set_storage(std::unique_ptr<storage> storage)
+	{
+		_storage = std::move(storage);
+		_index.clear();
+
+		if (_storage == nullptr)
+		{
+			return;
+		}
+
+		std::string order;
+
+		if (!_storage->read_order(order))
+		{
+			order.clear();
+		}
+
+		_index.restore(_storage->list(), order, cache_magic, cache_version);
+
+		evict();
+	}
+	void shader_cache::set_size_limit(size_t size)
+	{
+		_size_limit = size;
+
+		evict();
+	}
+
+	bool shader_cache::compile(const std::string &compiler_version, const std::string &source, const std::string &entry_point, const std::string &profile, unsigned int flags, std::string &bytecode, std::string &errors, const compile_callback &compiler)
+	{
+		const uint64_t shader_key = key(compiler_version, source, entry_point, profile, flags);
+		std::string warnings;
+
+		if (load(shader_key, bytecode, warnings))
+		{
+			errors += warnings;
+			return true;
+		}
+
+		const bool success = compiler(bytecode, warnings);
+
+		errors += warnings;
+
+		if (success)
+		{
+			save(shader_key, bytecode, warnings);
+		}
+
+		return success;
+	}
+
+	bool shader_cache::load(uint64_t key, std::string &bytecode, std::string &warnings)
+	{
+		if (!_index.contains(key))
+		{
+			return false;
+		}
+
+		std::string data;
+		size_t offset = 0;
+		uint32_t magic = 0, version = 0;
+		uint64_t cached_key = 0;
+
+		if (!_storage->read(key, data) ||
+			!read(data, offset, magic) || magic != cache_magic ||
+			!read(data, offset, version) || version != cache_version ||
+			!read(data, offset, cached_key) || cached_key != key ||
+			!read(data, offset, warnings) || !read(data, offset, bytecode))
+		{
+			// The entry is unusable, so forget about it and let the caller compile the shader again
+			_index.forget(key);
+			return false;
+		}
+
+		_index.touch(key);
+
+		return true;
+	}
+	void shader_cache::save(uint64_t key, const std::string &bytecode, const std::string &warnings)
+	{
+		if (_storage == nullptr)
+		{
+			return;
+		}
+
+		std::string data;
+		data.reserve(3 * sizeof(uint64_t) + 2 * sizeof(uint32_t) + warnings.size() + bytecode.size());
+
+		write(data, cache_magic);
+		write(data, cache_version);
+		write(data, key);
+		write(data, warnings);
+		write(data, bytecode);
+
+		if (!_storage->write(key, data))
+		{
+			return;
+		}
+
+		_index.insert(key, data.size());
+
+		evict();
+	}
+	void shader_cache::flush()
+	{
+		if (_storage == nullptr || !_index.is_order_modified())
+		{
+			return;
+		}
+
+		_storage->write_order(_index.save_order(cache_magic, cache_version));
+	}
+
+	void shader_cache::evict()
+	{
+		_index.evict(_size_limit, [this](uint64_t key) {
+			_storage->remove(key);
+		});
+	}
+}
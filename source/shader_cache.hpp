@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <memory>
+#include <functional>
+#include "cache_index.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// A persistent cache of compiled shader bytecode with a bounded size. Least recently used entries are evicted first.
+	/// </summary>
+	class shader_cache
+	{
+	public:
+		/// <summary>
+		/// The place cache entries are persisted in. Entries are opaque blobs of data identified by their key.
+		/// </summary>
+		class storage
+		{
+		public:
+			virtual ~storage() = default;
+
+			/// <summary>
+			/// Get the keys and sizes in bytes of all entries that are currently stored.
+			/// </summary>
+			virtual std::vector<std::pair<uint64_t, size_t>> list() = 0;
+			/// <summary>
+			/// Read the data of an entry.
+			/// </summary>
+			/// <returns>A boolean value indicating whether the entry exists and could be read.</returns>
+			virtual bool read(uint64_t key, std::string &data) = 0;
+			/// <summary>
+			/// Create or replace an entry.
+			/// </summary>
+			/// <returns>A boolean value indicating whether the entry was written.</returns>
+			virtual bool write(uint64_t key, const std::string &data) = 0;
+			/// <summary>
+			/// Delete an entry.
+			/// </summary>
+			virtual void remove(uint64_t key) = 0;
+			/// <summary>
+			/// Read the usage order saved by a previous call to <see cref="write_order"/>.
+			/// </summary>
+			virtual bool read_order(std::string &data) = 0;
+			/// <summary>
+			/// Save the usage order of the entries.
+			/// </summary>
+			virtual void write_order(const std::string &data) = 0;
+		};
+
+		/// <summary>
+		/// A function that compiles shader source code. It is only called on a cache miss.
+		/// </summary>
+		/// <param name="bytecode">The string to store the compiled bytecode in.</param>
+		/// <param name="errors">The string to store any warnings or errors reported by the compiler in.</param>
+		/// <returns>A boolean value indicating whether compilation succeeded.</returns>
+		using compile_callback = std::function<bool(std::string &bytecode, std::string &errors)>;
+
+		/// <summary>
+		/// Calculate the key identifying the bytecode of a shader.
+		/// </summary>
+		/// <param name="compiler_version">A string identifying the exact version of the compiler, so that an update of it does not reuse old bytecode.</param>
+		/// <param name="source">The shader source code.</param>
+		/// <param name="entry_point">The name of the shader entry point function.</param>
+		/// <param name="profile">The shader profile the source code is compiled for.</param>
+		/// <param name="flags">The compiler flags.</param>
+		static uint64_t key(const std::string &compiler_version, const std::string &source, const std::string &entry_point, const std::string &profile, unsigned int flags);
+
+		/// <summary>
+		/// Set the storage that cache entries are kept in and pick up any entries from previous runs. A <c>nullptr</c> disables the cache.
+		/// </summary>
+		/// <param name="storage">The storage to use.</param>
+		void set_storage(std::unique_ptr<storage> storage);
+		/// <summary>
+		/// Set the maximum total size of all cache entries.
+		/// </summary>
+		/// <param name="size">The size limit in bytes.</param>
+		void set_size_limit(size_t size);
+
+		/// <summary>
+		/// Look up the bytecode of a shader, or compile it and add the result to the cache if there is none yet.
+		/// </summary>
+		/// <param name="compiler_version">A string identifying the exact version of the compiler.</param>
+		/// <param name="source">The shader source code.</param>
+		/// <param name="entry_point">The name of the shader entry point function.</param>
+		/// <param name="profile">The shader profile the source code is compiled for.</param>
+		/// <param name="flags">The compiler flags.</param>
+		/// <param name="bytecode">The string to store the compiled bytecode in.</param>
+		/// <param name="errors">The string to append warnings or errors reported by the compiler to.</param>
+		/// <param name="compiler">The function to call on a cache miss.</param>
+		/// <returns>A boolean value indicating whether bytecode is available.</returns>
+		bool compile(const std::string &compiler_version, const std::string &source, const std::string &entry_point, const std::string &profile, unsigned int flags, std::string &bytecode, std::string &errors, const compile_callback &compiler);
+
+		/// <summary>
+		/// Look up the bytecode of a shader.
+		/// </summary>
+		/// <param name="key">The key of the shader.</param>
+		/// <param name="bytecode">The string to store the cached bytecode in.</param>
+		/// <param name="warnings">The string to store the warnings the compiler reported for this shader in.</param>
+		/// <returns>A boolean value indicating whether a cache entry was found.</returns>
+		bool load(uint64_t key, std::string &bytecode, std::string &warnings);
+		/// <summary>
+		/// Store the bytecode of a shader and evict old entries if the size limit is exceeded.
+		/// </summary>
+		/// <param name="key">The key of the shader.</param>
+		/// <param name="bytecode">The compiled bytecode to store.</param>
+		/// <param name="warnings">The warnings the compiler reported for this shader.</param>
+		void save(uint64_t key, const std::string &bytecode, const std::string &warnings);
+		/// <summary>
+		/// Write the current usage order to the storage, so that the next run evicts entries in the right order.
+		/// </summary>
+		void flush();
+
+	private:
+		void evict();
+
+		std::unique_ptr<storage> _storage;
+		size_t _size_limit = 256 * 1024 * 1024;
+		cache_index _index;
+	};
+}
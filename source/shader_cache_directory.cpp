@@ -0,0 +1,115 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "log.hpp"
+#include "shader_cache_directory.hpp"
+#include <fstream>
+#include <Windows.h>
+
+namespace reshade
+{
+	namespace
+	{
+		const char *const order_filename = "shaders.lru";
+
+		bool read_file(const filesystem::path &path, std::string &data)
+		{
+			std::ifstream file(path.wstring(), std::ios::in | std::ios::binary);
+
+			if (!file.is_open())
+			{
+				return false;
+			}
+
+			data.assign(std::istreambuf_iterator<char>(file.rdbuf()), std::istreambuf_iterator<char>());
+
+			return true;
+		}
+		bool write_file(const filesystem::path &path, const std::string &data)
+		{
+			std::ofstream file(path.wstring(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+			if (!file.is_open())
+			{
+				return false;
+			}
+
+			return !!file.write(data.data(), data.size());
+		}
+	}
+
+	std::string shader_cache_directory::compiler_version(void *module)
+	{
+		// The file name alone is not enough, since Windows updates replace the library without renaming it. The linker time stamp and image size differ between builds though.
+		const auto base = static_cast<const BYTE *>(module);
+		const auto nt_headers = reinterpret_cast<const IMAGE_NT_HEADERS *>(base + reinterpret_cast<const IMAGE_DOS_HEADER *>(base)->e_lfanew);
+
+		char build[18];
+		sprintf_s(build, "%08lx-%08lx", nt_headers->FileHeader.TimeDateStamp, nt_headers->OptionalHeader.SizeOfImage);
+
+		return filesystem::get_module_path(module).filename().string() + '-' + build;
+	}
+
+	std::vector<std::pair<uint64_t, size_t>> shader_cache_directory::list()
+	{
+		std::vector<std::pair<uint64_t, size_t>> entries;
+
+		for (const auto &file_path : filesystem::list_files(_path, "*.cso"))
+		{
+			const std::string name = file_path.filename_without_extension().string();
+			std::ifstream file(file_path.wstring(), std::ios::in | std::ios::binary | std::ios::ate);
+
+			if (name.size() != 16 || !file.is_open())
+			{
+				continue;
+			}
+
+			entries.emplace_back(std::strtoull(name.c_str(), nullptr, 16), static_cast<size_t>(file.tellg()));
+		}
+
+		return entries;
+	}
+	bool shader_cache_directory::read(uint64_t key, std::string &data)
+	{
+		return read_file(entry_path(key), data);
+	}
+	bool shader_cache_directory::write(uint64_t key, const std::string &data)
+	{
+		return create_directory() && write_file(entry_path(key), data);
+	}
+	void shader_cache_directory::remove(uint64_t key)
+	{
+		filesystem::remove(entry_path(key));
+	}
+	bool shader_cache_directory::read_order(std::string &data)
+	{
+		return read_file(_path / order_filename, data);
+	}
+	void shader_cache_directory::write_order(const std::string &data)
+	{
+		if (create_directory())
+		{
+			write_file(_path / order_filename, data);
+		}
+	}
+
+	filesystem::path shader_cache_directory::entry_path(uint64_t key) const
+	{
+		char name[21];
+		sprintf_s(name, "%016llx.cso", key);
+
+		return _path / name;
+	}
+	bool shader_cache_directory::create_directory() const
+	{
+		if (!filesystem::exists(_path) && !filesystem::create_directory(_path))
+		{
+			LOG(WARNING) << "Failed to create shader cache directory " << _path << ".";
+			return false;
+		}
+
+		return true;
+	}
+}
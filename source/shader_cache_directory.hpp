@@ -0,0 +1,44 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "shader_cache.hpp"
+#include "filesystem.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// Stores shader cache entries as files in a directory on disk.
+	/// </summary>
+	class shader_cache_directory : public shader_cache::storage
+	{
+	public:
+		/// <summary>
+		/// Build a string identifying the exact build of a loaded shader compiler library, to pass as the compiler version to <see cref="shader_cache::compile"/>.
+		/// </summary>
+		/// <param name="module">The handle of the compiler library.</param>
+		static std::string compiler_version(void *module);
+
+		/// <summary>
+		/// Construct a new storage in the specified directory. The directory is only created once the first entry is written.
+		/// </summary>
+		/// <param name="path">The path to the cache directory.</param>
+		explicit shader_cache_directory(const filesystem::path &path) : _path(path) { }
+
+		std::vector<std::pair<uint64_t, size_t>> list() override;
+		bool read(uint64_t key, std::string &data) override;
+		bool write(uint64_t key, const std::string &data) override;
+		void remove(uint64_t key) override;
+		bool read_order(std::string &data) override;
+		void write_order(const std::string &data) override;
+
+	private:
+		filesystem::path entry_path(uint64_t key) const;
+		bool create_directory() const;
+
+		filesystem::path _path;
+	};
+}
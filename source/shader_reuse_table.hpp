@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace reshade
+{
+	/// <summary>
+	/// The shaders created for the passes of an effect so far, identified by their <see cref="shader_cache::key"/>.
+	/// Passes commonly share entry points (like a full screen triangle vertex shader), so an identical shader only has to be compiled and created once per effect.
+	/// </summary>
+	template <typename T>
+	class shader_reuse_table
+	{
+	public:
+		/// <summary>
+		/// Look up a shader that was created from the same source code, entry point, profile and flags before.
+		/// </summary>
+		/// <param name="key">The key of the shader.</param>
+		/// <param name="shader">Set to the existing shader if one was found.</param>
+		/// <returns>A boolean value indicating whether the shader was found.</returns>
+		bool find(uint64_t key, T &shader)
+		{
+			const auto it = _shaders.find(key);
+
+			if (it == _shaders.end())
+			{
+				return false;
+			}
+
+			shader = it->second;
+			_reused_count++;
+
+			return true;
+		}
+		/// <summary>
+		/// Add a shader that was created successfully, so that later passes can reuse it.
+		/// </summary>
+		/// <param name="key">The key of the shader.</param>
+		/// <param name="shader">The shader to add.</param>
+		void insert(uint64_t key, const T &shader)
+		{
+			_shaders.emplace(key, shader);
+		}
+
+		/// <summary>
+		/// Get the number of times <see cref="find"/> returned an existing shader.
+		/// </summary>
+		size_t reused_count() const { return _reused_count; }
+
+		auto begin() const { return _shaders.begin(); }
+		auto end() const { return _shaders.end(); }
+
+	private:
+		std::unordered_map<uint64_t, T> _shaders;
+		size_t _reused_count = 0;
+	};
+}
@@ -0,0 +1,255 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "texel_conversion.hpp"
+#include <string.h>
+#include <intrin.h>
+#include <immintrin.h>
+
+namespace reshade::texel_conversion
+{
+	namespace
+	{
+		struct cpu_features
+		{
+			cpu_features()
+			{
+				int info[4];
+				__cpuid(info, 0);
+				const int max_leaf = info[0];
+
+				__cpuid(info, 1);
+				// AVX registers can only be used if the operating system saves them on context switches
+				const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+				const bool has_f16c = (info[2] & (1 << 29)) != 0;
+
+				if (max_leaf >= 7 && os_saves_ymm)
+				{
+					__cpuidex(info, 7, 0);
+					avx2 = (info[1] & (1 << 5)) != 0;
+					avx2_f16c = avx2 && has_f16c;
+				}
+			}
+
+			bool avx2 = false, avx2_f16c = false;
+		};
+		struct half_table
+		{
+			half_table()
+			{
+				for (unsigned int i = 0; i < 256; i++)
+				{
+					// Same division and rounding mode as the F16C path, so both produce identical results
+					const float value = static_cast<float>(i) / 255.0f;
+					uint32_t bits;
+					memcpy(&bits, &value, sizeof(bits));
+
+					if (i == 0)
+					{
+						values[i] = 0;
+						continue;
+					}
+
+					// All values are in [1/255, 1], which is well inside the range of normalized half-precision numbers
+					const uint32_t mantissa = bits & 0x7FFFFF;
+					const uint32_t exponent = ((bits >> 23) & 0xFF) - 127 + 15;
+					uint32_t half = (exponent << 10) | (mantissa >> 13);
+
+					const uint32_t remainder = mantissa & 0x1FFF;
+					if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0))
+					{
+						half++;
+					}
+
+					values[i] = static_cast<uint16_t>(half);
+				}
+			}
+
+			uint16_t values[256];
+		};
+
+		const cpu_features s_cpu;
+		const half_table s_half_table;
+
+		size_t extract_r_avx2(uint8_t *dst, const uint8_t *src, size_t count)
+		{
+			const __m256i mask = _mm256_set1_epi32(0xFF);
+			const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+			size_t i = 0;
+			for (; i + 32 <= count; i += 32)
+			{
+				const __m256i a0 = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4 + 0)), mask);
+				const __m256i a1 = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4 + 32)), mask);
+				const __m256i a2 = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4 + 64)), mask);
+				const __m256i a3 = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4 + 96)), mask);
+
+				// Packing works within 128-bit lanes, so the result has to be put back into order afterwards
+				const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a0, a1), _mm256_packs_epi32(a2, a3));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permutevar8x32_epi32(packed, order));
+			}
+
+			return i;
+		}
+		size_t extract_rg_avx2(uint8_t *dst, const uint8_t *src, size_t count)
+		{
+			size_t i = 0;
+			for (; i + 16 <= count; i += 16)
+			{
+				// Sign extend the low 16 bits of every texel, so that the saturating pack keeps their bit pattern intact
+				const __m256i a0 = _mm256_srai_epi32(_mm256_slli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4 + 0)), 16), 16);
+				const __m256i a1 = _mm256_srai_epi32(_mm256_slli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4 + 32)), 16), 16);
+
+				const __m256i packed = _mm256_packs_epi32(a0, a1);
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 2), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+			}
+
+			return i;
+		}
+		size_t swap_red_blue_avx2(uint8_t *dst, const uint8_t *src, size_t count, uint32_t keep_mask, uint32_t set_mask)
+		{
+			const __m256i swizzle = _mm256_setr_epi8(
+				2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+				2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+			const __m256i keep = _mm256_set1_epi32(static_cast<int>(keep_mask));
+			const __m256i set = _mm256_set1_epi32(static_cast<int>(set_mask));
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m256i texels = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4)), swizzle);
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), _mm256_or_si256(_mm256_and_si256(texels, keep), set));
+			}
+
+			return i;
+		}
+		size_t fill_alpha_avx2(uint8_t *dst, const uint8_t *src, size_t count)
+		{
+			const __m256i alpha = _mm256_set1_epi32(0xFF000000);
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m256i texels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), _mm256_or_si256(texels, alpha));
+			}
+
+			return i;
+		}
+		size_t unorm8_to_float16_f16c(uint16_t *dst, const uint8_t *src, size_t count)
+		{
+			const __m256 scale = _mm256_set1_ps(255.0f);
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m256 values = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i)))), scale);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT));
+			}
+
+			return i;
+		}
+	}
+
+	void extract_r(uint8_t *dst, const uint8_t *src, size_t count)
+	{
+		size_t i = s_cpu.avx2 ? extract_r_avx2(dst, src, count) : 0;
+
+		const __m128i mask = _mm_set1_epi32(0xFF);
+
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i a0 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4 + 0)), mask);
+			const __m128i a1 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4 + 16)), mask);
+			const __m128i a2 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4 + 32)), mask);
+			const __m128i a3 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4 + 48)), mask);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3)));
+		}
+
+		for (; i < count; i++)
+		{
+			dst[i] = src[i * 4];
+		}
+	}
+	void extract_rg(uint8_t *dst, const uint8_t *src, size_t count)
+	{
+		size_t i = s_cpu.avx2 ? extract_rg_avx2(dst, src, count) : 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			// Sign extend the low 16 bits of every texel, so that the saturating pack keeps their bit pattern intact
+			const __m128i a0 = _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4 + 0)), 16), 16);
+			const __m128i a1 = _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4 + 16)), 16), 16);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 2), _mm_packs_epi32(a0, a1));
+		}
+
+		for (; i < count; i++)
+		{
+			dst[i * 2 + 0] = src[i * 4 + 0];
+			dst[i * 2 + 1] = src[i * 4 + 1];
+		}
+	}
+	void swap_red_blue(uint8_t *dst, const uint8_t *src, size_t count, uint32_t keep_mask, uint32_t set_mask)
+	{
+		size_t i = s_cpu.avx2 ? swap_red_blue_avx2(dst, src, count, keep_mask, set_mask) : 0;
+
+		const __m128i mask_ga = _mm_set1_epi32(0xFF00FF00);
+		const __m128i mask_rb = _mm_set1_epi32(0x00FF00FF);
+		const __m128i keep = _mm_set1_epi32(static_cast<int>(keep_mask));
+		const __m128i set = _mm_set1_epi32(static_cast<int>(set_mask));
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+
+			// Swap the 16-bit halves of every texel that contain red and blue, while green and alpha stay in place
+			__m128i rb = _mm_and_si128(texels, mask_rb);
+			rb = _mm_shufflelo_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1));
+			rb = _mm_shufflehi_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1));
+
+			const __m128i swapped = _mm_or_si128(_mm_and_si128(texels, mask_ga), rb);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_or_si128(_mm_and_si128(swapped, keep), set));
+		}
+
+		for (; i < count; i++)
+		{
+			uint32_t texel;
+			memcpy(&texel, src + i * 4, 4);
+			texel = (texel & 0xFF00FF00) | ((texel & 0xFF) << 16) | ((texel >> 16) & 0xFF);
+			texel = (texel & keep_mask) | set_mask;
+			memcpy(dst + i * 4, &texel, 4);
+		}
+	}
+	void fill_alpha(uint8_t *dst, const uint8_t *src, size_t count)
+	{
+		size_t i = s_cpu.avx2 ? fill_alpha_avx2(dst, src, count) : 0;
+
+		const __m128i alpha = _mm_set1_epi32(0xFF000000);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_or_si128(texels, alpha));
+		}
+
+		for (; i < count; i++)
+		{
+			memmove(dst + i * 4, src + i * 4, 3);
+			dst[i * 4 + 3] = 0xFF;
+		}
+	}
+	void unorm8_to_float16(uint16_t *dst, const uint8_t *src, size_t count)
+	{
+		size_t i = s_cpu.avx2_f16c ? unorm8_to_float16_f16c(dst, src, count) : 0;
+
+		// There are only 256 possible inputs, so without hardware support a lookup table beats converting each value
+		for (; i < count; i++)
+		{
+			dst[i] = s_half_table.values[src[i]];
+		}
+	}
+}
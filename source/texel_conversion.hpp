@@ -0,0 +1,50 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace reshade::texel_conversion
+{
+	/// <summary>
+	/// Copy the red channel of RGBA texels into a tightly packed single channel buffer.
+	/// </summary>
+	/// <param name="dst">The buffer to store "count" bytes in.</param>
+	/// <param name="src">The RGBA texels to read.</param>
+	/// <param name="count">The number of texels.</param>
+	void extract_r(uint8_t *dst, const uint8_t *src, size_t count);
+	/// <summary>
+	/// Copy the red and green channels of RGBA texels into a tightly packed two channel buffer.
+	/// </summary>
+	/// <param name="dst">The buffer to store "count * 2" bytes in.</param>
+	/// <param name="src">The RGBA texels to read.</param>
+	/// <param name="count">The number of texels.</param>
+	void extract_rg(uint8_t *dst, const uint8_t *src, size_t count);
+	/// <summary>
+	/// Copy four channel texels while swapping the first and third channel (converting between RGBA and BGRA). The masks are applied to every texel afterwards (interpreted in memory order with the first channel in the lowest byte).
+	/// </summary>
+	/// <param name="dst">The buffer to store the texels in. This may be the same as "src".</param>
+	/// <param name="src">The texels to read.</param>
+	/// <param name="count">The number of texels.</param>
+	/// <param name="keep_mask">The bits to keep of every swizzled texel.</param>
+	/// <param name="set_mask">The bits to set in every swizzled texel.</param>
+	void swap_red_blue(uint8_t *dst, const uint8_t *src, size_t count, uint32_t keep_mask = 0xFFFFFFFF, uint32_t set_mask = 0);
+	/// <summary>
+	/// Copy four channel texels while forcing the alpha channel to be fully opaque.
+	/// </summary>
+	/// <param name="dst">The buffer to store the texels in. This may be the same as "src".</param>
+	/// <param name="src">The texels to read.</param>
+	/// <param name="count">The number of texels.</param>
+	void fill_alpha(uint8_t *dst, const uint8_t *src, size_t count);
+	/// <summary>
+	/// Convert normalized 8-bit components to 16-bit floating-point values.
+	/// </summary>
+	/// <param name="dst">The buffer to store "count" half-precision values in.</param>
+	/// <param name="src">The components to read.</param>
+	/// <param name="count">The number of components (not texels).</param>
+	void unorm8_to_float16(uint16_t *dst, const uint8_t *src, size_t count);
+}
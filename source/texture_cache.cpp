@@ -0,0 +1,142 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "texture_cache.hpp"
+#include "effect_cache.hpp"
+
+namespace reshade
+{
+	namespace
+	{
+		const uint32_t cache_magic = 0x43545352; // "RSTC"
+		const uint32_t cache_version = 3;
+
+		// The texel data directly follows this fixed-size header
+		struct cache_header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t key;
+			uint32_t width;
+			uint32_t height;
+			uint32_t source_width;
+			uint32_t source_height;
+			uint64_t size;
+		};
+	}
+
+	uint64_t texture_cache::key(const std::vector<uint8_t> &filedata, unsigned int width, unsigned int height)
+	{
+		const uint32_t dimensions[2] = { width, height };
+
+		return effect_cache::hash(filedata.data(), filedata.size(), effect_cache::hash(dimensions, sizeof(dimensions)));
+	}
+
+	void texture_cache::set_storage(std::unique_ptr<storage> storage)
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+
+		_storage = std::move(storage);
+		_index.clear();
+
+		if (_storage == nullptr)
+		{
+			return;
+		}
+
+		std::string order;
+
+		if (!_storage->read_order(order))
+		{
+			order.clear();
+		}
+
+		_index.restore(_storage->list(), order, cache_magic, cache_version);
+
+		evict();
+	}
+	void texture_cache::set_size_limit(size_t size)
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+
+		_size_limit = size;
+
+		evict();
+	}
+
+	bool texture_cache::load(uint64_t key, unsigned int width, unsigned int height, std::vector<uint8_t> &data, unsigned int &source_width, unsigned int &source_height)
+	{
+		if (_storage == nullptr)
+		{
+			return false;
+		}
+
+		cache_header header = { };
+		const size_t size = static_cast<size_t>(width) * height * 4;
+
+		data.resize(size);
+
+		if (!_storage->read(key, &header, sizeof(header), data.data(), size) ||
+			header.magic != cache_magic || header.version != cache_version || header.key != key ||
+			header.width != width || header.height != height || header.size != size)
+		{
+			// Let the next save replace a missing, truncated or otherwise unusable entry instead of counting it towards the size limit until then
+			{ const std::lock_guard<std::mutex> lock(_mutex);
+				_index.forget(key);
+			}
+
+			_misses++;
+			return false;
+		}
+
+		source_width = header.source_width;
+		source_height = header.source_height;
+
+		{ const std::lock_guard<std::mutex> lock(_mutex);
+			_index.insert(key, sizeof(header) + size);
+		}
+
+		_hits++;
+
+		return true;
+	}
+	void texture_cache::save(uint64_t key, unsigned int width, unsigned int height, unsigned int source_width, unsigned int source_height, const std::vector<uint8_t> &data)
+	{
+		if (_storage == nullptr)
+		{
+			return;
+		}
+
+		const cache_header header = { cache_magic, cache_version, key, width, height, source_width, source_height, data.size() };
+
+		if (!_storage->write(key, &header, sizeof(header), data.data(), data.size()))
+		{
+			return;
+		}
+
+		{ const std::lock_guard<std::mutex> lock(_mutex);
+			_index.insert(key, sizeof(header) + data.size());
+			evict();
+		}
+	}
+	void texture_cache::flush()
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+
+		if (_storage == nullptr || !_index.is_order_modified())
+		{
+			return;
+		}
+
+		_storage->write_order(_index.save_order(cache_magic, cache_version));
+	}
+
+	void texture_cache::evict()
+	{
+		_index.evict(_size_limit, [this](uint64_t key) {
+			_storage->remove(key);
+		});
+	}
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include "cache_index.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// A persistent cache of decoded and resized texture images with a bounded size. Entries are keyed by the contents of the source image file, so they never go stale. Least recently used entries are evicted first.
+	/// </summary>
+	class texture_cache
+	{
+	public:
+		/// <summary>
+		/// The place cache entries are persisted in. Every entry is a fixed-size header followed by the image data, so that the image data can be read straight into the buffer it is uploaded from.
+		/// Entries are read and written from worker threads, also concurrently for the same key, so an entry has to be replaced as a whole.
+		/// </summary>
+		class storage
+		{
+		public:
+			virtual ~storage() = default;
+
+			/// <summary>
+			/// Get the keys and sizes in bytes of all entries that are currently stored.
+			/// </summary>
+			virtual std::vector<std::pair<uint64_t, size_t>> list() = 0;
+			/// <summary>
+			/// Read the header and image data of an entry.
+			/// </summary>
+			/// <param name="key">The key of the entry.</param>
+			/// <param name="header">The buffer to store the header in.</param>
+			/// <param name="header_size">The size of the header in bytes.</param>
+			/// <param name="data">The buffer to store the image data in.</param>
+			/// <param name="size">The size of the image data in bytes.</param>
+			/// <returns>A boolean value indicating whether the entry exists and both could be read in full.</returns>
+			virtual bool read(uint64_t key, void *header, size_t header_size, void *data, size_t size) = 0;
+			/// <summary>
+			/// Create or replace an entry.
+			/// </summary>
+			/// <param name="key">The key of the entry.</param>
+			/// <param name="header">The header to store.</param>
+			/// <param name="header_size">The size of the header in bytes.</param>
+			/// <param name="data">The image data to store after the header.</param>
+			/// <param name="size">The size of the image data in bytes.</param>
+			/// <returns>A boolean value indicating whether the entry was written.</returns>
+			virtual bool write(uint64_t key, const void *header, size_t header_size, const void *data, size_t size) = 0;
+			/// <summary>
+			/// Delete an entry.
+			/// </summary>
+			virtual void remove(uint64_t key) = 0;
+			/// <summary>
+			/// Read the usage order saved by a previous call to <see cref="write_order"/>.
+			/// </summary>
+			virtual bool read_order(std::string &data) = 0;
+			/// <summary>
+			/// Save the usage order of the entries.
+			/// </summary>
+			virtual void write_order(const std::string &data) = 0;
+		};
+
+		/// <summary>
+		/// Calculate the key identifying the image data of a texture.
+		/// </summary>
+		/// <param name="filedata">The contents of the source image file.</param>
+		/// <param name="width">The width the image is resized to.</param>
+		/// <param name="height">The height the image is resized to.</param>
+		static uint64_t key(const std::vector<uint8_t> &filedata, unsigned int width, unsigned int height);
+
+		/// <summary>
+		/// Set the storage that cache entries are kept in and pick up any entries from previous runs. A <c>nullptr</c> disables the cache.
+		/// </summary>
+		/// <param name="storage">The storage to use.</param>
+		void set_storage(std::unique_ptr<storage> storage);
+		/// <summary>
+		/// Set the maximum total size of all cache entries.
+		/// </summary>
+		/// <param name="size">The size limit in bytes.</param>
+		void set_size_limit(size_t size);
+
+		/// <summary>
+		/// Look up the image data of a texture. This is safe to call from worker threads.
+		/// </summary>
+		/// <param name="key">The key of the image.</param>
+		/// <param name="width">The width of the image.</param>
+		/// <param name="height">The height of the image.</param>
+		/// <param name="data">The buffer to store the 32bpp RGBA image data in.</param>
+		/// <param name="source_width">Set to the width of the source image file before it was resized.</param>
+		/// <param name="source_height">Set to the height of the source image file before it was resized.</param>
+		/// <returns>A boolean value indicating whether a cache entry was found.</returns>
+		bool load(uint64_t key, unsigned int width, unsigned int height, std::vector<uint8_t> &data, unsigned int &source_width, unsigned int &source_height);
+		/// <summary>
+		/// Store the image data of a texture and evict old entries if the size limit is exceeded. This is safe to call from worker threads.
+		/// </summary>
+		/// <param name="key">The key of the image.</param>
+		/// <param name="width">The width of the image.</param>
+		/// <param name="height">The height of the image.</param>
+		/// <param name="source_width">The width of the source image file before it was resized.</param>
+		/// <param name="source_height">The height of the source image file before it was resized.</param>
+		/// <param name="data">The 32bpp RGBA image data to store.</param>
+		void save(uint64_t key, unsigned int width, unsigned int height, unsigned int source_width, unsigned int source_height, const std::vector<uint8_t> &data);
+		/// <summary>
+		/// Write the current usage order to the storage, so that the next run evicts entries in the right order.
+		/// </summary>
+		void flush();
+
+		/// <summary>
+		/// Returns the number of lookups that found an entry since statistics were last reset.
+		/// </summary>
+		size_t hits() const { return _hits; }
+		/// <summary>
+		/// Returns the number of lookups that did not find an entry since statistics were last reset.
+		/// </summary>
+		size_t misses() const { return _misses; }
+		/// <summary>
+		/// Reset the hit and miss counters.
+		/// </summary>
+		void reset_statistics() { _hits = _misses = 0; }
+
+	private:
+		void evict();
+
+		std::unique_ptr<storage> _storage;
+		std::atomic<size_t> _hits = 0, _misses = 0;
+		std::mutex _mutex;
+		size_t _size_limit = 1024 * 1024 * 1024;
+		cache_index _index;
+	};
+}
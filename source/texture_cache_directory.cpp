@@ -0,0 +1,123 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "log.hpp"
+#include "texture_cache_directory.hpp"
+#include <thread>
+#include <fstream>
+#include <sstream>
+
+namespace reshade
+{
+	namespace
+	{
+		const char *const order_filename = "textures.lru";
+	}
+
+	std::vector<std::pair<uint64_t, size_t>> texture_cache_directory::list()
+	{
+		std::vector<std::pair<uint64_t, size_t>> entries;
+
+		for (const auto &file_path : filesystem::list_files(_path, "*.tex"))
+		{
+			const std::string name = file_path.filename_without_extension().string();
+			std::ifstream file(file_path.wstring(), std::ios::in | std::ios::binary | std::ios::ate);
+
+			if (name.size() != 16 || !file.is_open())
+			{
+				continue;
+			}
+
+			entries.emplace_back(std::strtoull(name.c_str(), nullptr, 16), static_cast<size_t>(file.tellg()));
+		}
+
+		return entries;
+	}
+	bool texture_cache_directory::read(uint64_t key, void *header, size_t header_size, void *data, size_t size)
+	{
+		std::ifstream file(entry_path(key).wstring(), std::ios::in | std::ios::binary);
+
+		return
+			file.read(static_cast<char *>(header), header_size) &&
+			file.read(static_cast<char *>(data), size);
+	}
+	bool texture_cache_directory::write(uint64_t key, const void *header, size_t header_size, const void *data, size_t size)
+	{
+		if (!create_directory())
+		{
+			return false;
+		}
+
+		// Write to a file unique to this thread first, so that concurrent reads never see a partially written entry
+		std::stringstream temp_filename;
+		temp_filename << std::hex << key << '.' << std::this_thread::get_id() << ".tmp";
+		const filesystem::path temp_path = _path / temp_filename.str();
+
+		{ std::ofstream file(temp_path.wstring(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+			if (!file.write(static_cast<const char *>(header), header_size) ||
+				!file.write(static_cast<const char *>(data), size))
+			{
+				file.close();
+				filesystem::remove(temp_path);
+				return false;
+			}
+		}
+
+		if (!filesystem::rename(temp_path, entry_path(key)))
+		{
+			filesystem::remove(temp_path);
+			return false;
+		}
+
+		return true;
+	}
+	void texture_cache_directory::remove(uint64_t key)
+	{
+		filesystem::remove(entry_path(key));
+	}
+	bool texture_cache_directory::read_order(std::string &data)
+	{
+		std::ifstream file((_path / order_filename).wstring(), std::ios::in | std::ios::binary);
+
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		data.assign(std::istreambuf_iterator<char>(file.rdbuf()), std::istreambuf_iterator<char>());
+
+		return true;
+	}
+	void texture_cache_directory::write_order(const std::string &data)
+	{
+		if (!create_directory())
+		{
+			return;
+		}
+
+		std::ofstream file((_path / order_filename).wstring(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+		file.write(data.data(), data.size());
+	}
+
+	filesystem::path texture_cache_directory::entry_path(uint64_t key) const
+	{
+		char name[21];
+		sprintf_s(name, "%016llx.tex", key);
+
+		return _path / name;
+	}
+	bool texture_cache_directory::create_directory() const
+	{
+		if (!filesystem::exists(_path) && !filesystem::create_directory(_path))
+		{
+			LOG(WARNING) << "Failed to create texture cache directory " << _path << ".";
+			return false;
+		}
+
+		return true;
+	}
+}
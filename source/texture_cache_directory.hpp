@@ -0,0 +1,38 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "texture_cache.hpp"
+#include "filesystem.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// Stores texture cache entries as files in a directory on disk.
+	/// </summary>
+	class texture_cache_directory : public texture_cache::storage
+	{
+	public:
+		/// <summary>
+		/// Construct a new storage in the specified directory. The directory is only created once the first entry is written.
+		/// </summary>
+		/// <param name="path">The path to the cache directory.</param>
+		explicit texture_cache_directory(const filesystem::path &path) : _path(path) { }
+
+		std::vector<std::pair<uint64_t, size_t>> list() override;
+		bool read(uint64_t key, void *header, size_t header_size, void *data, size_t size) override;
+		bool write(uint64_t key, const void *header, size_t header_size, const void *data, size_t size) override;
+		void remove(uint64_t key) override;
+		bool read_order(std::string &data) override;
+		void write_order(const std::string &data) override;
+
+	private:
+		filesystem::path entry_path(uint64_t key) const;
+		bool create_directory() const;
+
+		filesystem::path _path;
+	};
+}
@@ -0,0 +1,115 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "uniform_layout.hpp"
+#include <assert.h>
+#include <algorithm>
+
+namespace reshade
+{
+	namespace
+	{
+		inline size_t roundto16(size_t size)
+		{
+			return (size + 15) & ~15;
+		}
+	}
+
+	size_t uniform_layout::add(unsigned int vector_size, unsigned int vector_count, unsigned int elements)
+	{
+		assert(vector_size >= 1 && vector_size <= 4 && vector_count >= 1);
+
+		member info;
+		info.data_size = vector_size * vector_count * std::max(1u, elements) * 4;
+		info.is_aggregate = elements != 0 || vector_count > 1;
+		info.offset = 0;
+
+		if (!info.is_aggregate)
+		{
+			info.footprint = _rules == packing_rules::d3d9_registers ? 16 : vector_size * 4;
+		}
+		else
+		{
+			const size_t registers = vector_count * std::max(1u, elements);
+
+			// Every vector of an array or matrix starts on a new register, only HLSL lets the next member use the remainder of the last one
+			info.footprint = _rules == packing_rules::hlsl_cbuffer ? (registers - 1) * 16 + vector_size * 4 : registers * 16;
+		}
+
+		_members.push_back(info);
+
+		return _members.size() - 1;
+	}
+
+	void uniform_layout::pack()
+	{
+		struct register_slot
+		{
+			size_t offset, used;
+		};
+
+		std::vector<register_slot> slots;
+		std::vector<size_t> vectors;
+
+		_size = _data_size = 0;
+
+		// Arrays and matrices always start on a register boundary, so place them first in declaration order
+		for (size_t i = 0; i < _members.size(); i++)
+		{
+			member &info = _members[i];
+
+			_data_size += info.data_size;
+
+			if (!info.is_aggregate)
+			{
+				vectors.push_back(i);
+				continue;
+			}
+
+			info.offset = _size;
+			_size = roundto16(info.offset + info.footprint);
+
+			if ((info.offset + info.footprint) % 16 != 0)
+			{
+				slots.push_back({ _size - 16, (info.offset + info.footprint) % 16 });
+			}
+		}
+
+		// Then fill registers with the remaining scalars and vectors, largest first (first-fit decreasing)
+		// Filling each register in decreasing size order also keeps every vector aligned to its size as std140 requires
+		std::stable_sort(vectors.begin(), vectors.end(), [this](size_t lhs, size_t rhs) { return _members[lhs].footprint > _members[rhs].footprint; });
+
+		for (size_t i : vectors)
+		{
+			member &info = _members[i];
+
+			const auto slot = std::find_if(slots.begin(), slots.end(), [&info](const register_slot &slot) { return slot.used + info.footprint <= 16; });
+
+			if (slot != slots.end())
+			{
+				info.offset = slot->offset + slot->used;
+				slot->used += info.footprint;
+			}
+			else
+			{
+				info.offset = _size;
+				_size += 16;
+
+				slots.push_back({ info.offset, info.footprint });
+			}
+
+			assert(_rules != packing_rules::std140 || info.offset % (info.footprint == 12 ? 16 : info.footprint) == 0);
+		}
+
+		_order.resize(_members.size());
+
+		for (size_t i = 0; i < _order.size(); i++)
+		{
+			_order[i] = i;
+		}
+
+		std::stable_sort(_order.begin(), _order.end(), [this](size_t lhs, size_t rhs) { return _members[lhs].offset < _members[rhs].offset; });
+	}
+}
@@ -0,0 +1,81 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+
+namespace reshade
+{
+	/// <summary>
+	/// Assigns offsets to the uniforms of an effect so that they fit into as little buffer space as possible under the packing rules of a shading language.
+	/// </summary>
+	class uniform_layout
+	{
+	public:
+		enum class packing_rules
+		{
+			/// <summary>
+			/// HLSL constant buffer packing. Vectors may not straddle a 16 byte register, arrays and matrices start on a new register and following members can use the rest of their last register.
+			/// </summary>
+			hlsl_cbuffer,
+			/// <summary>
+			/// GLSL std140 packing. Vectors are aligned to their size (three-component vectors to 16 bytes), arrays and matrices start on a 16 byte boundary and are padded to a multiple of it.
+			/// </summary>
+			std140,
+			/// <summary>
+			/// Direct3D 9 constant registers. Every member starts on a new 16 byte register.
+			/// </summary>
+			d3d9_registers
+		};
+
+		explicit uniform_layout(packing_rules rules) : _rules(rules) { }
+
+		/// <summary>
+		/// Add a uniform to the layout. All components are expected to be four bytes in size.
+		/// </summary>
+		/// <param name="vector_size">The number of components in each vector (or each matrix column/row, whichever the shading language stores contiguously).</param>
+		/// <param name="vector_count">The number of vectors in each element (greater than one for matrices).</param>
+		/// <param name="elements">The number of array elements, or zero if this is not an array.</param>
+		/// <returns>The index used to refer to this uniform in the layout.</returns>
+		size_t add(unsigned int vector_size, unsigned int vector_count, unsigned int elements);
+		/// <summary>
+		/// Assign offsets to all uniforms added so far. Uniforms are reordered to fill the gaps alignment would otherwise leave behind.
+		/// </summary>
+		void pack();
+
+		/// <summary>
+		/// Returns the byte offset assigned to a uniform by the last call to pack().
+		/// </summary>
+		/// <param name="index">The index returned when the uniform was added.</param>
+		size_t offset(size_t index) const { return _members[index].offset; }
+		/// <summary>
+		/// Returns the indices of all uniforms sorted by ascending offset, which is the order they have to be declared in.
+		/// </summary>
+		const std::vector<size_t> &order() const { return _order; }
+		/// <summary>
+		/// Returns the total size of the layout in bytes, rounded up to a multiple of 16.
+		/// </summary>
+		size_t size() const { return _size; }
+		/// <summary>
+		/// Returns the number of bytes in the layout that do not hold any uniform data.
+		/// </summary>
+		size_t padding() const { return _size - _data_size; }
+
+	private:
+		struct member
+		{
+			size_t data_size, footprint;
+			bool is_aggregate;
+			size_t offset;
+		};
+
+		packing_rules _rules;
+		std::vector<member> _members;
+		std::vector<size_t> _order;
+		size_t _size = 0, _data_size = 0;
+	};
+}
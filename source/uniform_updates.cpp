@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "uniform_updates.hpp"
+
+namespace reshade
+{
+	bool resolve_uniform_update(const uniform &variable, size_t index, uniform_update &update)
+	{
+		const auto &annotations = variable.annotations;
+
+		const auto source_it = annotations.find("source");
+
+		if (source_it == annotations.end())
+		{
+			return false;
+		}
+
+		// Look up annotations without inserting empty ones, missing annotations evaluate to zero just like empty ones
+		const auto annotation = [&annotations](const char *name) {
+			const auto it = annotations.find(name);
+			return it != annotations.end() ? it->second : variant();
+		};
+
+		const auto source = source_it->second.as<std::string>();
+
+		update = uniform_update();
+		update.uniform_index = index;
+
+		if (source == "frametime")
+		{
+			update.source = uniform_source::frametime;
+		}
+		else if (source == "framecount")
+		{
+			update.source = uniform_source::framecount;
+		}
+		else if (source == "pingpong")
+		{
+			const auto step = annotation("step");
+
+			update.source = uniform_source::pingpong;
+			update.min = annotation("min").as<float>();
+			update.max = annotation("max").as<float>();
+			update.step_min = step.as<float>(0);
+			update.step_max = step.as<float>(1);
+			update.smoothing = annotation("smoothing").as<float>();
+		}
+		else if (source == "date")
+		{
+			update.source = uniform_source::date;
+		}
+		else if (source == "timer")
+		{
+			update.source = uniform_source::timer;
+		}
+		else if (source == "key")
+		{
+			update.keycode = annotation("keycode").as<int>();
+
+			if (update.keycode <= 7 || update.keycode >= 256)
+			{
+				return false;
+			}
+
+			const auto mode = annotation("mode").as<std::string>();
+
+			if (mode == "toggle" || annotation("toggle").as<bool>())
+			{
+				update.source = uniform_source::key_toggle;
+			}
+			else if (mode == "press")
+			{
+				update.source = uniform_source::key_press;
+			}
+			else
+			{
+				update.source = uniform_source::key_down;
+			}
+		}
+		else if (source == "mousepoint")
+		{
+			update.source = uniform_source::mousepoint;
+		}
+		else if (source == "mousebutton")
+		{
+			update.keycode = annotation("keycode").as<int>();
+
+			if (update.keycode < 0 || update.keycode >= 5)
+			{
+				return false;
+			}
+
+			update.source = annotation("toggle").as<bool>() ? uniform_source::mousebutton_toggle : uniform_source::mousebutton_down;
+		}
+		else if (source == "random")
+		{
+			update.source = uniform_source::random;
+			update.random_min = annotation("min").as<int>();
+			update.random_max = annotation("max").as<int>();
+		}
+		else
+		{
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,235 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include "input.hpp"
+#include "runtime_objects.hpp"
+
+namespace reshade
+{
+	enum class uniform_source
+	{
+		frametime,
+		framecount,
+		pingpong,
+		date,
+		timer,
+		key_down,
+		key_press,
+		key_toggle,
+		mousepoint,
+		mousebutton_down,
+		mousebutton_toggle,
+		random
+	};
+
+	/// <summary>
+	/// A uniform variable with a "source" annotation, resolved once when its effect is loaded so that updating it every frame does not have to look at the annotations again.
+	/// </summary>
+	struct uniform_update
+	{
+		uniform_source source;
+		size_t uniform_index;
+		int keycode = 0;
+		int random_min = 0, random_max = 0;
+		float min = 0, max = 0, step_min = 0, step_max = 0, smoothing = 0;
+	};
+
+	/// <summary>
+	/// The values of the current frame that uniform variables can be bound to.
+	/// </summary>
+	struct uniform_update_state
+	{
+		std::chrono::high_resolution_clock::duration frame_duration, elapsed_time;
+		unsigned long long framecount;
+		const int *date;
+		const reshade::input *input;
+	};
+
+	/// <summary>
+	/// Resolve the "source" annotation of a uniform variable and the annotations that configure it.
+	/// </summary>
+	/// <param name="variable">The uniform variable to look at.</param>
+	/// <param name="index">The index of the variable in the list of uniforms of the runtime.</param>
+	/// <param name="update">The resolved update.</param>
+	/// <returns><c>true</c> if the variable has a valid source, <c>false</c> otherwise.</returns>
+	bool resolve_uniform_update(const uniform &variable, size_t index, uniform_update &update);
+
+	/// <summary>
+	/// Write the current value of their source to a list of uniform variables.
+	/// </summary>
+	/// <param name="runtime">The object owning the uniform storage, which has to provide the "get_uniform_value" and "set_uniform_value" overloads of <see cref="runtime"/>.</param>
+	/// <param name="uniforms">The list of uniform variables the updates index into.</param>
+	/// <param name="updates">The updates resolved with <see cref="resolve_uniform_update"/>.</param>
+	/// <param name="frame">The values of the current frame.</param>
+	template <typename T>
+	void apply_uniform_updates(T &runtime, std::vector<uniform> &uniforms, const std::vector<uniform_update> &updates, const uniform_update_state &frame)
+	{
+		for (const auto &update : updates)
+		{
+			auto &variable = uniforms[update.uniform_index];
+
+			switch (update.source)
+			{
+				case uniform_source::frametime:
+				{
+					const float value = frame.frame_duration.count() * 1e-6f;
+					runtime.set_uniform_value(variable, &value, 1);
+					break;
+				}
+				case uniform_source::framecount:
+				{
+					switch (variable.basetype)
+					{
+						case uniform_datatype::boolean:
+						{
+							const bool even = (frame.framecount % 2) == 0;
+							runtime.set_uniform_value(variable, &even, 1);
+							break;
+						}
+						case uniform_datatype::signed_integer:
+						case uniform_datatype::unsigned_integer:
+						{
+							const unsigned int framecount = static_cast<unsigned int>(frame.framecount % UINT_MAX);
+							runtime.set_uniform_value(variable, &framecount, 1);
+							break;
+						}
+						case uniform_datatype::floating_point:
+						{
+							const float framecount = static_cast<float>(frame.framecount % 16777216);
+							runtime.set_uniform_value(variable, &framecount, 1);
+							break;
+						}
+					}
+					break;
+				}
+				case uniform_source::pingpong:
+				{
+					float value[2] = { 0, 0 };
+					runtime.get_uniform_value(variable, value, 2);
+
+					float increment = update.step_max == 0 ? update.step_min : (update.step_min + std::fmodf(static_cast<float>(std::rand()), update.step_max - update.step_min + 1));
+
+					if (value[1] >= 0)
+					{
+						increment = std::max(increment - std::max(0.0f, update.smoothing - (update.max - value[0])), 0.05f);
+						increment *= frame.frame_duration.count() * 1e-9f;
+
+						if ((value[0] += increment) >= update.max)
+						{
+							value[0] = update.max;
+							value[1] = -1;
+						}
+					}
+					else
+					{
+						increment = std::max(increment - std::max(0.0f, update.smoothing - (value[0] - update.min)), 0.05f);
+						increment *= frame.frame_duration.count() * 1e-9f;
+
+						if ((value[0] -= increment) <= update.min)
+						{
+							value[0] = update.min;
+							value[1] = +1;
+						}
+					}
+
+					runtime.set_uniform_value(variable, value, 2);
+					break;
+				}
+				case uniform_source::date:
+				{
+					runtime.set_uniform_value(variable, frame.date, 4);
+					break;
+				}
+				case uniform_source::timer:
+				{
+					const unsigned long long timer = std::chrono::duration_cast<std::chrono::nanoseconds>(frame.elapsed_time).count();
+
+					switch (variable.basetype)
+					{
+						case uniform_datatype::boolean:
+						{
+							const bool even = (timer % 2) == 0;
+							runtime.set_uniform_value(variable, &even, 1);
+							break;
+						}
+						case uniform_datatype::signed_integer:
+						case uniform_datatype::unsigned_integer:
+						{
+							const unsigned int timer_int = static_cast<unsigned int>(timer % UINT_MAX);
+							runtime.set_uniform_value(variable, &timer_int, 1);
+							break;
+						}
+						case uniform_datatype::floating_point:
+						{
+							const float timer_float = std::fmod(static_cast<float>(timer * 1e-6f), 16777216.0f);
+							runtime.set_uniform_value(variable, &timer_float, 1);
+							break;
+						}
+					}
+					break;
+				}
+				case uniform_source::key_down:
+				{
+					const bool state = frame.input->is_key_down(update.keycode);
+					runtime.set_uniform_value(variable, &state, 1);
+					break;
+				}
+				case uniform_source::key_press:
+				{
+					const bool state = frame.input->is_key_pressed(update.keycode);
+					runtime.set_uniform_value(variable, &state, 1);
+					break;
+				}
+				case uniform_source::key_toggle:
+				{
+					if (frame.input->is_key_pressed(update.keycode))
+					{
+						bool current = false;
+						runtime.get_uniform_value(variable, &current, 1);
+						current = !current;
+						runtime.set_uniform_value(variable, &current, 1);
+					}
+					break;
+				}
+				case uniform_source::mousepoint:
+				{
+					const float values[2] = { static_cast<float>(frame.input->mouse_position_x()), static_cast<float>(frame.input->mouse_position_y()) };
+					runtime.set_uniform_value(variable, values, 2);
+					break;
+				}
+				case uniform_source::mousebutton_down:
+				{
+					const bool state = frame.input->is_mouse_button_down(update.keycode);
+					runtime.set_uniform_value(variable, &state, 1);
+					break;
+				}
+				case uniform_source::mousebutton_toggle:
+				{
+					if (frame.input->is_mouse_button_pressed(update.keycode))
+					{
+						bool current = false;
+						runtime.get_uniform_value(variable, &current, 1);
+						current = !current;
+						runtime.set_uniform_value(variable, &current, 1);
+					}
+					break;
+				}
+				case uniform_source::random:
+				{
+					const int value = update.random_min + (std::rand() % (update.random_max - update.random_min + 1));
+					runtime.set_uniform_value(variable, &value, 1);
+					break;
+				}
+			}
+		}
+	}
+}
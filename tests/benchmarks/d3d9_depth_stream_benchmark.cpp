@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Measures what attributing a draw call to the current depth stencil surface costs the Direct3D 9 runtime, replaying a stream of draw calls and depth stencil changes through depth_stencil_tracker.
+// Surfaces and the device are stand-ins with a virtual call and an atomic reference count per query, like COM objects.
+// Caching the surface when the application sets it is compared to forgetting it before every draw, which makes the tracker ask the device and search the table each time like the runtime used to.
+//
+// cl /std:c++17 /O2 /EHsc /I source\d3d9 tests\benchmarks\d3d9_depth_stream_benchmark.cpp
+
+#include "d3d9_depth_tracker.hpp"
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <string>
+#include <algorithm>
+
+using namespace reshade::d3d9;
+
+struct surface
+{
+	virtual unsigned long AddRef() { return ++ref; }
+	virtual unsigned long Release() { return --ref; }
+
+	std::atomic<unsigned long> ref = 1;
+	unsigned int width = 1920, height = 1080;
+};
+
+struct device
+{
+	virtual void GetDepthStencilSurface(surface **depthstencil)
+	{
+		*depthstencil = current;
+
+		if (current != nullptr)
+		{
+			current->AddRef();
+		}
+	}
+
+	surface *current = nullptr;
+};
+
+struct stream_event
+{
+	bool is_set_depthstencil;
+	unsigned int index; // Index of the surface for depth stencil changes, number of vertices for draw calls
+};
+
+int main(int argc, char *argv[])
+{
+	const unsigned int frames = argc > 1 ? std::stoul(argv[1]) : 100;
+	const unsigned int runs = argc > 2 ? std::stoul(argv[2]) : 20;
+
+	// Six surfaces, the last two of which are smaller than the back buffer (like shadow maps) and therefore rejected
+	std::vector<surface> surfaces(6);
+	surfaces[4].width = surfaces[4].height = surfaces[5].width = surfaces[5].height = 1024;
+
+	// Every frame switches the depth stencil surface 30 times and issues 100 draw calls in between
+	std::vector<stream_event> stream;
+	std::mt19937 random(1);
+	size_t draws = 0;
+
+	for (unsigned int frame = 0; frame < frames; ++frame)
+	{
+		for (unsigned int pass = 0; pass < 30; ++pass)
+		{
+			stream.push_back({ true, static_cast<unsigned int>(random() % 6) });
+
+			for (unsigned int draw = 0; draw < 100; ++draw, ++draws)
+			{
+				stream.push_back({ false, static_cast<unsigned int>(random() % 3000) });
+			}
+		}
+	}
+
+	device device;
+
+	const auto track = [](surface *depthstencil, depth_source_info &info) {
+		// Early rejection
+		if (depthstencil->width != 1920 || depthstencil->height != 1080)
+		{
+			return false;
+		}
+
+		info.width = depthstencil->width;
+		info.height = depthstencil->height;
+
+		return true;
+	};
+	const auto query = [&device]() {
+		surface *depthstencil = nullptr;
+		device.GetDepthStencilSurface(&depthstencil);
+
+		if (depthstencil != nullptr)
+		{
+			depthstencil->Release();
+		}
+
+		return depthstencil;
+	};
+
+	const auto replay = [&](depth_stencil_tracker<surface> &tracker, bool query_every_draw) {
+		unsigned int drawcalls = 0;
+
+		for (const auto &event : stream)
+		{
+			if (event.is_set_depthstencil)
+			{
+				tracker.set_current(&surfaces[event.index], track);
+				device.current = &surfaces[event.index];
+				continue;
+			}
+
+			if (query_every_draw)
+			{
+				tracker.reset_current();
+			}
+
+			tracker.on_draw_call(++drawcalls, event.index, query);
+		}
+	};
+
+	// Both have to attribute every draw call to the same surface
+	depth_stencil_tracker<surface> cached_tracker, queried_tracker;
+	replay(cached_tracker, false);
+	replay(queried_tracker, true);
+
+	for (auto &surface : surfaces)
+	{
+		const auto cached = cached_tracker.sources().find(&surface);
+		const auto queried = queried_tracker.sources().find(&surface);
+
+		if ((cached == cached_tracker.sources().end()) != (queried == queried_tracker.sources().end()) ||
+			(cached != cached_tracker.sources().end() && (cached->second.drawcall_count != queried->second.drawcall_count || cached->second.vertices_count != queried->second.vertices_count)))
+		{
+			std::printf("caching the current surface changes the draw call statistics\n");
+			return 1;
+		}
+	}
+
+	const auto measure = [runs, draws](const auto &replay) {
+		std::vector<double> timings;
+
+		for (unsigned int run = 0; run < runs; ++run)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+
+			replay();
+
+			timings.push_back(std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / draws);
+		}
+
+		std::sort(timings.begin(), timings.end());
+
+		return std::make_pair(timings.front(), timings[timings.size() / 2]);
+	};
+
+	const auto query_every_draw = measure([&]() { replay(queried_tracker, true); });
+	const auto cached_on_set = measure([&]() { replay(cached_tracker, false); });
+
+	std::printf("%zu draw calls in %u frames, %u runs each\n", draws, frames, runs);
+	std::printf("query every draw: min %.2f ns, median %.2f ns per draw\n", query_every_draw.first, query_every_draw.second);
+	std::printf("cached on set: min %.2f ns, median %.2f ns per draw\n", cached_on_set.first, cached_on_set.second);
+}
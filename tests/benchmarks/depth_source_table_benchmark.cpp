@@ -0,0 +1,152 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Measures the per-draw cost of the draw call statistics of the Direct3D 11 runtime, with one thread drawing and with four drawing at once.
+// The old path took the runtime mutex, asked the context for its bound depth stencil view and searched a map for it, so every thread serialized on the lock.
+// The new path reads the entry of the view the context wrapper remembered from depth_source_table and updates its atomic counters. The context query here is only a virtual call and a reference count, cheaper than the driver's.
+//
+// cl /std:c++17 /O2 /EHsc /I source tests\benchmarks\depth_source_table_benchmark.cpp
+
+#include "depth_source_table.hpp"
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+
+struct alignas(16) depth_stencil_view
+{
+	virtual unsigned long AddRef() { return ++ref; }
+	virtual unsigned long Release() { return --ref; }
+
+	std::atomic<unsigned long> ref = 1;
+};
+
+struct device_context
+{
+	virtual void OMGetRenderTargets(depth_stencil_view **depthstencil)
+	{
+		*depthstencil = bound;
+		bound->AddRef();
+	}
+
+	depth_stencil_view *bound = nullptr;
+};
+
+struct locked_tracker
+{
+	struct info
+	{
+		unsigned int width, height, drawcall_count, vertices_count;
+	};
+
+	void on_draw(device_context *context, unsigned int vertices)
+	{
+		const std::lock_guard<std::mutex> lock(mutex);
+
+		drawcalls++;
+
+		depth_stencil_view *depthstencil = nullptr;
+		context->OMGetRenderTargets(&depthstencil);
+
+		const auto it = table.find(depthstencil);
+
+		if (it != table.end())
+		{
+			it->second.drawcall_count = drawcalls;
+			it->second.vertices_count += vertices;
+		}
+
+		depthstencil->Release();
+	}
+
+	std::mutex mutex;
+	std::unordered_map<depth_stencil_view *, info> table;
+	unsigned int drawcalls = 0;
+};
+
+struct lock_free_tracker
+{
+	void on_draw(depth_stencil_view *depthstencil, unsigned int vertices, unsigned int drawcall_index)
+	{
+		const auto info = table.find(depthstencil);
+
+		if (info != nullptr && !info->rejected)
+		{
+			info->drawcall_count.store(drawcall_index, std::memory_order_relaxed);
+			info->vertices_count.fetch_add(vertices, std::memory_order_relaxed);
+		}
+	}
+
+	reshade::depth_source_table<depth_stencil_view> table;
+};
+
+int main(int argc, char *argv[])
+{
+	const unsigned int draws = argc > 1 ? std::stoul(argv[1]) : 2000000;
+	const unsigned int view_count = argc > 2 ? std::stoul(argv[2]) : 40;
+	const unsigned int runs = argc > 3 ? std::stoul(argv[3]) : 5;
+
+	std::vector<depth_stencil_view> views(view_count);
+	locked_tracker locked;
+	lock_free_tracker lock_free;
+
+	for (unsigned int i = 0; i < view_count; ++i)
+	{
+		locked.table[&views[i]] = { 1920, 1080, 0, 0 };
+		lock_free.table.insert(&views[i], 1920, 1080, i % 3 == 0);
+	}
+
+	for (unsigned int threads : { 1u, 4u })
+	{
+		const auto measure = [threads, draws, runs](const auto &draw) {
+			std::vector<double> timings;
+
+			for (unsigned int run = 0; run < runs; ++run)
+			{
+				const auto start = std::chrono::high_resolution_clock::now();
+
+				std::vector<std::thread> workers;
+
+				for (unsigned int t = 0; t < threads; ++t)
+				{
+					workers.emplace_back([&draw, t, draws]() { draw(t, draws); });
+				}
+				for (auto &worker : workers)
+				{
+					worker.join();
+				}
+
+				timings.push_back(std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (double(draws) * threads));
+			}
+
+			std::sort(timings.begin(), timings.end());
+
+			return std::make_pair(timings.front(), timings[timings.size() / 2]);
+		};
+
+		// Applications usually issue a batch of draws to the same depth stencil view before switching to the next
+		const auto locked_timing = measure([&](unsigned int t, unsigned int count) {
+			device_context context;
+
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				context.bound = &views[(i / 64 + t) % view_count];
+				locked.on_draw(&context, 36);
+			}
+		});
+		const auto lock_free_timing = measure([&](unsigned int t, unsigned int count) {
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				lock_free.on_draw(&views[(i / 64 + t) % view_count], 36, i + 1);
+			}
+		});
+
+		std::printf("%u thread(s), %u views: locked min %.1f ns, median %.1f ns per draw | lock-free min %.1f ns, median %.1f ns per draw\n", threads, view_count,
+			locked_timing.first, locked_timing.second, lock_free_timing.first, lock_free_timing.second);
+	}
+}
@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Measures how long it takes to match the exports of a module like opengl32.dll against the exports of ReShade when installing hooks.
+// Compares match_exports with searching all replacement exports for every target export, once with sorted export lists (like PE export name tables) and once with shuffled ones.
+//
+// cl /std:c++17 /O2 /EHsc /I source tests\benchmarks\hook_exports_benchmark.cpp source\hook_exports.cpp
+
+#include "hook_exports.hpp"
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+using namespace reshade::hooks;
+
+static char s_functions[4096];
+
+static std::vector<std::pair<const module_export *, const module_export *>> match_exports_linear(const std::vector<module_export> &target_exports, const std::vector<module_export> &replacement_exports)
+{
+	std::vector<std::pair<const module_export *, const module_export *>> matches;
+
+	for (const auto &symbol : target_exports)
+	{
+		if (symbol.name == nullptr || symbol.address == nullptr)
+		{
+			continue;
+		}
+
+		const auto it = std::find_if(replacement_exports.begin(), replacement_exports.end(),
+			[&symbol](const module_export &replacement) { return std::strcmp(replacement.name, symbol.name) == 0; });
+
+		if (it != replacement_exports.end())
+		{
+			matches.emplace_back(&symbol, &*it);
+		}
+	}
+
+	return matches;
+}
+
+int main(int argc, char *argv[])
+{
+	const unsigned int runs = argc > 1 ? std::stoul(argv[1]) : 200;
+
+	std::mt19937 random(3);
+	std::vector<std::string> names;
+
+	for (size_t i = 0; i < 3000; i++)
+	{
+		std::string name = "gl";
+
+		for (size_t length = 4 + random() % 20; length != 0; length--)
+		{
+			name += static_cast<char>((random() % 2 ? 'a' : 'A') + random() % 26);
+		}
+
+		names.push_back(std::move(name));
+	}
+
+	std::sort(names.begin(), names.end());
+	names.erase(std::unique(names.begin(), names.end()), names.end());
+
+	// Roughly the number of exports of opengl32.dll, most of which ReShade exports too
+	std::vector<module_export> target_exports, replacement_exports;
+
+	for (size_t i = 0; i < 370; i++)
+	{
+		target_exports.push_back({ &s_functions[i], names[i * 5].c_str(), static_cast<unsigned short>(i) });
+	}
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (i % 7 != 0)
+		{
+			replacement_exports.push_back({ &s_functions[i], names[i].c_str(), static_cast<unsigned short>(i) });
+		}
+	}
+
+	const auto measure = [runs](const auto &match) {
+		std::vector<double> timings;
+
+		for (unsigned int run = 0; run < runs; ++run)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+
+			match();
+
+			timings.push_back(std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+
+		std::sort(timings.begin(), timings.end());
+
+		return std::make_pair(timings.front(), timings[timings.size() / 2]);
+	};
+
+	for (const bool shuffled : { false, true })
+	{
+		if (shuffled)
+		{
+			std::shuffle(target_exports.begin(), target_exports.end(), random);
+			std::shuffle(replacement_exports.begin(), replacement_exports.end(), random);
+		}
+
+		if (match_exports(target_exports, replacement_exports) != match_exports_linear(target_exports, replacement_exports))
+		{
+			std::printf("match_exports does not agree with the linear search\n");
+			return 1;
+		}
+
+		size_t match_count = 0;
+		const auto linear = measure([&]() { match_count = match_exports_linear(target_exports, replacement_exports).size(); });
+		const auto merged = measure([&]() { match_count = match_exports(target_exports, replacement_exports).size(); });
+
+		std::printf("%zu target and %zu replacement exports (%s), %zu matches: linear search min %.1f us, median %.1f us | match_exports min %.1f us, median %.1f us\n",
+			target_exports.size(), replacement_exports.size(), shuffled ? "shuffled" : "sorted", match_count, linear.first, linear.second, merged.first, merged.second);
+	}
+}
@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Measures how long it takes to lex and parse a large synthetic effect.
+//
+// cl /std:c++17 /O2 /EHsc /I source tests\benchmarks\parser_benchmark.cpp source\effect_lexer.cpp source\effect_parser.cpp source\effect_symbol_table.cpp source\constant_folding.cpp
+
+#include "effect_parser.hpp"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+static std::string generate_effect(unsigned int count)
+{
+	std::string source;
+
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		const std::string index = std::to_string(i);
+
+		source += "uniform float f" + index + " < ui_type = \"drag\"; ui_min = 0.0; ui_max = 1.0; > = 1.0;\n";
+		source += "float4 fn" + index + "(float4 pos : SV_Position, float2 tc : TEXCOORD) : SV_Target\n{\n"
+			"\tfloat4 c = (float4)0;\n"
+			"\tfor (int k = 0; k < 4; ++k)\n\t\tc[k] = (float)f" + index + " * (tc.x + 2.0) - tc.y * k;\n"
+			"\treturn c.x > 0.5 ? c : c.wzyx;\n}\n";
+	}
+
+	source += "technique T\n{\n\tpass\n\t{\n\t\tVertexShader = fn0;\n\t\tPixelShader = fn1;\n\t}\n}\n";
+
+	return source;
+}
+
+int main(int argc, char *argv[])
+{
+	const unsigned int count = argc > 1 ? std::stoul(argv[1]) : 3000;
+	const unsigned int runs = argc > 2 ? std::stoul(argv[2]) : 10;
+
+	const std::string source = generate_effect(count);
+	std::vector<double> timings;
+
+	for (unsigned int run = 0; run < runs; ++run)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		reshadefx::syntax_tree ast;
+		reshadefx::parser parser(ast);
+
+		if (!parser.run(source))
+		{
+			std::printf("failed to parse the generated effect:\n%s", parser.errors().c_str());
+			return 1;
+		}
+
+		timings.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+	}
+
+	std::sort(timings.begin(), timings.end());
+
+	std::printf("parsed %u functions (%zu bytes) %u times: min %.2f ms, median %.2f ms\n", count, source.size(), runs, timings.front(), timings[timings.size() / 2]);
+}
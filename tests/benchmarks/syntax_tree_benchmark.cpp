@@ -0,0 +1,156 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Measures how fast the syntax tree allocates nodes and how much heap memory it holds at its peak, both for a synthetic mix of nodes and for parsing a large generated effect.
+//
+// cl /std:c++17 /O2 /EHsc /I source tests\benchmarks\syntax_tree_benchmark.cpp source\effect_lexer.cpp source\effect_parser.cpp source\effect_symbol_table.cpp source\constant_folding.cpp
+
+#include "effect_parser.hpp"
+#include <new>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+// Every allocation is prefixed with its size, so that the current and peak number of live heap bytes can be tracked
+static size_t s_live_bytes = 0, s_peak_bytes = 0;
+
+void *operator new(size_t size)
+{
+	const auto block = static_cast<max_align_t *>(std::malloc(sizeof(max_align_t) + size));
+
+	if (block == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	*reinterpret_cast<size_t *>(block) = size;
+	s_live_bytes += size;
+	s_peak_bytes = std::max(s_peak_bytes, s_live_bytes);
+
+	return block + 1;
+}
+void operator delete(void *pointer) noexcept
+{
+	if (pointer == nullptr)
+	{
+		return;
+	}
+
+	const auto block = static_cast<max_align_t *>(pointer) - 1;
+	s_live_bytes -= *reinterpret_cast<size_t *>(block);
+
+	std::free(block);
+}
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+void operator delete[](void *pointer) noexcept
+{
+	operator delete(pointer);
+}
+void operator delete(void *pointer, size_t) noexcept
+{
+	operator delete(pointer);
+}
+void operator delete[](void *pointer, size_t) noexcept
+{
+	operator delete(pointer);
+}
+
+static size_t build_nodes(reshadefx::syntax_tree &ast, size_t count)
+{
+	using namespace reshadefx::nodes;
+
+	const reshadefx::location location;
+	size_t nodes = 0;
+
+	// A mix of trivially destructible expression nodes and declarations and statements that own containers, roughly like a parsed function body
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto variable = ast.make_node<variable_declaration_node>(location);
+		variable->name = "variable";
+
+		const auto lvalue = ast.make_node<lvalue_expression_node>(location);
+		lvalue->reference = variable;
+		const auto literal = ast.make_node<literal_expression_node>(location);
+		literal->value_float[0] = 1.0f;
+
+		const auto binary = ast.make_node<binary_expression_node>(location);
+		binary->operands[0] = lvalue;
+		binary->operands[1] = literal;
+
+		const auto statement = ast.make_node<expression_statement_node>(location);
+		statement->expression = binary;
+
+		const auto block = ast.make_node<compound_statement_node>(location);
+		block->statement_list.push_back(statement);
+
+		nodes += 6;
+	}
+
+	return nodes;
+}
+
+static std::string generate_effect(unsigned int count)
+{
+	std::string source;
+
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		const std::string index = std::to_string(i);
+
+		source += "uniform float f" + index + " < ui_type = \"drag\"; > = 1.0;\n";
+		source += "float4 fn" + index + "(float4 pos : SV_Position, float2 tc : TEXCOORD) : SV_Target { float4 c = (float4)0; c.x = (float)f" + index + " * (tc.x + 2.0); return c; }\n";
+	}
+
+	return source;
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+	const unsigned int runs = argc > 2 ? std::stoul(argv[2]) : 10;
+
+	std::vector<double> timings;
+	size_t nodes = 0, peak_bytes = 0;
+
+	for (unsigned int run = 0; run < runs; ++run)
+	{
+		const size_t base_bytes = s_live_bytes;
+		s_peak_bytes = s_live_bytes;
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		{
+			reshadefx::syntax_tree ast;
+			nodes = build_nodes(ast, count);
+		}
+		timings.push_back(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+
+		peak_bytes = s_peak_bytes - base_bytes;
+	}
+
+	std::sort(timings.begin(), timings.end());
+
+	std::printf("allocated and destroyed %zu nodes: %.0f K nodes/s (median %.0f K nodes/s), peak %zu KiB\n", nodes, nodes / timings.front() / 1e3, nodes / timings[timings.size() / 2] / 1e3, peak_bytes / 1024);
+
+	const std::string source = generate_effect(static_cast<unsigned int>(count / 100));
+	const size_t base_bytes = s_live_bytes;
+	s_peak_bytes = s_live_bytes;
+
+	{
+		reshadefx::syntax_tree ast;
+		reshadefx::parser parser(ast);
+
+		if (!parser.run(source))
+		{
+			std::printf("failed to parse the generated effect:\n%s", parser.errors().c_str());
+			return 1;
+		}
+	}
+
+	std::printf("parsing %zu functions: peak %zu KiB\n", count / 100, (s_peak_bytes - base_bytes) / 1024);
+}
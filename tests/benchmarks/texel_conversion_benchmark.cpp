@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Compares the texel conversion routines with the per-texel loops the runtimes used before, on a 4096x4096 image.
+// Both produce the same output, which is checked before anything is measured.
+//
+// cl /std:c++17 /O2 /EHsc /I source tests\benchmarks\texel_conversion_benchmark.cpp source\texel_conversion.cpp
+
+#include "texel_conversion.hpp"
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+using namespace reshade;
+
+// Texture upload of single and two channel formats (d3d10, d3d11 and OpenGL runtimes)
+static void per_texel_r(uint8_t *dst, const uint8_t *src, size_t count)
+{
+	for (size_t i = 0, k = 0; i < count * 4; i += 4, k++)
+	{
+		dst[k] = src[i];
+	}
+}
+static void per_texel_rg(uint8_t *dst, const uint8_t *src, size_t count)
+{
+	for (size_t i = 0, k = 0; i < count * 4; i += 4, k += 2)
+	{
+		dst[k] = src[i];
+		dst[k + 1] = src[i + 1];
+	}
+}
+// Screenshot capture of a single row (d3d10 and d3d11 runtimes)
+static void per_texel_capture(uint8_t *dst, const uint8_t *src, size_t count, bool is_bgra)
+{
+	const size_t pitch = count * 4;
+
+	std::memcpy(dst, src, pitch);
+
+	for (size_t x = 0; x < pitch; x += 4)
+	{
+		dst[x + 3] = 0xFF;
+
+		if (is_bgra)
+		{
+			std::swap(dst[x + 0], dst[x + 2]);
+		}
+	}
+}
+// Texture upload (d3d9 runtime)
+static void per_texel_bgra(uint8_t *dst, const uint8_t *src, size_t count)
+{
+	for (size_t i = 0; i < count * 4; i += 4, dst += 4)
+	{
+		dst[0] = src[i + 2];
+		dst[1] = src[i + 1];
+		dst[2] = src[i];
+		dst[3] = src[i + 3];
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t width = 4096, height = 4096, count = width * height;
+	const unsigned int runs = argc > 1 ? std::stoul(argv[1]) : 15;
+
+	std::vector<uint8_t> src(count * 4), expected(count * 4), actual(count * 4);
+	std::mt19937 random(1);
+	std::generate(src.begin(), src.end(), [&random]() { return static_cast<uint8_t>(random()); });
+
+	const auto measure = [runs](const auto &convert) {
+		std::vector<double> timings;
+
+		for (unsigned int run = 0; run < runs; ++run)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+
+			convert();
+
+			timings.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+
+		std::sort(timings.begin(), timings.end());
+
+		return std::make_pair(timings.front(), timings[timings.size() / 2]);
+	};
+	const auto compare = [&](const char *name, size_t size, const auto &before, const auto &after) {
+		std::fill(expected.begin(), expected.end(), 0);
+		std::fill(actual.begin(), actual.end(), 0);
+
+		before();
+		after();
+
+		if (std::memcmp(expected.data(), actual.data(), size) != 0)
+		{
+			std::printf("%s: output differs from the per-texel loop\n", name);
+			return false;
+		}
+
+		const auto before_timing = measure(before);
+		const auto after_timing = measure(after);
+
+		std::printf("%-12s per-texel min %6.2f ms, median %6.2f ms | texel_conversion min %6.2f ms, median %6.2f ms\n", name,
+			before_timing.first, before_timing.second, after_timing.first, after_timing.second);
+
+		return true;
+	};
+
+	std::printf("%zux%zu texels, %u runs each\n", width, height, runs);
+
+	bool success = true;
+
+	success &= compare("rgba to r", count,
+		[&]() { per_texel_r(expected.data(), src.data(), count); },
+		[&]() { texel_conversion::extract_r(actual.data(), src.data(), count); });
+	success &= compare("rgba to rg", count * 2,
+		[&]() { per_texel_rg(expected.data(), src.data(), count); },
+		[&]() { texel_conversion::extract_rg(actual.data(), src.data(), count); });
+	success &= compare("capture bgra", count * 4,
+		[&]() { for (size_t y = 0; y < height; y++) per_texel_capture(expected.data() + y * width * 4, src.data() + y * width * 4, width, true); },
+		[&]() { for (size_t y = 0; y < height; y++) texel_conversion::swap_red_blue(actual.data() + y * width * 4, src.data() + y * width * 4, width, 0xFFFFFFFF, 0xFF000000); });
+	success &= compare("capture rgba", count * 4,
+		[&]() { for (size_t y = 0; y < height; y++) per_texel_capture(expected.data() + y * width * 4, src.data() + y * width * 4, width, false); },
+		[&]() { for (size_t y = 0; y < height; y++) texel_conversion::fill_alpha(actual.data() + y * width * 4, src.data() + y * width * 4, width); });
+	success &= compare("rgba to bgra", count * 4,
+		[&]() { per_texel_bgra(expected.data(), src.data(), count); },
+		[&]() { texel_conversion::swap_red_blue(actual.data(), src.data(), count); });
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Counts the heap allocations the preprocessor and the parser make per token of a large generated effect, and how long each of them takes.
+// The effect is written to a file with a long name in the working directory first, since the preprocessor attaches the source file name to its tokens.
+//
+// cl /std:c++17 /O2 /EHsc /I source tests\benchmarks\token_benchmark.cpp source\effect_lexer.cpp source\effect_parser.cpp source\effect_preprocessor.cpp source\effect_symbol_table.cpp source\constant_folding.cpp source\filesystem.cpp shell32.lib shlwapi.lib
+
+#include "effect_parser.hpp"
+#include "effect_preprocessor.hpp"
+#include <new>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+static size_t s_allocations = 0;
+
+void *operator new(size_t size)
+{
+	s_allocations++;
+
+	if (const auto pointer = std::malloc(size))
+	{
+		return pointer;
+	}
+
+	throw std::bad_alloc();
+}
+void operator delete(void *pointer) noexcept
+{
+	std::free(pointer);
+}
+void operator delete(void *pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+int main(int argc, char *argv[])
+{
+	const unsigned int count = argc > 1 ? std::stoul(argv[1]) : 3000;
+	const std::string path = "token_benchmark_generated_effect_with_a_name_as_long_as_usual_paths.fx";
+
+	{
+		std::ofstream file(path, std::ios::out | std::ios::trunc);
+
+		file << "#define SCALE(x) ((x) * 2.0)\n";
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			file << "uniform float f" << i << " < ui_type = \"drag\"; ui_label = \"Value " << i << "\"; > = 1.0;\n";
+			file << "float4 fn" << i << "(float4 pos : SV_Position, float2 tc : TEXCOORD) : SV_Target { float4 c = (float4)0; c.x = (float)f" << i << " * SCALE(tc.x + 2.0); return c; }\n";
+		}
+	}
+
+	reshadefx::preprocessor pp;
+
+	size_t allocations = s_allocations;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	if (!pp.run(reshade::filesystem::path(path)))
+	{
+		std::printf("failed to preprocess the generated effect:\n%s", pp.errors().c_str());
+		return 1;
+	}
+
+	const double preprocess_time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	const size_t preprocess_allocations = s_allocations - allocations;
+
+	std::remove(path.c_str());
+
+	size_t tokens = 0;
+
+	{
+		reshadefx::lexer lexer(pp.current_output());
+
+		while (lexer.lex().id != reshadefx::tokenid::end_of_file)
+		{
+			tokens++;
+		}
+	}
+
+	reshadefx::syntax_tree ast;
+	reshadefx::parser parser(ast);
+
+	allocations = s_allocations;
+	start = std::chrono::high_resolution_clock::now();
+
+	if (!parser.run(pp.current_output()))
+	{
+		std::printf("failed to parse the generated effect:\n%s", parser.errors().c_str());
+		return 1;
+	}
+
+	const double parse_time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	const size_t parse_allocations = s_allocations - allocations;
+
+	std::printf("%zu tokens\n", tokens);
+	std::printf("preprocessor: %.1f ms, %zu allocations (%.2f per token)\n", preprocess_time, preprocess_allocations, static_cast<double>(preprocess_allocations) / tokens);
+	std::printf("parser: %.1f ms, %zu allocations (%.2f per token)\n", parse_time, parse_allocations, static_cast<double>(parse_allocations) / tokens);
+}
@@ -0,0 +1,153 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Measures the per-frame cost of the runtime writing uniforms with a "source" annotation, for an effect with many user settings and a few bound uniforms.
+// Runs apply_uniform_updates on the updates resolve_uniform_update produced at load time, against resolving them again every frame like the runtime used to.
+// The uniform storage is a plain byte array here, input is never queried because none of the uniforms is bound to a key or the mouse.
+//
+// cl /std:c++17 /O2 /EHsc /I source tests\benchmarks\uniform_update_benchmark.cpp source\uniform_updates.cpp
+
+#include "uniform_updates.hpp"
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+using namespace reshade;
+
+bool input::is_key_down(unsigned int) const { return false; }
+bool input::is_key_pressed(unsigned int) const { return false; }
+bool input::is_mouse_button_down(unsigned int) const { return false; }
+bool input::is_mouse_button_pressed(unsigned int) const { return false; }
+
+struct uniform_storage
+{
+	template <typename T>
+	void get_uniform_value(const uniform &variable, T *values, size_t count) const
+	{
+		std::memcpy(values, data.data() + variable.storage_offset, std::min(count * sizeof(T), variable.storage_size));
+	}
+	template <typename T>
+	void set_uniform_value(const uniform &variable, const T *values, size_t count)
+	{
+		std::memcpy(data.data() + variable.storage_offset, values, std::min(count * sizeof(T), variable.storage_size));
+	}
+
+	std::vector<unsigned char> data;
+};
+
+int main(int argc, char *argv[])
+{
+	const size_t count = argc > 1 ? std::stoul(argv[1]) : 2000;
+	const unsigned int frames = argc > 2 ? std::stoul(argv[2]) : 1000;
+
+	// Only every fourth uniform is bound to a source, the others are user settings the runtime never touches
+	const char *const sources[] = { "frametime", "framecount", "pingpong", "date", "timer", "random" };
+	const int date[4] = { 2018, 1, 1, 0 };
+	std::vector<uniform> uniforms(count);
+	std::vector<uniform_update> updates;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto &variable = uniforms[i];
+		variable.basetype = uniform_datatype::floating_point;
+		variable.storage_offset = i * 16;
+		variable.storage_size = 16;
+		variable.annotations["ui_type"] = "drag";
+		variable.annotations["ui_min"] = 0;
+		variable.annotations["ui_max"] = 10;
+
+		if (i % 4 != 0)
+		{
+			continue;
+		}
+
+		variable.annotations["source"] = sources[(i / 4) % 6];
+		variable.annotations["min"] = 0;
+		variable.annotations["max"] = 10;
+		variable.annotations["step"] = std::vector<std::string> { "1", "2" };
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uniform_update update;
+
+		if (resolve_uniform_update(uniforms[i], i, update))
+		{
+			updates.push_back(update);
+		}
+	}
+
+	uniform_update_state frame;
+	frame.frame_duration = std::chrono::milliseconds(16);
+	frame.elapsed_time = std::chrono::seconds(0);
+	frame.framecount = 0;
+	frame.date = date;
+	frame.input = nullptr;
+
+	uniform_storage storage;
+	storage.data.resize(count * 16);
+
+	const auto update_by_annotations = [&]() {
+		std::vector<uniform_update> frame_updates;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uniform_update update;
+
+			if (resolve_uniform_update(uniforms[i], i, update))
+			{
+				frame_updates.push_back(update);
+			}
+		}
+
+		apply_uniform_updates(storage, uniforms, frame_updates, frame);
+	};
+	const auto update_resolved = [&]() {
+		apply_uniform_updates(storage, uniforms, updates, frame);
+	};
+
+	// Both have to write the same values, the random numbers are reset so that they match too
+	std::srand(0);
+	update_by_annotations();
+	const auto by_annotations_data = storage.data;
+	std::fill(storage.data.begin(), storage.data.end(), static_cast<unsigned char>(0));
+	std::srand(0);
+	update_resolved();
+
+	if (storage.data != by_annotations_data)
+	{
+		std::printf("resolved updates do not write the same values as resolving them every frame\n");
+		return 1;
+	}
+
+	const auto measure = [&](const auto &update) {
+		std::vector<double> timings;
+
+		for (unsigned int i = 0; i < frames; ++i)
+		{
+			frame.framecount = i;
+			frame.elapsed_time += frame.frame_duration;
+
+			const auto start = std::chrono::high_resolution_clock::now();
+
+			update();
+
+			timings.push_back(std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+
+		std::sort(timings.begin(), timings.end());
+
+		return std::make_pair(timings.front(), timings[timings.size() / 2]);
+	};
+
+	const auto by_annotations = measure(update_by_annotations);
+	const auto resolved = measure(update_resolved);
+
+	std::printf("%zu uniforms, %zu with a source, %u frames\n", count, updates.size(), frames);
+	std::printf("resolving every frame: min %.2f us, median %.2f us per frame\n", by_annotations.first, by_annotations.second);
+	std::printf("resolved at load: min %.2f us, median %.2f us per frame\n", resolved.first, resolved.second);
+}
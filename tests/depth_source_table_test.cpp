@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Tests the depth source table, in particular that it keeps accepting entries after its initial capacity is used up.
+//
+// cl /std:c++17 /EHsc /I source tests\depth_source_table_test.cpp
+// g++ -std=c++17 -I source tests/depth_source_table_test.cpp
+
+#include "depth_source_table.hpp"
+#include <cstdio>
+
+static unsigned int s_failures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { std::printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); s_failures++; }
+
+// Stands in for a depth stencil view, only its address is used
+struct alignas(16) view
+{
+	char data[16];
+};
+
+static void test_find_and_erase()
+{
+	view views[3];
+	reshade::depth_source_table<view> table;
+
+	CHECK(table.empty());
+	CHECK(table.find(&views[0]) == nullptr);
+
+	table.insert(&views[0], 1920, 1080, false);
+	table.insert(&views[1], 640, 480, true);
+
+	CHECK(table.size() == 2);
+	CHECK(table.find(&views[2]) == nullptr);
+
+	reshade::depth_source_info *const info = table.find(&views[1]);
+	CHECK(info != nullptr);
+	CHECK(info != nullptr && info->width == 640 && info->height == 480 && info->rejected);
+
+	table.erase(&views[1]);
+
+	CHECK(table.size() == 1);
+	CHECK(table.find(&views[1]) == nullptr);
+	CHECK(table.find(&views[0]) != nullptr);
+
+	// Inserting again reuses the tombstone without disturbing the other entry
+	table.insert(&views[1], 800, 600, false);
+
+	CHECK(table.find(&views[1]) != nullptr && table.find(&views[1])->width == 800);
+	CHECK(table.find(&views[0]) != nullptr && table.find(&views[0])->width == 1920);
+
+	table.clear();
+
+	CHECK(table.empty());
+	CHECK(table.find(&views[0]) == nullptr);
+}
+
+static void test_growth()
+{
+	const size_t count = 1000;
+	static view views[count];
+	reshade::depth_source_table<view> table(16);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		table.insert(&views[i], static_cast<unsigned int>(i), 0, i % 3 == 0);
+
+		// Statistics recorded before the table grows have to be carried over
+		table.find(&views[i])->vertices_count += static_cast<unsigned int>(i);
+	}
+
+	CHECK(table.size() == count);
+	CHECK(table.capacity() >= count * 4 / 3);
+
+	size_t found = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const reshade::depth_source_info *const info = table.find(&views[i]);
+
+		if (info != nullptr && info->width == i && info->rejected == (i % 3 == 0) && info->vertices_count == i)
+		{
+			found++;
+		}
+	}
+
+	CHECK(found == count);
+
+	size_t visited = 0;
+	table.for_each([&visited](view *, reshade::depth_source_info &) { visited++; });
+
+	CHECK(visited == count);
+}
+
+static void test_churn()
+{
+	// Removing and adding entries over and over must neither grow the table nor lose entries
+	const size_t live = 8;
+	static view views[live * 64];
+	reshade::depth_source_table<view> table(16);
+
+	for (size_t i = 0; i < live * 64; i++)
+	{
+		if (i >= live)
+		{
+			table.erase(&views[i - live]);
+		}
+
+		table.insert(&views[i], 0, 0, false);
+
+		CHECK(table.find(&views[i]) != nullptr);
+	}
+
+	CHECK(table.size() == live);
+	CHECK(table.capacity() == 16);
+}
+
+int main()
+{
+	test_find_and_erase();
+	test_growth();
+	test_churn();
+
+	if (s_failures != 0)
+	{
+		std::printf("%u checks failed\n", s_failures);
+		return 1;
+	}
+
+	std::printf("all checks passed\n");
+}
@@ -0,0 +1,131 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Tests the frame buffer bookkeeping of the OpenGL runtime. It never calls into OpenGL, so this runs without a context.
+//
+// cl /std:c++17 /EHsc /I source /I deps\gl3w\include tests\framebuffer_state_test.cpp source\opengl\opengl_framebuffer_state.cpp
+// g++ -std=c++17 -I source -I deps/gl3w/include tests/framebuffer_state_test.cpp source/opengl/opengl_framebuffer_state.cpp
+
+#include "opengl/opengl_framebuffer_state.hpp"
+#include <cstdio>
+
+static unsigned int s_failures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { std::printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); s_failures++; }
+
+using reshade::opengl::framebuffer_state;
+
+static void test_default_framebuffer()
+{
+	framebuffer_state state;
+	GLuint fbo = 1, id = 1;
+
+	// Nothing was bound through the hooks yet, so the caller has to query the driver
+	CHECK(!state.find_draw_depth_attachment(fbo, id));
+	CHECK(!state.find_binding(GL_FRAMEBUFFER, fbo));
+
+	state.bind(GL_FRAMEBUFFER, 0);
+
+	CHECK(state.find_draw_depth_attachment(fbo, id));
+	CHECK(fbo == 0 && id == 0);
+}
+
+static void test_attachments()
+{
+	framebuffer_state state;
+	GLuint fbo = 0, id = 0;
+
+	state.bind(GL_FRAMEBUFFER, 5);
+
+	// The attachments of a frame buffer that was never seen before are unknown
+	CHECK(!state.find_draw_depth_attachment(fbo, id));
+
+	state.attach(5, GL_DEPTH_ATTACHMENT, framebuffer_state::make_attachment_id(GL_RENDERBUFFER, 3));
+
+	CHECK(state.find_draw_depth_attachment(fbo, id));
+	CHECK(fbo == 5 && id == (3 | 0x80000000));
+
+	// Color attachments do not affect the depth attachment
+	state.attach(5, GL_COLOR_ATTACHMENT0, 7);
+
+	CHECK(state.find_draw_depth_attachment(fbo, id));
+	CHECK(id == (3 | 0x80000000));
+
+	// Attaching to a frame buffer that is not bound is remembered for when it is
+	state.attach(6, GL_DEPTH_STENCIL_ATTACHMENT, framebuffer_state::make_attachment_id(GL_TEXTURE_2D, 9));
+	state.bind(GL_DRAW_FRAMEBUFFER, 6);
+
+	CHECK(state.find_draw_depth_attachment(fbo, id));
+	CHECK(fbo == 6 && id == 9);
+	CHECK(state.find_binding(GL_READ_FRAMEBUFFER, fbo) && fbo == 5);
+
+	state.attach(6, GL_DEPTH_ATTACHMENT, framebuffer_state::make_attachment_id(GL_TEXTURE_2D, 0));
+
+	CHECK(state.find_draw_depth_attachment(fbo, id));
+	CHECK(fbo == 6 && id == 0);
+}
+
+static void test_delete()
+{
+	framebuffer_state state;
+	GLuint fbo = 0, id = 0;
+
+	state.bind(GL_READ_FRAMEBUFFER, 5);
+	state.bind(GL_DRAW_FRAMEBUFFER, 6);
+	state.attach(5, GL_DEPTH_ATTACHMENT, 2);
+	state.attach(6, GL_DEPTH_ATTACHMENT, 3);
+
+	// Deleting bound frame buffers reverts both bindings to the default one
+	const GLuint fbos[] = { 6, 5 };
+	state.remove(2, fbos);
+
+	CHECK(state.find_draw_depth_attachment(fbo, id));
+	CHECK(fbo == 0 && id == 0);
+	CHECK(state.find_binding(GL_READ_FRAMEBUFFER, fbo) && fbo == 0);
+
+	// Names are reused by OpenGL, so the attachments of the deleted frame buffer must be forgotten
+	state.bind(GL_FRAMEBUFFER, 5);
+
+	CHECK(!state.find_draw_depth_attachment(fbo, id));
+}
+
+static void test_switch_context()
+{
+	framebuffer_state state;
+	GLuint fbo = 0, id = 0;
+
+	state.bind(GL_FRAMEBUFFER, 1);
+	state.attach(1, GL_DEPTH_ATTACHMENT, 2);
+
+	CHECK(state.find_draw_depth_attachment(fbo, id));
+
+	// Frame buffers are not shared between contexts, so nothing is known after a switch
+	state.reset();
+
+	CHECK(!state.find_draw_depth_attachment(fbo, id));
+	CHECK(!state.find_binding(GL_FRAMEBUFFER, fbo));
+	CHECK(!state.find_binding(GL_READ_FRAMEBUFFER, fbo));
+
+	state.bind(GL_FRAMEBUFFER, 1);
+
+	CHECK(!state.find_draw_depth_attachment(fbo, id));
+}
+
+int main()
+{
+	test_default_framebuffer();
+	test_attachments();
+	test_delete();
+	test_switch_context();
+
+	if (s_failures != 0)
+	{
+		std::printf("%u checks failed\n", s_failures);
+		return 1;
+	}
+
+	std::printf("all checks passed\n");
+}
@@ -0,0 +1,174 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Tests that matching module exports by name gives the same result as searching the replacement exports for every target export.
+//
+// cl /std:c++17 /EHsc /I source tests\hook_exports_test.cpp source\hook_exports.cpp
+// g++ -std=c++17 -I source tests/hook_exports_test.cpp source/hook_exports.cpp
+
+#include "hook_exports.hpp"
+#include <random>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+static unsigned int s_failures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { std::printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); s_failures++; }
+
+using namespace reshade::hooks;
+
+// Stand-ins for the exported functions, only their addresses are used
+static char s_functions[4096];
+
+static std::vector<std::pair<const module_export *, const module_export *>> match_exports_linear(const std::vector<module_export> &target_exports, const std::vector<module_export> &replacement_exports)
+{
+	std::vector<std::pair<const module_export *, const module_export *>> matches;
+
+	for (const auto &symbol : target_exports)
+	{
+		if (symbol.name == nullptr || symbol.address == nullptr)
+		{
+			continue;
+		}
+
+		const auto it = std::find_if(replacement_exports.begin(), replacement_exports.end(),
+			[&symbol](const module_export &replacement) { return replacement.name != nullptr && std::strcmp(replacement.name, symbol.name) == 0; });
+
+		if (it != replacement_exports.end())
+		{
+			matches.emplace_back(&symbol, &*it);
+		}
+	}
+
+	return matches;
+}
+
+static void test_basic()
+{
+	const std::vector<module_export> target_exports = {
+		{ &s_functions[0], "glBegin", 1 },
+		{ &s_functions[1], "glClear", 2 },
+		{ &s_functions[2], "glEnd", 3 },
+		{ &s_functions[3], "wglMakeCurrent", 4 },
+	};
+	const std::vector<module_export> replacement_exports = {
+		{ &s_functions[10], "DllMain", 1 },
+		{ &s_functions[11], "glClear", 2 },
+		{ &s_functions[12], "wglMakeCurrent", 3 },
+	};
+
+	const auto matches = match_exports(target_exports, replacement_exports);
+
+	CHECK(matches.size() == 2);
+	CHECK(matches.size() == 2 && matches[0].first == &target_exports[1] && matches[0].second == &replacement_exports[1]);
+	CHECK(matches.size() == 2 && matches[1].first == &target_exports[3] && matches[1].second == &replacement_exports[2]);
+
+	CHECK(match_exports({ }, replacement_exports).empty());
+	CHECK(match_exports(target_exports, { }).empty());
+}
+
+static void test_skipped_exports()
+{
+	// Exports by ordinal have no name and forwarded exports are listed without an address
+	const std::vector<module_export> target_exports = {
+		{ &s_functions[0], nullptr, 1 },
+		{ nullptr, "glClear", 2 },
+		{ &s_functions[2], "glEnd", 3 },
+	};
+	const std::vector<module_export> replacement_exports = {
+		{ &s_functions[10], "glClear", 1 },
+		{ &s_functions[11], "glEnd", 2 },
+		{ &s_functions[12], nullptr, 3 },
+	};
+
+	const auto matches = match_exports(target_exports, replacement_exports);
+
+	CHECK(matches.size() == 1);
+	CHECK(matches.size() == 1 && matches[0].first == &target_exports[2] && matches[0].second == &replacement_exports[1]);
+}
+
+static void test_duplicates()
+{
+	// Out of order, so that the replacement exports have to be sorted, which must keep the first of the duplicates in front
+	const std::vector<module_export> target_exports = {
+		{ &s_functions[0], "glEnd", 1 },
+		{ &s_functions[1], "glClear", 2 },
+		{ &s_functions[2], "glClear", 3 },
+	};
+	const std::vector<module_export> replacement_exports = {
+		{ &s_functions[10], "glEnd", 1 },
+		{ &s_functions[11], "glClear", 2 },
+		{ &s_functions[12], "glBegin", 3 },
+		{ &s_functions[13], "glClear", 4 },
+	};
+
+	const auto matches = match_exports(target_exports, replacement_exports);
+
+	CHECK(matches == match_exports_linear(target_exports, replacement_exports));
+	CHECK(matches.size() == 3);
+	CHECK(matches.size() == 3 && matches[1].second == &replacement_exports[1] && matches[2].second == &replacement_exports[1]);
+}
+
+static void test_random()
+{
+	std::mt19937 random(3);
+	std::vector<std::string> names;
+
+	for (size_t i = 0; i < 3000; i++)
+	{
+		std::string name = "gl";
+
+		for (size_t length = 4 + random() % 20; length != 0; length--)
+		{
+			name += static_cast<char>((random() % 2 ? 'a' : 'A') + random() % 26);
+		}
+
+		names.push_back(std::move(name));
+	}
+
+	std::sort(names.begin(), names.end());
+	names.erase(std::unique(names.begin(), names.end()), names.end());
+
+	// The target is sorted like an export name table, the replacement exports contain most of its names and many others
+	std::vector<module_export> target_exports, replacement_exports;
+
+	for (size_t i = 0; i * 5 < names.size(); i++)
+	{
+		target_exports.push_back({ &s_functions[i], names[i * 5].c_str(), static_cast<unsigned short>(i) });
+	}
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (i % 7 != 0)
+		{
+			replacement_exports.push_back({ &s_functions[i], names[i].c_str(), static_cast<unsigned short>(i) });
+		}
+	}
+
+	CHECK(match_exports(target_exports, replacement_exports) == match_exports_linear(target_exports, replacement_exports));
+
+	std::shuffle(target_exports.begin(), target_exports.end(), random);
+	std::shuffle(replacement_exports.begin(), replacement_exports.end(), random);
+
+	CHECK(match_exports(target_exports, replacement_exports) == match_exports_linear(target_exports, replacement_exports));
+}
+
+int main()
+{
+	test_basic();
+	test_skipped_exports();
+	test_duplicates();
+	test_random();
+
+	if (s_failures != 0)
+	{
+		std::printf("%u checks failed\n", s_failures);
+		return 1;
+	}
+
+	std::printf("all checks passed\n");
+}
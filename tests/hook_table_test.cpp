@@ -0,0 +1,154 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Tests that the hook table keeps the first hook added for a replacement and that lookups on other threads find every published hook while the table grows.
+//
+// cl /std:c++17 /EHsc /I source tests\hook_table_test.cpp
+// g++ -std=c++17 -pthread -I source tests/hook_table_test.cpp
+
+#include "hook_table.hpp"
+#include <thread>
+#include <cstdio>
+
+static unsigned int s_failures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { std::printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); s_failures++; }
+
+using namespace reshade::hooks;
+
+// Stand-ins for the target and replacement functions, only their addresses are used
+static char s_targets[40000], s_replacements[20000];
+
+static reshade::hook make_hook(size_t target_index, size_t replacement_index)
+{
+	reshade::hook hook;
+	hook.target = &s_targets[target_index];
+	hook.replacement = &s_replacements[replacement_index];
+	hook.trampoline = hook.target;
+	return hook;
+}
+
+static void test_basic()
+{
+	hook_table table;
+
+	CHECK(!table.find(&s_replacements[0]).valid());
+
+	table.insert(make_hook(0, 0));
+	table.insert(make_hook(1, 1));
+
+	CHECK(table.find(&s_replacements[0]).target == &s_targets[0]);
+	CHECK(table.find(&s_replacements[1]).target == &s_targets[1]);
+	CHECK(!table.find(&s_replacements[2]).valid());
+
+	table.clear();
+
+	CHECK(!table.find(&s_replacements[0]).valid());
+}
+
+static void test_duplicates()
+{
+	hook_table table;
+
+	table.insert(make_hook(0, 0));
+	table.insert(make_hook(1, 0));
+
+	CHECK(table.find(&s_replacements[0]).target == &s_targets[0]);
+
+	// The first hook has to survive being copied into larger tables too, even if the duplicate comes after the growth
+	for (size_t i = 1; i < 5000; i++)
+	{
+		table.insert(make_hook(i, i));
+	}
+
+	table.insert(make_hook(20000, 0));
+	table.insert(make_hook(20001, 4999));
+
+	CHECK(table.find(&s_replacements[0]).target == &s_targets[0]);
+	CHECK(table.find(&s_replacements[4999]).target == &s_targets[4999]);
+}
+
+static void test_concurrent_lookups()
+{
+	const size_t count = sizeof(s_replacements);
+
+	hook_table table;
+	std::atomic<size_t> published = 0;
+	std::atomic<unsigned int> missing = 0, wrong = 0;
+
+	// One thread adds hooks (the caller serializes adding), while the others keep looking up all hooks added so far as the table grows underneath them
+	std::thread writer([&]() {
+		for (size_t i = 0; i < count; i++)
+		{
+			table.insert(make_hook(i, i));
+
+			// Every so often add a second hook for an earlier replacement, which lookups must never return
+			if (i % 7 == 0)
+			{
+				table.insert(make_hook(count + i / 7, i / 2));
+			}
+
+			published.store(i + 1, std::memory_order_release);
+		}
+	});
+
+	std::vector<std::thread> readers;
+
+	for (unsigned int t = 0; t < 3; t++)
+	{
+		readers.emplace_back([&, t]() {
+			while (true)
+			{
+				const size_t end = published.load(std::memory_order_acquire);
+
+				for (size_t i = t; i < end; i += 3)
+				{
+					const auto hook = table.find(&s_replacements[i]);
+
+					if (!hook.valid())
+					{
+						missing++;
+					}
+					else if (hook.target != &s_targets[i])
+					{
+						wrong++;
+					}
+				}
+
+				if (end == count)
+				{
+					break;
+				}
+			}
+		});
+	}
+
+	writer.join();
+
+	for (auto &reader : readers)
+	{
+		reader.join();
+	}
+
+	CHECK(missing == 0);
+	CHECK(wrong == 0);
+	CHECK(!table.find(&s_targets[0]).valid());
+}
+
+int main()
+{
+	test_basic();
+	test_duplicates();
+	test_concurrent_lookups();
+
+	if (s_failures != 0)
+	{
+		std::printf("%u checks failed\n", s_failures);
+		return 1;
+	}
+
+	std::printf("all checks passed\n");
+}
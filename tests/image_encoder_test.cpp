@@ -0,0 +1,653 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Tests that the PNG files the image encoder writes decode to the original pixels, for odd image sizes and for many stripes, which the encoder would only use on machines with many cores.
+// The files are decoded by an inflate and the checksums are calculated by code written from RFC 1950, 1951 and the PNG specification, which shares nothing with the encoder.
+//
+// cl /std:c++17 /EHsc /I source tests\image_encoder_test.cpp source\png_encoder.cpp
+// g++ -std=c++17 -I source tests/image_encoder_test.cpp source/png_encoder.cpp
+
+#include "png_encoder.hpp"
+#include <random>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+static unsigned int s_failures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { std::printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); s_failures++; }
+
+static uint32_t reference_crc32(const uint8_t *data, size_t size)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		crc ^= data[i];
+
+		for (int k = 0; k < 8; k++)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+	}
+
+	return ~crc;
+}
+static uint32_t reference_adler32(const std::vector<uint8_t> &data)
+{
+	uint32_t a = 1, b = 0;
+
+	for (const uint8_t value : data)
+	{
+		a = (a + value) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	return (b << 16) | a;
+}
+static uint32_t read_u32(const uint8_t *data)
+{
+	return static_cast<uint32_t>(data[0]) << 24 | data[1] << 16 | data[2] << 8 | data[3];
+}
+
+// Decodes a raw deflate stream with all three block types, one bit at a time
+class inflater
+{
+public:
+	inflater(const uint8_t *data, size_t size) : _data(data), _size(size) { }
+
+	bool inflate(std::vector<uint8_t> &output)
+	{
+		for (bool is_final_block = false; !is_final_block && !_error;)
+		{
+			is_final_block = bits(1) != 0;
+
+			switch (bits(2))
+			{
+			case 0:
+				stored(output);
+				break;
+			case 1:
+				fixed(output);
+				break;
+			case 2:
+				dynamic(output);
+				break;
+			default:
+				_error = true;
+				break;
+			}
+		}
+
+		return !_error;
+	}
+
+	// Returns the number of bytes consumed, including the one the last bits were taken from
+	size_t consumed() const { return _position; }
+
+private:
+	struct huffman
+	{
+		uint16_t counts[16] = { };
+		uint16_t symbols[320] = { };
+	};
+
+	unsigned int bits(unsigned int count)
+	{
+		unsigned int value = 0;
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (_bit_count == 0)
+			{
+				if (_position >= _size)
+				{
+					_error = true;
+					return 0;
+				}
+
+				_bit_buffer = _data[_position++];
+				_bit_count = 8;
+			}
+
+			value |= (_bit_buffer & 1) << i;
+			_bit_buffer >>= 1;
+			_bit_count--;
+		}
+
+		return value;
+	}
+
+	static bool build(huffman &table, const uint8_t *lengths, unsigned int count)
+	{
+		uint16_t offsets[16] = { };
+
+		for (unsigned int symbol = 0; symbol < count; symbol++)
+		{
+			table.counts[lengths[symbol]]++;
+		}
+
+		table.counts[0] = 0;
+
+		for (unsigned int length = 1; length < 15; length++)
+		{
+			offsets[length + 1] = offsets[length] + table.counts[length];
+		}
+
+		for (unsigned int symbol = 0; symbol < count; symbol++)
+		{
+			if (lengths[symbol] != 0)
+			{
+				table.symbols[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+			}
+		}
+
+		// Reject code lengths that describe more codes than there is room for
+		int left = 1;
+
+		for (unsigned int length = 1; length < 16; length++)
+		{
+			left = (left << 1) - table.counts[length];
+
+			if (left < 0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+	int decode(const huffman &table)
+	{
+		// Canonical codes of one length are consecutive, so walk the lengths and check whether the code read so far falls into the range of the current one
+		int code = 0, first = 0, index = 0;
+
+		for (unsigned int length = 1; length < 16 && !_error; length++)
+		{
+			code |= bits(1);
+
+			const int count = table.counts[length];
+
+			if (code - count < first)
+			{
+				return table.symbols[index + (code - first)];
+			}
+
+			index += count;
+			first = (first + count) << 1;
+			code <<= 1;
+		}
+
+		_error = true;
+		return -1;
+	}
+
+	void stored(std::vector<uint8_t> &output)
+	{
+		_bit_count = 0;
+
+		if (_size - _position < 4)
+		{
+			_error = true;
+			return;
+		}
+
+		const unsigned int length = _data[_position] | _data[_position + 1] << 8;
+		const unsigned int inverse = _data[_position + 2] | _data[_position + 3] << 8;
+		_position += 4;
+
+		if (length != (~inverse & 0xFFFF) || _size - _position < length)
+		{
+			_error = true;
+			return;
+		}
+
+		output.insert(output.end(), _data + _position, _data + _position + length);
+		_position += length;
+	}
+	void fixed(std::vector<uint8_t> &output)
+	{
+		uint8_t lengths[288 + 30];
+
+		for (unsigned int symbol = 0; symbol < 288; symbol++)
+		{
+			lengths[symbol] = symbol < 144 ? 8 : symbol < 256 ? 9 : symbol < 280 ? 7 : 8;
+		}
+		for (unsigned int symbol = 0; symbol < 30; symbol++)
+		{
+			lengths[288 + symbol] = 5;
+		}
+
+		huffman literals, distances;
+		build(literals, lengths, 288);
+		build(distances, lengths + 288, 30);
+
+		codes(output, literals, distances);
+	}
+	void dynamic(std::vector<uint8_t> &output)
+	{
+		static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		const unsigned int literal_count = bits(5) + 257;
+		const unsigned int distance_count = bits(5) + 1;
+		const unsigned int length_count = bits(4) + 4;
+
+		uint8_t lengths[286 + 30] = { };
+
+		for (unsigned int i = 0; i < length_count; i++)
+		{
+			lengths[order[i]] = static_cast<uint8_t>(bits(3));
+		}
+
+		huffman length_codes;
+
+		if (literal_count > 286 || !build(length_codes, lengths, 19))
+		{
+			_error = true;
+			return;
+		}
+
+		for (unsigned int i = 0; i < literal_count + distance_count && !_error;)
+		{
+			const int symbol = decode(length_codes);
+
+			if (symbol < 16)
+			{
+				lengths[i++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+
+			uint8_t value = 0;
+			unsigned int repeat = 0;
+
+			if (symbol == 16)
+			{
+				if (i == 0)
+				{
+					_error = true;
+					return;
+				}
+
+				value = lengths[i - 1];
+				repeat = 3 + bits(2);
+			}
+			else
+			{
+				repeat = symbol == 17 ? 3 + bits(3) : 11 + bits(7);
+			}
+
+			if (i + repeat > literal_count + distance_count)
+			{
+				_error = true;
+				return;
+			}
+
+			while (repeat-- != 0)
+			{
+				lengths[i++] = value;
+			}
+		}
+
+		huffman literals, distances;
+
+		if (_error || !build(literals, lengths, literal_count) || !build(distances, lengths + literal_count, distance_count))
+		{
+			_error = true;
+			return;
+		}
+
+		codes(output, literals, distances);
+	}
+	void codes(std::vector<uint8_t> &output, const huffman &literals, const huffman &distances)
+	{
+		static const uint16_t length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		static const uint8_t length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		static const uint16_t distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		static const uint8_t distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+		while (!_error)
+		{
+			const int symbol = decode(literals);
+
+			if (symbol < 0 || symbol == 256)
+			{
+				break;
+			}
+			if (symbol < 256)
+			{
+				output.push_back(static_cast<uint8_t>(symbol));
+				continue;
+			}
+			if (symbol > 285)
+			{
+				_error = true;
+				break;
+			}
+
+			const size_t length = length_base[symbol - 257] + bits(length_extra[symbol - 257]);
+			const int distance_symbol = decode(distances);
+
+			if (distance_symbol < 0 || distance_symbol > 29)
+			{
+				_error = true;
+				break;
+			}
+
+			const size_t distance = distance_base[distance_symbol] + bits(distance_extra[distance_symbol]);
+
+			if (distance > output.size())
+			{
+				_error = true;
+				break;
+			}
+
+			for (size_t i = 0; i < length; i++)
+			{
+				output.push_back(output[output.size() - distance]);
+			}
+		}
+	}
+
+	const uint8_t *_data;
+	size_t _size, _position = 0;
+	unsigned int _bit_buffer = 0, _bit_count = 0;
+	bool _error = false;
+};
+
+// Decodes a zlib stream and verifies its header and checksum
+static bool decompress(const std::vector<uint8_t> &stream, std::vector<uint8_t> &output)
+{
+	if (stream.size() < 6 || (stream[0] & 0xF) != 8 || (stream[0] << 8 | stream[1]) % 31 != 0 || (stream[1] & 0x20) != 0)
+	{
+		return false;
+	}
+
+	inflater inflater(stream.data() + 2, stream.size() - 2);
+
+	if (!inflater.inflate(output) || inflater.consumed() + 2 + 4 != stream.size())
+	{
+		return false;
+	}
+
+	return read_u32(stream.data() + stream.size() - 4) == reference_adler32(output);
+}
+
+static uint8_t paeth(int a, int b, int c)
+{
+	const int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+	return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+struct decoded_png
+{
+	unsigned int width = 0, height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+// Parses a PNG file, checking the CRC of every chunk, joins the IDAT chunks, decompresses them and reverses the row filters
+static bool decode_png(const std::vector<uint8_t> &file, decoded_png &image)
+{
+	const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	if (file.size() < 8 || !std::equal(signature, signature + 8, file.begin()))
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> stream;
+	bool has_header = false, has_end = false;
+
+	for (size_t offset = 8; offset < file.size();)
+	{
+		if (has_end || file.size() - offset < 12)
+		{
+			return false;
+		}
+
+		const uint32_t size = read_u32(file.data() + offset);
+		const std::string type(reinterpret_cast<const char *>(file.data() + offset + 4), 4);
+
+		if (file.size() - offset - 12 < size ||
+			read_u32(file.data() + offset + 8 + size) != reference_crc32(file.data() + offset + 4, size + 4))
+		{
+			return false;
+		}
+
+		const uint8_t *const data = file.data() + offset + 8;
+
+		if (type == "IHDR")
+		{
+			// 8 bits per channel RGBA, deflate, adaptive filtering, no interlacing
+			if (has_header || size != 13 || data[8] != 8 || data[9] != 6 || data[10] != 0 || data[11] != 0 || data[12] != 0)
+			{
+				return false;
+			}
+
+			image.width = read_u32(data);
+			image.height = read_u32(data + 4);
+			has_header = true;
+		}
+		else if (type == "IDAT")
+		{
+			stream.insert(stream.end(), data, data + size);
+		}
+		else if (type == "IEND")
+		{
+			has_end = true;
+		}
+
+		offset += 12 + size;
+	}
+
+	std::vector<uint8_t> filtered;
+
+	if (!has_header || !has_end || !decompress(stream, filtered))
+	{
+		return false;
+	}
+
+	const size_t pitch = static_cast<size_t>(image.width) * 4;
+
+	if (filtered.size() != image.height * (1 + pitch))
+	{
+		return false;
+	}
+
+	image.pixels.resize(image.height * pitch);
+
+	for (size_t y = 0; y < image.height; y++)
+	{
+		const uint8_t filter = filtered[y * (1 + pitch)];
+		const uint8_t *const source = filtered.data() + y * (1 + pitch) + 1;
+		uint8_t *const row = image.pixels.data() + y * pitch;
+		const uint8_t *const prev_row = y != 0 ? row - pitch : nullptr;
+
+		for (size_t x = 0; x < pitch; x++)
+		{
+			const int a = x >= 4 ? row[x - 4] : 0;
+			const int b = prev_row != nullptr ? prev_row[x] : 0;
+			const int c = x >= 4 && prev_row != nullptr ? prev_row[x - 4] : 0;
+
+			switch (filter)
+			{
+			case 0:
+				row[x] = source[x];
+				break;
+			case 1:
+				row[x] = static_cast<uint8_t>(source[x] + a);
+				break;
+			case 2:
+				row[x] = static_cast<uint8_t>(source[x] + b);
+				break;
+			case 3:
+				row[x] = static_cast<uint8_t>(source[x] + ((a + b) >> 1));
+				break;
+			case 4:
+				row[x] = static_cast<uint8_t>(source[x] + paeth(a, b, c));
+				break;
+			default:
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Fills bands of rows with content that exercises every filter and both short and long matches: noise, gradients, solid color and copies of rows further up
+static std::vector<uint8_t> make_image(unsigned int width, unsigned int height, unsigned int seed)
+{
+	const size_t pitch = static_cast<size_t>(width) * 4;
+	std::vector<uint8_t> pixels(height * pitch);
+	std::mt19937 random(seed);
+
+	for (size_t y = 0; y < height; y++)
+	{
+		uint8_t *const row = pixels.data() + y * pitch;
+
+		switch ((y / 7 + seed) % 5)
+		{
+		case 0:
+			for (size_t x = 0; x < pitch; x++)
+				row[x] = static_cast<uint8_t>(random());
+			break;
+		case 1:
+			for (size_t x = 0; x < pitch; x++)
+				row[x] = static_cast<uint8_t>(x / 4 + y * (x % 4 + 1));
+			break;
+		case 2:
+			for (size_t x = 0; x < pitch; x++)
+				row[x] = static_cast<uint8_t>(x % 4 == 3 ? 255 : y);
+			break;
+		case 3:
+			for (size_t x = 0; x < pitch; x++)
+				row[x] = y >= 40 ? row[x - 40 * pitch] : 0;
+			break;
+		case 4:
+			for (size_t x = 0; x < pitch; x++)
+				row[x] = static_cast<uint8_t>(x % 16 < 8 ? random() % 4 : 128);
+			break;
+		}
+	}
+
+	return pixels;
+}
+
+// Encodes an image through a temporary file, filtering and compressing the stripes back to front to make sure none depends on work for a later stripe being done
+static std::vector<uint8_t> encode(const std::vector<uint8_t> &pixels, unsigned int width, unsigned int height, size_t max_stripes, size_t &stripe_count)
+{
+	reshade::png_encoder encoder(pixels.data(), width, height, max_stripes);
+	stripe_count = encoder.stripe_count();
+
+	for (size_t i = stripe_count; i-- != 0;)
+	{
+		encoder.filter_stripe(i);
+	}
+	for (size_t i = stripe_count; i-- != 0;)
+	{
+		encoder.compress_stripe(i);
+	}
+
+	std::vector<uint8_t> file_data;
+	FILE *const file = std::tmpfile();
+
+	if (file == nullptr)
+	{
+		return file_data;
+	}
+
+	if (encoder.write(file))
+	{
+		file_data.resize(static_cast<size_t>(std::ftell(file)));
+		std::rewind(file);
+		file_data.resize(std::fread(file_data.data(), 1, file_data.size(), file));
+	}
+
+	std::fclose(file);
+
+	return file_data;
+}
+
+static void test_inflater()
+{
+	// Streams produced by zlib, so that a bug in the decoder cannot cancel out one in the encoder
+	const std::vector<uint8_t> stored = { 0x78, 0x01, 0x01, 0x06, 0x00, 0xF9, 0xFF, 0x73, 0x74, 0x6F, 0x72, 0x65, 0x64, 0x09, 0x3C, 0x02, 0x92 };
+	const std::vector<uint8_t> dynamic = {
+		0x78, 0xDA, 0x35, 0xD1, 0x47, 0x8E, 0x85, 0x30, 0x14, 0x04, 0xC0, 0xB3, 0xDA, 0xC6, 0xE4, 0x9C, 0xE1, 0xF4, 0x33, 0x25, 0x7D, 0x56, 0xAD, 0x7E, 0x5D, 0x62, 0x61, 0x42, 0xCC, 0x29, 0xB5, 0x31,
+		0xC4, 0xBC, 0xA5, 0x2C, 0x52, 0xCA, 0x9D, 0xD8, 0xB5, 0xF4, 0xDF, 0x62, 0xEF, 0x78, 0xD8, 0x0A, 0x64, 0x40, 0x4E, 0x24, 0x23, 0x23, 0x72, 0x21, 0x25, 0x32, 0x21, 0x37, 0x52, 0x21, 0x33, 0xF2,
+		0x20, 0x35, 0xB2, 0x20, 0x2F, 0xD2, 0x20, 0x2B, 0x12, 0x90, 0x16, 0xD9, 0x90, 0x88, 0x74, 0xC8, 0x8E, 0x24, 0xA4, 0x47, 0x0E, 0xA4, 0x40, 0x06, 0xE4, 0x44, 0x32, 0x32, 0x22, 0x17, 0x52, 0x22,
+		0x13, 0x72, 0x23, 0x15, 0x32, 0x23, 0x0F, 0x52, 0x23, 0x0B, 0xF2, 0x22, 0x0D, 0xB2, 0x22, 0x01, 0x69, 0x91, 0x0D, 0x89, 0x48, 0x87, 0xEC, 0xBF, 0x07, 0x89, 0xA1, 0x17, 0x87, 0x56, 0x20, 0x83,
+		0xE3, 0xF9, 0xDB, 0x62, 0x1E, 0xC5, 0xA5, 0x95, 0xC8, 0xE4, 0x78, 0xDB, 0x2A, 0x64, 0x46, 0x1E, 0xA4, 0x46, 0x16, 0xE4, 0x45, 0x1A, 0x64, 0x45, 0x02, 0xD2, 0x22, 0xDB, 0xF7, 0xCD, 0xD4, 0x89,
+		0x5D, 0x4B, 0x48, 0xEF, 0x78, 0xD8, 0x0A, 0x64, 0x40, 0xCE, 0xEF, 0x8F, 0xC5, 0x51, 0x5C, 0x5A, 0x89, 0x4C, 0x8E, 0xB7, 0xAD, 0x42, 0x66, 0xE4, 0x41, 0x6A, 0x64, 0x41, 0x5E, 0xA4, 0x41, 0x56,
+		0x24, 0x20, 0x2D, 0xB2, 0x21, 0x11, 0xE9, 0x90, 0xFD, 0x7B, 0x82, 0xD8, 0x8B, 0x43, 0x2B, 0x90, 0xC1, 0xF1, 0xB4, 0x65, 0x64, 0x44, 0x2E, 0xA4, 0x44, 0xFE, 0x00, 0x10, 0x26, 0xEC, 0xD8 };
+
+	std::vector<uint8_t> output;
+	CHECK(decompress(stored, output));
+	CHECK(std::string(output.begin(), output.end()) == "stored");
+
+	std::vector<uint8_t> expected;
+	for (unsigned int i = 0; i < 600; i++)
+		expected.push_back(static_cast<uint8_t>(i % 5 != 0 ? 'a' + (i * i) % 7 : 'a' + (i * 7) % 26));
+
+	output.clear();
+	CHECK(decompress(dynamic, output));
+	CHECK(output == expected);
+
+	// A wrong checksum is noticed
+	std::vector<uint8_t> corrupt = stored;
+	corrupt.back() ^= 1;
+	output.clear();
+	CHECK(!decompress(corrupt, output));
+}
+
+static void test_round_trip(unsigned int width, unsigned int height, size_t max_stripes, size_t expected_stripes)
+{
+	const std::vector<uint8_t> pixels = make_image(width, height, width + height);
+
+	size_t stripe_count = 0;
+	const std::vector<uint8_t> file = encode(pixels, width, height, max_stripes, stripe_count);
+
+	CHECK(stripe_count == expected_stripes);
+
+	decoded_png image;
+	const bool decoded = decode_png(file, image);
+
+	if (!decoded)
+	{
+		std::printf("%ux%u image with %zu stripes could not be decoded\n", width, height, stripe_count);
+	}
+
+	CHECK(decoded);
+	CHECK(image.width == width);
+	CHECK(image.height == height);
+	CHECK(image.pixels == pixels);
+}
+
+int main()
+{
+	test_inflater();
+
+	test_round_trip(1, 1, 1, 1);
+	test_round_trip(1, 1, 8, 1);
+	// Heights that are not a multiple of the stripe height leave a shorter last stripe
+	test_round_trip(7, 5, 4, 1);
+	test_round_trip(33, 100, 6, 6);
+	test_round_trip(61, 333, 5, 5);
+	// Stripes much shorter than the window, so that the dictionary of one has to be collected from several in front of it
+	test_round_trip(1, 999, 50, 50);
+	test_round_trip(3, 257, 16, 16);
+	test_round_trip(1920, 1080, 1, 1);
+	test_round_trip(1920, 1080, 7, 7);
+
+	if (s_failures != 0)
+	{
+		std::printf("%u checks failed\n", s_failures);
+		return 1;
+	}
+
+	std::printf("all checks passed\n");
+}
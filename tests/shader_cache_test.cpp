@@ -0,0 +1,276 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Tests the key and eviction logic of the shader cache against an in-memory storage and a fake compiler.
+//
+// cl /std:c++17 /EHsc /I source tests\shader_cache_test.cpp source\shader_cache.cpp source\cache_index.cpp
+// g++ -std=c++17 -I source tests/shader_cache_test.cpp source/shader_cache.cpp source/cache_index.cpp
+
+#include "shader_cache.hpp"
+#include <map>
+#include <cstdio>
+
+static unsigned int s_failures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { std::printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); s_failures++; }
+
+// The contents of a cache directory, which outlive the storage instances that access it
+struct memory_disk
+{
+	std::map<uint64_t, std::string> entries;
+	std::string order;
+};
+
+struct memory_storage : reshade::shader_cache::storage
+{
+	explicit memory_storage(memory_disk &disk) : disk(disk) { }
+
+	std::vector<std::pair<uint64_t, size_t>> list() override
+	{
+		std::vector<std::pair<uint64_t, size_t>> result;
+
+		for (const auto &entry : disk.entries)
+		{
+			result.emplace_back(entry.first, entry.second.size());
+		}
+
+		return result;
+	}
+	bool read(uint64_t key, std::string &data) override
+	{
+		const auto it = disk.entries.find(key);
+
+		if (it == disk.entries.end())
+		{
+			return false;
+		}
+
+		data = it->second;
+
+		return true;
+	}
+	bool write(uint64_t key, const std::string &data) override
+	{
+		disk.entries[key] = data;
+		return true;
+	}
+	void remove(uint64_t key) override
+	{
+		disk.entries.erase(key);
+	}
+	bool read_order(std::string &data) override
+	{
+		data = disk.order;
+		return !disk.order.empty();
+	}
+	void write_order(const std::string &data) override
+	{
+		disk.order = data;
+	}
+
+	memory_disk &disk;
+};
+
+static uint64_t key_of(const std::string &source)
+{
+	return reshade::shader_cache::key("1.0", source, "main", "ps_5_0", 0);
+}
+
+// Counts how often it is invoked and produces bytecode derived from the source, so that mixed up entries are noticed
+struct fake_compiler
+{
+	unsigned int calls = 0;
+
+	bool compile(reshade::shader_cache &cache, const std::string &source, std::string &bytecode, std::string &errors, const std::string &version = "1.0", unsigned int flags = 0)
+	{
+		return cache.compile(version, source, "main", "ps_5_0", flags, bytecode, errors, [this, &source](std::string &result, std::string &messages) {
+			calls++;
+
+			if (source.find("error") != std::string::npos)
+			{
+				messages = "error X3000: syntax error\n";
+				return false;
+			}
+
+			result = "bytecode of " + source;
+			messages = "warning X3206: implicit truncation\n";
+
+			return true;
+		});
+	}
+};
+
+static void test_key()
+{
+	using reshade::shader_cache;
+
+	const uint64_t key = shader_cache::key("1.0", "source", "main", "ps_5_0", 0);
+
+	CHECK(key == shader_cache::key("1.0", "source", "main", "ps_5_0", 0));
+	CHECK(key != shader_cache::key("1.1", "source", "main", "ps_5_0", 0));
+	CHECK(key != shader_cache::key("1.0", "source2", "main", "ps_5_0", 0));
+	CHECK(key != shader_cache::key("1.0", "source", "main2", "ps_5_0", 0));
+	CHECK(key != shader_cache::key("1.0", "source", "main", "vs_5_0", 0));
+	CHECK(key != shader_cache::key("1.0", "source", "main", "ps_5_0", 1));
+	// The separators keep strings from running into each other
+	CHECK(shader_cache::key("1.0", "source", "ab", "c", 0) != shader_cache::key("1.0", "source", "a", "bc", 0));
+}
+
+static void test_hit_and_miss()
+{
+	reshade::shader_cache cache;
+	fake_compiler compiler;
+	std::string bytecode, errors;
+
+	// Without a storage every request compiles
+	CHECK(compiler.compile(cache, "a", bytecode, errors));
+	CHECK(compiler.compile(cache, "a", bytecode, errors));
+	CHECK(compiler.calls == 2);
+
+	memory_disk disk;
+	cache.set_storage(std::make_unique<memory_storage>(disk));
+	compiler.calls = 0;
+
+	bytecode.clear();
+	errors.clear();
+	CHECK(compiler.compile(cache, "a", bytecode, errors));
+	CHECK(compiler.calls == 1);
+	CHECK(bytecode == "bytecode of a");
+	CHECK(disk.entries.size() == 1);
+
+	// A hit returns the same bytecode and warnings without calling the compiler
+	bytecode.clear();
+	errors.clear();
+	CHECK(compiler.compile(cache, "a", bytecode, errors));
+	CHECK(compiler.calls == 1);
+	CHECK(bytecode == "bytecode of a");
+	CHECK(errors == "warning X3206: implicit truncation\n");
+
+	// A different compiler version or different flags must not reuse the entry
+	CHECK(compiler.compile(cache, "a", bytecode, errors, "1.1"));
+	CHECK(compiler.calls == 2);
+	CHECK(compiler.compile(cache, "a", bytecode, errors, "1.0", 1));
+	CHECK(compiler.calls == 3);
+
+	// Failures are reported every time and never cached
+	errors.clear();
+	CHECK(!compiler.compile(cache, "error", bytecode, errors));
+	CHECK(!compiler.compile(cache, "error", bytecode, errors));
+	CHECK(compiler.calls == 5);
+	CHECK(errors == "error X3000: syntax error\nerror X3000: syntax error\n");
+	CHECK(disk.entries.size() == 3);
+}
+
+static void test_corrupt_entry()
+{
+	reshade::shader_cache cache;
+	fake_compiler compiler;
+	std::string bytecode, errors;
+
+	memory_disk disk;
+	cache.set_storage(std::make_unique<memory_storage>(disk));
+
+	CHECK(compiler.compile(cache, "a", bytecode, errors));
+
+	for (auto &entry : disk.entries)
+	{
+		entry.second.resize(entry.second.size() - 4);
+	}
+
+	bytecode.clear();
+	CHECK(compiler.compile(cache, "a", bytecode, errors));
+	CHECK(compiler.calls == 2);
+	CHECK(bytecode == "bytecode of a");
+}
+
+static void test_eviction()
+{
+	reshade::shader_cache cache;
+	fake_compiler compiler;
+	std::string bytecode, errors;
+
+	memory_disk disk;
+	cache.set_storage(std::make_unique<memory_storage>(disk));
+
+	CHECK(compiler.compile(cache, "a", bytecode, errors));
+	const size_t entry_size = disk.entries.begin()->second.size();
+	cache.set_size_limit(3 * entry_size);
+
+	CHECK(compiler.compile(cache, "b", bytecode, errors));
+	CHECK(compiler.compile(cache, "c", bytecode, errors));
+	// Use "a" again, so that "b" is now the least recently used entry
+	CHECK(compiler.compile(cache, "a", bytecode, errors));
+	CHECK(compiler.calls == 3);
+
+	CHECK(compiler.compile(cache, "d", bytecode, errors));
+	CHECK(disk.entries.size() == 3);
+	CHECK(disk.entries.count(key_of("b")) == 0);
+
+	CHECK(compiler.compile(cache, "a", bytecode, errors));
+	CHECK(compiler.compile(cache, "c", bytecode, errors));
+	CHECK(compiler.compile(cache, "d", bytecode, errors));
+	CHECK(compiler.calls == 4);
+	CHECK(compiler.compile(cache, "b", bytecode, errors));
+	CHECK(compiler.calls == 5);
+
+	// Lowering the limit evicts immediately, but always keeps the most recent entry
+	cache.set_size_limit(0);
+	CHECK(disk.entries.size() == 1);
+	CHECK(disk.entries.count(key_of("b")) == 1);
+}
+
+static void test_order_persistence()
+{
+	memory_disk disk;
+	fake_compiler compiler;
+	std::string bytecode, errors;
+
+	{
+		reshade::shader_cache cache;
+		cache.set_storage(std::make_unique<memory_storage>(disk));
+
+		CHECK(compiler.compile(cache, "a", bytecode, errors));
+		CHECK(compiler.compile(cache, "b", bytecode, errors));
+		CHECK(compiler.compile(cache, "c", bytecode, errors));
+		CHECK(compiler.compile(cache, "a", bytecode, errors));
+
+		cache.flush();
+	}
+
+	// The next run picks up all entries and evicts in the order of the previous one, which is "b" first, then "c"
+	const size_t entry_size = disk.entries.begin()->second.size();
+
+	reshade::shader_cache cache;
+	cache.set_size_limit(2 * entry_size);
+	cache.set_storage(std::make_unique<memory_storage>(disk));
+
+	CHECK(disk.entries.size() == 2);
+	CHECK(disk.entries.count(key_of("b")) == 0);
+
+	CHECK(compiler.compile(cache, "a", bytecode, errors));
+	CHECK(compiler.compile(cache, "c", bytecode, errors));
+	CHECK(compiler.calls == 3);
+
+	cache.set_size_limit(entry_size);
+	CHECK(disk.entries.count(key_of("c")) == 1);
+}
+
+int main()
+{
+	test_key();
+	test_hit_and_miss();
+	test_corrupt_entry();
+	test_eviction();
+	test_order_persistence();
+
+	if (s_failures != 0)
+	{
+		std::printf("%u checks failed\n", s_failures);
+		return 1;
+	}
+
+	std::printf("all checks passed\n");
+}
@@ -0,0 +1,328 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Tests the key, validation and eviction logic of the texture cache against an in-memory storage, also with several threads loading and saving at once.
+//
+// cl /std:c++17 /EHsc /I source tests\texture_cache_test.cpp source\texture_cache.cpp source\cache_index.cpp
+// g++ -std=c++17 -pthread -I source tests/texture_cache_test.cpp source/texture_cache.cpp source/cache_index.cpp
+
+#include "texture_cache.hpp"
+#include <map>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+
+static unsigned int s_failures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { std::printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); s_failures++; }
+
+// The contents of a cache directory, which outlive the storage instances that access it
+struct memory_disk
+{
+	std::mutex mutex;
+	std::map<uint64_t, std::string> entries;
+	std::string order;
+};
+
+struct memory_storage : reshade::texture_cache::storage
+{
+	explicit memory_storage(memory_disk &disk) : disk(disk) { }
+
+	std::vector<std::pair<uint64_t, size_t>> list() override
+	{
+		const std::lock_guard<std::mutex> lock(disk.mutex);
+
+		std::vector<std::pair<uint64_t, size_t>> result;
+
+		for (const auto &entry : disk.entries)
+		{
+			result.emplace_back(entry.first, entry.second.size());
+		}
+
+		return result;
+	}
+	bool read(uint64_t key, void *header, size_t header_size, void *data, size_t size) override
+	{
+		const std::lock_guard<std::mutex> lock(disk.mutex);
+
+		const auto it = disk.entries.find(key);
+
+		if (it == disk.entries.end() || it->second.size() < header_size + size)
+		{
+			return false;
+		}
+
+		std::memcpy(header, it->second.data(), header_size);
+		std::memcpy(data, it->second.data() + header_size, size);
+
+		return true;
+	}
+	bool write(uint64_t key, const void *header, size_t header_size, const void *data, size_t size) override
+	{
+		std::string entry(static_cast<const char *>(header), header_size);
+		entry.append(static_cast<const char *>(data), size);
+
+		const std::lock_guard<std::mutex> lock(disk.mutex);
+
+		disk.entries[key] = std::move(entry);
+
+		return true;
+	}
+	void remove(uint64_t key) override
+	{
+		const std::lock_guard<std::mutex> lock(disk.mutex);
+
+		disk.entries.erase(key);
+	}
+	bool read_order(std::string &data) override
+	{
+		data = disk.order;
+		return !disk.order.empty();
+	}
+	void write_order(const std::string &data) override
+	{
+		disk.order = data;
+	}
+
+	memory_disk &disk;
+};
+
+// An image whose pixels are derived from its key, so that mixed up entries are noticed
+static std::vector<uint8_t> make_image(uint64_t key, unsigned int width, unsigned int height)
+{
+	std::vector<uint8_t> data(static_cast<size_t>(width) * height * 4);
+
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		data[i] = static_cast<uint8_t>(key * 31 + i);
+	}
+
+	return data;
+}
+
+static uint64_t key_of(const char *filedata)
+{
+	return reshade::texture_cache::key(std::vector<uint8_t>(filedata, filedata + std::strlen(filedata)), 4, 4);
+}
+
+// Stores the image for a key with the source dimensions the cache has to return on a hit
+static void save(reshade::texture_cache &cache, uint64_t key)
+{
+	cache.save(key, 4, 4, 16, 8, make_image(key, 4, 4));
+}
+static bool load(reshade::texture_cache &cache, uint64_t key)
+{
+	std::vector<uint8_t> data;
+	unsigned int source_width = 0, source_height = 0;
+
+	return cache.load(key, 4, 4, data, source_width, source_height) && data == make_image(key, 4, 4) && source_width == 16 && source_height == 8;
+}
+
+static void test_key()
+{
+	using reshade::texture_cache;
+
+	const std::vector<uint8_t> filedata = { 1, 2, 3 }, other_filedata = { 1, 2, 4 };
+	const uint64_t key = texture_cache::key(filedata, 256, 128);
+
+	CHECK(key == texture_cache::key(filedata, 256, 128));
+	CHECK(key != texture_cache::key(other_filedata, 256, 128));
+	CHECK(key != texture_cache::key(filedata, 128, 256));
+	CHECK(key != texture_cache::key(filedata, 256, 256));
+}
+
+static void test_hit_and_miss()
+{
+	reshade::texture_cache cache;
+	const uint64_t key = key_of("a");
+
+	// Without a storage nothing is cached
+	save(cache, key);
+	CHECK(!load(cache, key));
+
+	memory_disk disk;
+	cache.set_storage(std::make_unique<memory_storage>(disk));
+	cache.reset_statistics();
+
+	CHECK(!load(cache, key));
+	save(cache, key);
+	CHECK(disk.entries.size() == 1);
+
+	// A hit returns the same image data and the dimensions of the source image
+	CHECK(load(cache, key));
+	CHECK(load(cache, key));
+	CHECK(cache.hits() == 2);
+	CHECK(cache.misses() == 1);
+
+	// An entry is only valid for the dimensions it was saved with
+	std::vector<uint8_t> data;
+	unsigned int source_width = 0, source_height = 0;
+	CHECK(!cache.load(key, 8, 2, data, source_width, source_height));
+	CHECK(cache.misses() == 2);
+}
+
+static void test_corrupt_entry()
+{
+	reshade::texture_cache cache;
+	memory_disk disk;
+	cache.set_storage(std::make_unique<memory_storage>(disk));
+
+	save(cache, key_of("a"));
+	const size_t entry_size = disk.entries.begin()->second.size();
+	cache.set_size_limit(2 * entry_size);
+
+	save(cache, key_of("b"));
+
+	// A short read of the image data makes the entry a miss and the cache forgets about it, so it no longer counts towards the size limit
+	disk.entries[key_of("b")].resize(entry_size - 4);
+	CHECK(!load(cache, key_of("b")));
+
+	save(cache, key_of("c"));
+	CHECK(disk.entries.count(key_of("a")) == 1);
+	CHECK(disk.entries.count(key_of("c")) == 1);
+
+	// The same goes for a header that does not match
+	disk.entries[key_of("c")][0] ^= 1;
+	CHECK(!load(cache, key_of("c")));
+
+	save(cache, key_of("d"));
+	CHECK(disk.entries.count(key_of("a")) == 1);
+	CHECK(disk.entries.count(key_of("d")) == 1);
+
+	// Saving again replaces the unusable entry
+	save(cache, key_of("b"));
+	CHECK(load(cache, key_of("b")));
+}
+
+static void test_eviction()
+{
+	reshade::texture_cache cache;
+	memory_disk disk;
+	cache.set_storage(std::make_unique<memory_storage>(disk));
+
+	save(cache, key_of("a"));
+	const size_t entry_size = disk.entries.begin()->second.size();
+	cache.set_size_limit(3 * entry_size);
+
+	save(cache, key_of("b"));
+	save(cache, key_of("c"));
+	// Use "a" again, so that "b" is now the least recently used entry
+	CHECK(load(cache, key_of("a")));
+
+	save(cache, key_of("d"));
+	CHECK(disk.entries.size() == 3);
+	CHECK(disk.entries.count(key_of("b")) == 0);
+	CHECK(!load(cache, key_of("b")));
+	CHECK(load(cache, key_of("c")));
+
+	// Lowering the limit evicts immediately, but always keeps the most recent entry
+	cache.set_size_limit(0);
+	CHECK(disk.entries.size() == 1);
+	CHECK(disk.entries.count(key_of("c")) == 1);
+}
+
+static void test_order_persistence()
+{
+	memory_disk disk;
+
+	{
+		reshade::texture_cache cache;
+		cache.set_storage(std::make_unique<memory_storage>(disk));
+
+		save(cache, key_of("a"));
+		save(cache, key_of("b"));
+		save(cache, key_of("c"));
+		CHECK(load(cache, key_of("a")));
+
+		cache.flush();
+	}
+
+	// The next run picks up all entries and evicts in the order of the previous one, which is "b" first, then "c"
+	const size_t entry_size = disk.entries.begin()->second.size();
+
+	reshade::texture_cache cache;
+	cache.set_size_limit(2 * entry_size);
+	cache.set_storage(std::make_unique<memory_storage>(disk));
+
+	CHECK(disk.entries.size() == 2);
+	CHECK(disk.entries.count(key_of("b")) == 0);
+
+	CHECK(load(cache, key_of("a")));
+	CHECK(load(cache, key_of("c")));
+
+	cache.set_size_limit(entry_size);
+	CHECK(disk.entries.count(key_of("c")) == 1);
+}
+
+static void test_concurrent_use()
+{
+	reshade::texture_cache cache;
+	memory_disk disk;
+	cache.set_storage(std::make_unique<memory_storage>(disk));
+
+	save(cache, 0);
+	const size_t entry_size = disk.entries.begin()->second.size();
+	cache.set_size_limit(128 * entry_size);
+	cache.reset_statistics();
+
+	// Like the texture loading threads, every thread loads its images and saves those that were missing, half of the images are shared between all threads
+	std::atomic<unsigned int> wrong = 0;
+	std::vector<std::thread> threads;
+
+	for (unsigned int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&cache, &wrong, t]() {
+			for (unsigned int round = 0; round < 2; round++)
+			{
+				for (uint64_t i = 0; i < 40; i++)
+				{
+					const uint64_t key = i % 2 == 0 ? i : i + 1000 * (t + 1);
+
+					std::vector<uint8_t> data;
+					unsigned int source_width = 0, source_height = 0;
+
+					if (!cache.load(key, 4, 4, data, source_width, source_height))
+					{
+						save(cache, key);
+					}
+					else if (data != make_image(key, 4, 4) || source_width != 16 || source_height != 8)
+					{
+						wrong++;
+					}
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	CHECK(wrong == 0);
+	CHECK(cache.hits() + cache.misses() == 4 * 2 * 40);
+	// Every image fits, so the second round of every thread only hits
+	CHECK(cache.misses() <= 4 * 40);
+	CHECK(disk.entries.size() == 20 + 4 * 20);
+}
+
+int main()
+{
+	test_key();
+	test_hit_and_miss();
+	test_corrupt_entry();
+	test_eviction();
+	test_order_persistence();
+	test_concurrent_use();
+
+	if (s_failures != 0)
+	{
+		std::printf("%u checks failed\n", s_failures);
+		return 1;
+	}
+
+	std::printf("all checks passed\n");
+}
@@ -0,0 +1,233 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Tests the uniform packer against known HLSL constant buffer, GLSL std140 and Direct3D 9 register layouts.
+//
+// cl /std:c++17 /EHsc /I source tests\uniform_layout_test.cpp source\uniform_layout.cpp
+// g++ -std=c++17 -I source tests/uniform_layout_test.cpp source/uniform_layout.cpp
+
+#include "uniform_layout.hpp"
+#include <cstdio>
+
+static unsigned int s_failures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { std::printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); s_failures++; }
+
+using reshade::uniform_layout;
+
+struct uniform_desc
+{
+	unsigned int vector_size, vector_count, elements;
+};
+
+// The bytes a uniform occupies in the buffer, without the padding between array elements and matrix vectors
+static size_t data_size(const uniform_desc &desc)
+{
+	return desc.vector_size * desc.vector_count * (desc.elements != 0 ? desc.elements : 1) * 4;
+}
+// The bytes from the start of a uniform to the end of the last component it occupies
+static size_t extent(const uniform_desc &desc, uniform_layout::packing_rules rules)
+{
+	const size_t registers = desc.vector_count * (desc.elements != 0 ? desc.elements : 1);
+
+	if (registers == 1 && rules != uniform_layout::packing_rules::d3d9_registers)
+	{
+		return desc.vector_size * 4;
+	}
+
+	return rules == uniform_layout::packing_rules::hlsl_cbuffer ? (registers - 1) * 16 + desc.vector_size * 4 : registers * 16;
+}
+
+// Checks the rules of the shading language independently of the placement strategy
+static void check_rules(const uniform_layout &layout, uniform_layout::packing_rules rules, const uniform_desc *descs, size_t count)
+{
+	size_t total_data_size = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const uniform_desc &desc = descs[i];
+		const size_t offset = layout.offset(i);
+		const bool is_aggregate = desc.elements != 0 || desc.vector_count > 1;
+
+		total_data_size += data_size(desc);
+
+		CHECK(offset % 4 == 0);
+		CHECK(offset + extent(desc, rules) <= layout.size());
+
+		switch (rules)
+		{
+		case uniform_layout::packing_rules::hlsl_cbuffer:
+			if (is_aggregate)
+			{
+				CHECK(offset % 16 == 0);
+			}
+			else
+			{
+				CHECK(offset / 16 == (offset + desc.vector_size * 4 - 1) / 16);
+			}
+			break;
+		case uniform_layout::packing_rules::std140:
+			if (is_aggregate || desc.vector_size >= 3)
+			{
+				CHECK(offset % 16 == 0);
+			}
+			else
+			{
+				CHECK(offset % (desc.vector_size * 4) == 0);
+			}
+			break;
+		case uniform_layout::packing_rules::d3d9_registers:
+			CHECK(offset % 16 == 0);
+			break;
+		}
+
+		// Members may not overlap
+		for (size_t k = 0; k < i; k++)
+		{
+			const size_t other_offset = layout.offset(k);
+
+			CHECK(offset + extent(desc, rules) <= other_offset || other_offset + extent(descs[k], rules) <= offset);
+		}
+	}
+
+	CHECK(layout.size() % 16 == 0);
+	CHECK(layout.padding() == layout.size() - total_data_size);
+
+	const std::vector<size_t> &order = layout.order();
+
+	CHECK(order.size() == count);
+
+	for (size_t i = 1; i < order.size(); i++)
+	{
+		CHECK(layout.offset(order[i - 1]) <= layout.offset(order[i]));
+	}
+}
+
+static uniform_layout pack(uniform_layout::packing_rules rules, const uniform_desc *descs, size_t count)
+{
+	uniform_layout layout(rules);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		CHECK(layout.add(descs[i].vector_size, descs[i].vector_count, descs[i].elements) == i);
+	}
+
+	layout.pack();
+
+	check_rules(layout, rules, descs, count);
+
+	return layout;
+}
+
+// float a; float3 b; float2 c; float d; float4x4 e; float2 f[3];
+static const uniform_desc s_mixed[] = { { 1, 1, 0 }, { 3, 1, 0 }, { 2, 1, 0 }, { 1, 1, 0 }, { 4, 4, 0 }, { 2, 1, 3 } };
+
+static void test_hlsl_cbuffer()
+{
+	const uniform_layout layout = pack(uniform_layout::packing_rules::hlsl_cbuffer, s_mixed, 6);
+
+	// The matrix takes c0-c3 and the array c4-c6, whose last element leaves eight bytes in c6 for the two-component vector
+	CHECK(layout.offset(4) == 0);
+	CHECK(layout.offset(5) == 64);
+	CHECK(layout.offset(2) == 104);
+	// The three-component vector starts c7 and a scalar fills the rest of it
+	CHECK(layout.offset(1) == 112);
+	CHECK(layout.offset(0) == 124);
+	CHECK(layout.offset(3) == 128);
+	CHECK(layout.size() == 144);
+	CHECK(layout.padding() == 28);
+
+	// float a; float b; float c; float3 d; float2 e; needs three registers in declaration order, but fits into two
+	const uniform_desc typical[] = { { 1, 1, 0 }, { 1, 1, 0 }, { 1, 1, 0 }, { 3, 1, 0 }, { 2, 1, 0 } };
+	const uniform_layout typical_layout = pack(uniform_layout::packing_rules::hlsl_cbuffer, typical, 5);
+
+	CHECK(typical_layout.size() == 32);
+	CHECK(typical_layout.padding() == 0);
+	CHECK(typical_layout.order().front() == 3);
+
+	// A single scalar still takes a whole register
+	const uniform_desc scalar[] = { { 1, 1, 0 } };
+	const uniform_layout scalar_layout = pack(uniform_layout::packing_rules::hlsl_cbuffer, scalar, 1);
+
+	CHECK(scalar_layout.offset(0) == 0);
+	CHECK(scalar_layout.size() == 16);
+	CHECK(scalar_layout.padding() == 12);
+}
+
+static void test_std140()
+{
+	const uniform_layout layout = pack(uniform_layout::packing_rules::std140, s_mixed, 6);
+
+	// Array elements are padded to 16 bytes, so the array takes all of 64-112 and nothing can use the end of it
+	CHECK(layout.offset(4) == 0);
+	CHECK(layout.offset(5) == 64);
+	CHECK(layout.offset(1) == 112);
+	CHECK(layout.offset(0) == 124);
+	// The two-component vector has to be eight byte aligned, so it cannot follow the three-component one
+	CHECK(layout.offset(2) == 128);
+	CHECK(layout.offset(3) == 136);
+	CHECK(layout.size() == 144);
+	CHECK(layout.padding() == 28);
+
+	// float a; vec2 b; float c; must not place the vector at offset 4
+	const uniform_desc unaligned[] = { { 1, 1, 0 }, { 2, 1, 0 }, { 1, 1, 0 } };
+	const uniform_layout unaligned_layout = pack(uniform_layout::packing_rules::std140, unaligned, 3);
+
+	CHECK(unaligned_layout.offset(1) == 0);
+	CHECK(unaligned_layout.size() == 16);
+}
+
+static void test_d3d9_registers()
+{
+	// float a; float3 b; float4x4 c;
+	const uniform_desc descs[] = { { 1, 1, 0 }, { 3, 1, 0 }, { 4, 4, 0 } };
+	const uniform_layout layout = pack(uniform_layout::packing_rules::d3d9_registers, descs, 3);
+
+	// Every member gets registers of its own, so nothing can share c4 with the scalar
+	CHECK(layout.offset(2) == 0);
+	CHECK(layout.offset(0) == 64);
+	CHECK(layout.offset(1) == 80);
+	CHECK(layout.size() == 96);
+	CHECK(layout.padding() == 16);
+
+	const uniform_layout mixed_layout = pack(uniform_layout::packing_rules::d3d9_registers, s_mixed, 6);
+
+	// Four registers for the matrix, three for the array and one for each of the four vectors
+	CHECK(mixed_layout.size() == 11 * 16);
+}
+
+static void test_repack()
+{
+	uniform_layout layout(uniform_layout::packing_rules::hlsl_cbuffer);
+	layout.add(4, 1, 0);
+	layout.pack();
+
+	CHECK(layout.size() == 16);
+
+	// Packing again after adding more uniforms starts over instead of appending to the previous result
+	layout.add(4, 1, 0);
+	layout.pack();
+
+	CHECK(layout.size() == 32);
+	CHECK(layout.padding() == 0);
+	CHECK(layout.offset(0) != layout.offset(1));
+}
+
+int main()
+{
+	test_hlsl_cbuffer();
+	test_std140();
+	test_d3d9_registers();
+	test_repack();
+
+	if (s_failures != 0)
+	{
+		std::printf("%u checks failed\n", s_failures);
+		return 1;
+	}
+
+	std::printf("all checks passed\n");
+}